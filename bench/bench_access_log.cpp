@@ -0,0 +1,129 @@
+#include "server/access_log.hpp"
+#include "server/logger.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Compares the cost request threads pay to note each request: the formatted
+// "Request processed" log line the server used to write, against a binary
+// access record. Both sinks are sized to keep every entry; the text lines go to
+// /dev/null and the records to a file in the temporary directory. Rates are
+// timed once the threads are done, which is what request threads see, and once
+// everything is written.
+// Usage: bench_access_log [requests_per_thread] [max_threads]
+
+struct Times
+{
+    double queued;
+    double written;
+    uint64_t dropped;
+};
+
+static const std::string uri = "/index.html?id=12345";
+
+static Times run_text(size_t threads, uint64_t requests_per_thread)
+{
+    FILE *output = std::fopen("/dev/null", "w");
+    LogPolicy policy;
+    policy.level = LogLevel::Debug;
+    policy.ring_lines = requests_per_thread;
+    std::vector<std::thread> producers;
+    Times times;
+
+    {
+        Logger logger(policy, output, output);
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t t = 0; t < threads; ++t)
+        {
+            producers.emplace_back([&logger, requests_per_thread]
+                                   {
+                                       for (uint64_t i = 0; i < requests_per_thread; ++i)
+                                           logger.debug() << "Request processed: " << 0 << " " << uri << " -> " << 200; });
+        }
+
+        for (auto &producer : producers)
+            producer.join();
+        times.queued = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        logger.flush();
+        times.written = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        times.dropped = logger.get_dropped_count();
+    }
+
+    std::fclose(output);
+    return times;
+}
+
+static Times run_records(size_t threads, uint64_t requests_per_thread)
+{
+    AccessLogPolicy policy;
+    policy.path = std::filesystem::temp_directory_path() / ("bench-access-log-" + std::to_string(getpid()));
+    policy.max_files = 0;
+    policy.queue_capacity = threads * requests_per_thread;
+    policy.max_file_size = AccessLogHeader::header_size + policy.queue_capacity * sizeof(AccessRecord);
+    PeerAddress peer;
+    peer.family = PeerFamily::IPv4;
+    std::vector<std::thread> producers;
+    Times times;
+
+    {
+        AccessLog log(policy);
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t t = 0; t < threads; ++t)
+        {
+            producers.emplace_back([&log, &peer, requests_per_thread]
+                                   {
+                                       for (uint64_t i = 0; i < requests_per_thread; ++i)
+                                       {
+                                           if (log.should_record(200))
+                                               log.record(HttpMethod::GET, uri, 200, 512, std::chrono::microseconds(80), peer);
+                                       } });
+        }
+
+        for (auto &producer : producers)
+            producer.join();
+        times.queued = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        log.flush();
+        times.written = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        times.dropped = log.get_dropped_count();
+    }
+
+    std::filesystem::remove(policy.path);
+    return times;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t requests_per_thread = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000;
+    size_t max_threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 16;
+
+#ifdef DEBUG
+    std::printf("warning: debug build, numbers are not representative\n");
+#endif
+
+    std::printf("%zu hardware threads, %llu requests per thread\n", static_cast<size_t>(std::thread::hardware_concurrency()),
+                static_cast<unsigned long long>(requests_per_thread));
+    std::printf("%-10s %16s %16s %16s %16s %10s %8s\n", "threads", "text queued/s", "text written/s",
+                "binary queued/s", "binary written/s", "speedup", "dropped");
+
+    for (size_t threads = 1; threads <= max_threads; threads *= 2)
+    {
+        double total = static_cast<double>(threads * requests_per_thread);
+        Times text = run_text(threads, requests_per_thread);
+        Times records = run_records(threads, requests_per_thread);
+
+        std::printf("%-10zu %16.0f %16.0f %16.0f %16.0f %9.2fx %8llu\n", threads, total / text.queued,
+                    total / text.written, total / records.queued, total / records.written,
+                    text.queued / records.queued, static_cast<unsigned long long>(text.dropped + records.dropped));
+    }
+
+    return 0;
+}
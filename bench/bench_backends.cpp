@@ -0,0 +1,99 @@
+#include "bench_client.hpp"
+#include "server/httpserver.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+// Compares requests/sec and tail latency of the I/O backends on one handler set.
+// Usage: bench_backends [duration_seconds] [connections] [io_threads]
+
+static Router make_router(HttpServer &server)
+{
+    Router router;
+
+    router.get("/plaintext", [](const HttpRequest &) -> HttpResponse
+               {
+                   HttpResponse response;
+                   response.add_header("Content-Type", "text/plain");
+                   response.set_body("Hello, World!");
+                   return response; });
+
+    router.get("/", [&server](const HttpRequest &) -> HttpResponse
+               { return server.serve_static_file("index.html"); });
+
+    return router;
+}
+
+static LoadResult bench_backend(const ServerConfig &config, const LoadOptions &base_options, const std::string &path)
+{
+    HttpServer server;
+    server.set_router(make_router(server));
+    server.set_config(config);
+
+    std::thread server_thread([&server]
+                              { server.run(0, 1024); });
+
+    while (!server.is_running())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    LoadOptions options = base_options;
+    options.port = server.get_port();
+    options.request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n" +
+                      (options.keep_alive ? "" : "Connection: close\r\n") + "\r\n";
+
+    LoadResult result = run_load(options);
+
+    server.stop();
+    server_thread.join();
+
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    LoadOptions options;
+    options.duration_seconds = argc > 1 ? std::atof(argv[1]) : 2.0;
+    options.connections = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 16;
+    size_t io_threads = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1;
+
+#ifdef DEBUG
+    std::printf("warning: debug build, numbers are not representative\n");
+#endif
+
+    std::vector<IoBackend> backends = {IoBackend::Blocking, IoBackend::Epoll};
+#ifdef HAS_IO_URING
+    backends.push_back(IoBackend::IoUring);
+#endif
+
+    for (const std::string path : {"/plaintext", "/"})
+    {
+        std::printf("\n%s, %zu connections, %.1fs\n", path.c_str(), options.connections, options.duration_seconds);
+        print_result_header();
+
+        for (bool keep_alive : {false, true})
+        {
+            options.keep_alive = keep_alive;
+
+            for (IoBackend backend : backends)
+            {
+                ServerConfig config;
+                // Results go through printf; keep the server to warnings and errors.
+                config.logging.level = LogLevel::Warning;
+                config.backend = backend;
+                config.io_threads = io_threads;
+
+                std::string name = io_backend_to_string(backend) + (keep_alive ? " keep-alive" : " close");
+                print_result(name, bench_backend(config, options, path));
+
+                if (backend == IoBackend::Blocking)
+                    continue;
+
+                config.reuse_port_shards = true;
+                print_result(name + " shards", bench_backend(config, options, path));
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,221 @@
+#ifndef BENCH_CLIENT_HPP
+#define BENCH_CLIENT_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+struct LoadOptions
+{
+    std::string host = "127.0.0.1";
+    int port = 8080;
+    std::string unix_path;
+    size_t connections = 8;
+    double duration_seconds = 2.0;
+    bool keep_alive = false;
+    bool fast_open = false;
+    std::string request = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+};
+
+struct LoadResult
+{
+    size_t requests = 0;
+    size_t errors = 0;
+    double seconds = 0.0;
+    std::vector<double> latencies_us;
+
+    double requests_per_second() const
+    {
+        return seconds > 0 ? requests / seconds : 0.0;
+    }
+
+    double percentile(double p) const
+    {
+        if (latencies_us.empty())
+            return 0.0;
+
+        std::vector<double> sorted = latencies_us;
+        size_t index = std::min(sorted.size() - 1, static_cast<size_t>(p / 100.0 * sorted.size()));
+        std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+        return sorted[index];
+    }
+};
+
+inline int bench_connect(const LoadOptions &options)
+{
+    if (!options.unix_path.empty())
+    {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+
+        socklen_t length = offsetof(sockaddr_un, sun_path) + options.unix_path.size();
+        options.unix_path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+        if (options.unix_path[0] == '@')
+            address.sun_path[0] = '\0';
+        else
+            length += 1;
+
+        if (connect(fd, reinterpret_cast<sockaddr *>(&address), length) != 0)
+        {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#ifdef TCP_FASTOPEN_CONNECT
+    if (options.fast_open)
+        setsockopt(fd, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, &one, sizeof(one));
+#endif
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(options.port);
+    inet_pton(AF_INET, options.host.c_str(), &address.sin_addr);
+
+    if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Reads one response; returns false when the connection must be reopened.
+inline bool bench_read_response(int fd, std::string &buffer, bool &server_closes)
+{
+    size_t headers_end;
+    char chunk[16384];
+
+    while ((headers_end = buffer.find("\r\n\r\n")) == std::string::npos)
+    {
+        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if (received <= 0)
+            return false;
+        buffer.append(chunk, received);
+    }
+
+    std::string headers = buffer.substr(0, headers_end);
+    std::transform(headers.begin(), headers.end(), headers.begin(), ::tolower);
+    server_closes = headers.find("connection: close") != std::string::npos;
+
+    size_t length_pos = headers.find("content-length:");
+    if (length_pos == std::string::npos)
+    {
+        ssize_t received;
+        while ((received = recv(fd, chunk, sizeof(chunk), 0)) > 0)
+        {
+        }
+        buffer.clear();
+        server_closes = true;
+        return received == 0;
+    }
+
+    size_t total = headers_end + 4 + std::stoul(headers.substr(length_pos + 15));
+    while (buffer.size() < total)
+    {
+        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if (received <= 0)
+            return false;
+        buffer.append(chunk, received);
+    }
+
+    buffer.erase(0, total);
+    return true;
+}
+
+inline LoadResult run_load(const LoadOptions &options)
+{
+    using clock = std::chrono::steady_clock;
+
+    std::vector<LoadResult> results(options.connections);
+    std::vector<std::thread> threads;
+    auto start = clock::now();
+    auto deadline = start + std::chrono::duration<double>(options.duration_seconds);
+
+    for (size_t i = 0; i < options.connections; ++i)
+    {
+        threads.emplace_back([&options, &result = results[i], deadline]
+                             {
+                                 int fd = -1;
+                                 std::string buffer;
+
+                                 while (clock::now() < deadline)
+                                 {
+                                     if (fd < 0 && (fd = bench_connect(options)) < 0)
+                                     {
+                                         ++result.errors;
+                                         continue;
+                                     }
+
+                                     auto sent_at = clock::now();
+                                     bool server_closes = false;
+
+                                     if (send(fd, options.request.data(), options.request.size(), MSG_NOSIGNAL) < 0 ||
+                                         !bench_read_response(fd, buffer, server_closes))
+                                     {
+                                         ++result.errors;
+                                         close(fd);
+                                         fd = -1;
+                                         buffer.clear();
+                                         continue;
+                                     }
+
+                                     auto elapsed = std::chrono::duration<double, std::micro>(clock::now() - sent_at);
+                                     result.latencies_us.push_back(elapsed.count());
+                                     ++result.requests;
+
+                                     if (!options.keep_alive || server_closes)
+                                     {
+                                         close(fd);
+                                         fd = -1;
+                                         buffer.clear();
+                                     }
+                                 }
+
+                                 if (fd >= 0)
+                                     close(fd); });
+    }
+
+    for (auto &thread : threads)
+        thread.join();
+
+    LoadResult total;
+    total.seconds = std::chrono::duration<double>(clock::now() - start).count();
+    for (auto &result : results)
+    {
+        total.requests += result.requests;
+        total.errors += result.errors;
+        total.latencies_us.insert(total.latencies_us.end(), result.latencies_us.begin(), result.latencies_us.end());
+    }
+
+    return total;
+}
+
+inline void print_result_header()
+{
+    std::printf("%-28s %12s %10s %10s %10s %8s\n", "configuration", "req/s", "p50 (us)", "p99 (us)", "max (us)", "errors");
+}
+
+inline void print_result(const std::string &name, const LoadResult &result)
+{
+    std::printf("%-28s %12.0f %10.1f %10.1f %10.1f %8zu\n", name.c_str(), result.requests_per_second(),
+                result.percentile(50), result.percentile(99), result.percentile(100), result.errors);
+}
+
+#endif // BENCH_CLIENT_HPP
@@ -0,0 +1,110 @@
+#include "bench_client.hpp"
+#include "server/httpserver.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+// Compares route execution policies. First a trivial handler answered inline
+// on the I/O thread, on a worker, and on the blocking pool; then the same
+// handler while other clients keep hitting a handler that sleeps as if waiting
+// on a disk or a database, once with that handler on the workers and once on
+// the blocking pool.
+// Usage: bench_execution_policy [duration_seconds] [connections] [io_threads] [workers]
+
+static HttpResponse plaintext(const HttpRequest &)
+{
+    HttpResponse response;
+    response.add_header("Content-Type", "text/plain");
+    response.set_body("Hello, World!");
+    return response;
+}
+
+static HttpResponse slow_io(const HttpRequest &request)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    return plaintext(request);
+}
+
+static Router make_router(ExecutionPolicy slow_policy)
+{
+    Router router;
+    router.get("/inline", plaintext, ExecutionPolicy::Inline);
+    router.get("/worker", plaintext);
+    router.get("/blocking", plaintext, ExecutionPolicy::Blocking);
+    router.get("/slow", slow_io, slow_policy);
+    return router;
+}
+
+// Runs the load on path, with slow_connections clients on /slow alongside.
+static LoadResult bench_policy(const ServerConfig &config, ExecutionPolicy slow_policy, LoadOptions options,
+                               const std::string &path, size_t slow_connections)
+{
+    HttpServer server;
+    server.set_router(make_router(slow_policy));
+    server.set_config(config);
+
+    std::thread server_thread([&server]
+                              { server.run(0, 1024); });
+
+    while (!server.is_running())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    options.port = server.get_port();
+    options.keep_alive = true;
+
+    LoadOptions slow_options = options;
+    slow_options.connections = slow_connections;
+    slow_options.request = "GET /slow HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    std::thread slow_load;
+    if (slow_connections > 0)
+        slow_load = std::thread([&slow_options]
+                                { run_load(slow_options); });
+
+    options.request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    LoadResult result = run_load(options);
+
+    if (slow_load.joinable())
+        slow_load.join();
+
+    server.stop();
+    server_thread.join();
+
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    LoadOptions options;
+    options.duration_seconds = argc > 1 ? std::atof(argv[1]) : 2.0;
+    options.connections = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 16;
+    size_t io_threads = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1;
+    size_t workers = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 4;
+
+#ifdef DEBUG
+    std::printf("warning: debug build, numbers are not representative\n");
+#endif
+
+    ServerConfig config;
+    // Results go through printf; keep the server to warnings and errors.
+    config.logging.level = LogLevel::Warning;
+    config.backend = IoBackend::Epoll;
+    config.io_threads = io_threads;
+    config.topology.workers = workers;
+    config.blocking_workers = workers * 4;
+
+    std::printf("\ntrivial handler, %zu connections, %.1fs\n", options.connections, options.duration_seconds);
+    print_result_header();
+    for (const std::string path : {"/inline", "/worker", "/blocking"})
+        print_result(path.substr(1), bench_policy(config, ExecutionPolicy::Blocking, options, path, 0));
+
+    size_t slow_connections = workers * 2;
+    std::printf("\n/worker with %zu connections on a 20 ms handler, %.1fs\n", slow_connections, options.duration_seconds);
+    print_result_header();
+    print_result("slow handler on workers", bench_policy(config, ExecutionPolicy::Worker, options, "/worker",
+                                                         slow_connections));
+    print_result("slow handler on blocking", bench_policy(config, ExecutionPolicy::Blocking, options, "/worker",
+                                                          slow_connections));
+
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include "server/logger.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Compares the server's log output under contention: the mutex around an
+// unbuffered std::ostream it used to take for every line, against per-thread
+// rings emptied by a writer thread. Every thread logs lines shaped like the
+// per-request one; both write to /dev/null, so the cost measured is the
+// logging path and one write per line or per batch, not the terminal. Rings
+// are sized to hold all of a thread's lines, so none are dropped; the ring
+// side is timed once the threads are done logging, which is what request
+// threads see, and once everything is written.
+// Usage: bench_logger [lines_per_thread] [max_threads]
+
+static double run_mutex(size_t threads, uint64_t lines_per_thread)
+{
+    std::ofstream output("/dev/null");
+    output << std::unitbuf;
+    std::mutex mutex;
+    std::vector<std::thread> producers;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t t = 0; t < threads; ++t)
+    {
+        producers.emplace_back([&output, &mutex, lines_per_thread]
+                               {
+                                   for (uint64_t i = 0; i < lines_per_thread; ++i)
+                                   {
+                                       std::lock_guard<std::mutex> lock(mutex);
+                                       output << "Request processed: " << 0 << " /index.html?id=" << i << " -> " << 200 << "\n";
+                                   } });
+    }
+
+    for (auto &producer : producers)
+        producer.join();
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct RingTimes
+{
+    double logged;
+    double written;
+    uint64_t dropped;
+};
+
+static RingTimes run_rings(size_t threads, uint64_t lines_per_thread)
+{
+    FILE *output = std::fopen("/dev/null", "w");
+    LogPolicy policy;
+    policy.level = LogLevel::Debug;
+    policy.ring_lines = lines_per_thread;
+    std::vector<std::thread> producers;
+    RingTimes times;
+
+    {
+        Logger logger(policy, output, output);
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t t = 0; t < threads; ++t)
+        {
+            producers.emplace_back([&logger, lines_per_thread]
+                                   {
+                                       for (uint64_t i = 0; i < lines_per_thread; ++i)
+                                           logger.debug() << "Request processed: " << 0 << " /index.html?id=" << i << " -> " << 200; });
+        }
+
+        for (auto &producer : producers)
+            producer.join();
+        times.logged = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        logger.flush();
+        times.written = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        times.dropped = logger.get_dropped_count();
+    }
+
+    std::fclose(output);
+    return times;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t lines_per_thread = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000;
+    size_t max_threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 16;
+
+#ifdef DEBUG
+    std::printf("warning: debug build, numbers are not representative\n");
+#endif
+
+    std::printf("%zu hardware threads, %llu lines per thread\n", static_cast<size_t>(std::thread::hardware_concurrency()),
+                static_cast<unsigned long long>(lines_per_thread));
+    std::printf("%-10s %16s %16s %16s %10s %8s\n", "threads", "mutex lines/s", "ring logged/s", "ring written/s",
+                "speedup", "dropped");
+
+    for (size_t threads = 1; threads <= max_threads; threads *= 2)
+    {
+        double total = static_cast<double>(threads * lines_per_thread);
+        double mutex_rate = total / run_mutex(threads, lines_per_thread);
+        RingTimes ring = run_rings(threads, lines_per_thread);
+
+        std::printf("%-10zu %16.0f %16.0f %16.0f %9.2fx %8llu\n", threads, mutex_rate, total / ring.logged,
+                    total / ring.written, total / ring.written / mutex_rate, static_cast<unsigned long long>(ring.dropped));
+    }
+
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include "bench_client.hpp"
+#include "server/httpserver.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Measures the effect of each SocketPolicy knob on requests/sec and latency over loopback.
+// Usage: bench_socket_policy [duration_seconds] [connections] [io_threads]
+
+struct Variant
+{
+    std::string name;
+    std::function<void(SocketPolicy &)> apply;
+};
+
+struct Workload
+{
+    std::string name;
+    std::string path;
+    bool keep_alive;
+};
+
+static Router make_router()
+{
+    Router router;
+
+    router.get("/plaintext", [](const HttpRequest &) -> HttpResponse
+               {
+                   HttpResponse response;
+                   response.add_header("Content-Type", "text/plain");
+                   response.set_body("Hello, World!");
+                   return response; });
+
+    // Written in small pieces, so segment coalescing decides how many packets go out
+    router.get("/pieces", [](const HttpRequest &) -> HttpResponse
+               {
+                   HttpResponse response;
+                   response.add_header("Content-Type", "text/plain");
+                   response.add_header("Content-Length", std::to_string(8 * 512));
+                   response.set_body_stream([piece = 0](BodyWriter &writer) mutable
+                                            {
+                                                writer.write(std::string(512, 'p'));
+                                                return ++piece < 8; });
+                   return response; });
+
+    router.get("/large", [](const HttpRequest &) -> HttpResponse
+               {
+                   HttpResponse response;
+                   response.add_header("Content-Type", "text/plain");
+                   response.set_body(std::string(256 * 1024, 'x'));
+                   return response; });
+
+    return router;
+}
+
+static LoadResult bench_policy(const ServerConfig &config, const LoadOptions &base_options, const Workload &workload)
+{
+    HttpServer server;
+    server.set_router(make_router());
+    server.set_config(config);
+
+    std::thread server_thread([&server]
+                              { server.run(0); });
+
+    while (!server.is_running())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    LoadOptions options = base_options;
+    options.port = server.get_port();
+    options.keep_alive = workload.keep_alive;
+    options.fast_open = config.socket_policy.fast_open_queue > 0;
+    options.request = "GET " + workload.path + " HTTP/1.1\r\nHost: localhost\r\n" +
+                      (options.keep_alive ? "" : "Connection: close\r\n") + "\r\n";
+
+    LoadResult result = run_load(options);
+
+    server.stop();
+    server_thread.join();
+
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    LoadOptions options;
+    options.duration_seconds = argc > 1 ? std::atof(argv[1]) : 2.0;
+    options.connections = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 16;
+    size_t io_threads = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1;
+
+#ifdef DEBUG
+    std::printf("warning: debug build, numbers are not representative\n");
+#endif
+
+    std::vector<Variant> variants = {
+        {"defaults", [](SocketPolicy &) {}},
+        {"backlog 5", [](SocketPolicy &policy)
+         { policy.backlog = 5; }},
+        {"defer accept 1s", [](SocketPolicy &policy)
+         { policy.defer_accept_seconds = 1; }},
+        {"fast open 256", [](SocketPolicy &policy)
+         { policy.fast_open_queue = 256; }},
+        {"nagle", [](SocketPolicy &policy)
+         { policy.nagle = NagleStrategy::Default; }},
+        {"cork", [](SocketPolicy &policy)
+         { policy.nagle = NagleStrategy::Cork; }},
+        {"buffers 16 KiB", [](SocketPolicy &policy)
+         { policy.send_buffer_size = policy.receive_buffer_size = 16 * 1024; }},
+        {"buffers 1 MiB", [](SocketPolicy &policy)
+         { policy.send_buffer_size = policy.receive_buffer_size = 1024 * 1024; }},
+        {"busy poll 50us", [](SocketPolicy &policy)
+         { policy.busy_poll_us = 50; }},
+    };
+
+    std::vector<Workload> workloads = {
+        {"plaintext close", "/plaintext", false},
+        {"plaintext keep-alive", "/plaintext", true},
+        {"8 x 512 B pieces keep-alive", "/pieces", true},
+        {"256 KiB keep-alive", "/large", true},
+    };
+
+    for (const Workload &workload : workloads)
+    {
+        std::printf("\n%s, %zu connections, %.1fs\n", workload.name.c_str(), options.connections, options.duration_seconds);
+        print_result_header();
+
+        for (const Variant &variant : variants)
+        {
+            ServerConfig config;
+            // Results go through printf; keep the server to warnings and errors.
+            config.logging.level = LogLevel::Warning;
+            config.io_threads = io_threads;
+            variant.apply(config.socket_policy);
+
+            print_result(variant.name, bench_policy(config, options, workload));
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,200 @@
+#include "server/event_count.hpp"
+#include "server/mpmc_queue.hpp"
+#include "server/task.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Compares the worker pool's task queue under contention: the mutex and
+// condition variable around std::queue<std::function> it used to have, against
+// the lock-free ring of inline tasks with workers parked on an event count.
+// Each run has as many producer threads as consumer threads, from 1 to 64.
+// Usage: bench_task_queue [tasks_per_producer] [max_threads]
+
+class MutexQueue
+{
+private:
+    std::queue<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stop = false;
+
+public:
+    void push(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.push(std::move(task));
+        }
+        m_condition.notify_one();
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_condition.notify_all();
+    }
+
+    void work()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_condition.wait(lock, [this]
+                                 { return m_stop || !m_tasks.empty(); });
+
+                if (m_stop && m_tasks.empty())
+                    return;
+
+                task = std::move(m_tasks.front());
+                m_tasks.pop();
+            }
+            task();
+        }
+    }
+};
+
+class RingQueue
+{
+private:
+    MpmcQueue<Task> m_tasks{4096};
+    EventCount m_events;
+    std::atomic<bool> m_stop{false};
+
+public:
+    void push(Task task)
+    {
+        while (!m_tasks.try_push(task))
+            std::this_thread::yield();
+        m_events.notify_one();
+    }
+
+    void stop()
+    {
+        m_stop = true;
+        m_events.notify_all();
+    }
+
+    void work()
+    {
+        Task task;
+
+        while (true)
+        {
+            for (int spin = 0; spin < 64 && !m_tasks.try_pop(task); ++spin)
+                std::this_thread::yield();
+
+            if (!task)
+            {
+                uint32_t epoch = m_events.prepare_wait();
+
+                if (m_tasks.try_pop(task))
+                {
+                    m_events.cancel_wait();
+                }
+                else if (m_stop)
+                {
+                    m_events.cancel_wait();
+                    return;
+                }
+                else
+                {
+                    m_events.wait(epoch);
+                    continue;
+                }
+            }
+
+            task();
+            task.reset();
+        }
+    }
+};
+
+// Tasks the size of the server's request dispatch: a pointer and a few words.
+struct Payload
+{
+    std::atomic<uint64_t> *done;
+    uint64_t id;
+    uint64_t served;
+    uint64_t padding[3];
+
+    void operator()() const
+    {
+        done->fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+template <typename Queue>
+static double run_contention(size_t threads, uint64_t tasks_per_producer)
+{
+    Queue queue;
+    std::atomic<uint64_t> done{0};
+    std::vector<std::thread> consumers;
+    std::vector<std::thread> producers;
+
+    for (size_t i = 0; i < threads; ++i)
+        consumers.emplace_back([&queue]
+                               { queue.work(); });
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < threads; ++i)
+    {
+        producers.emplace_back([&queue, &done, tasks_per_producer]
+                               {
+                                   for (uint64_t id = 0; id < tasks_per_producer; ++id)
+                                       queue.push(Payload{&done, id, 0, {}}); });
+    }
+
+    for (auto &producer : producers)
+        producer.join();
+
+    while (done.load(std::memory_order_relaxed) < threads * tasks_per_producer)
+        std::this_thread::yield();
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    queue.stop();
+    for (auto &consumer : consumers)
+        consumer.join();
+
+    return std::chrono::duration<double>(elapsed).count();
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t tasks_per_producer = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    size_t max_threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64;
+
+#ifdef DEBUG
+    std::printf("warning: debug build, numbers are not representative\n");
+#endif
+
+    std::printf("%zu hardware threads, %llu tasks per producer\n", static_cast<size_t>(std::thread::hardware_concurrency()),
+                static_cast<unsigned long long>(tasks_per_producer));
+    std::printf("%-10s %16s %16s %10s\n", "threads", "mutex tasks/s", "ring tasks/s", "speedup");
+
+    for (size_t threads = 1; threads <= max_threads; threads *= 2)
+    {
+        double total = static_cast<double>(threads * tasks_per_producer);
+        double mutex_rate = total / run_contention<MutexQueue>(threads, tasks_per_producer);
+        double ring_rate = total / run_contention<RingQueue>(threads, tasks_per_producer);
+
+        std::printf("%-10zu %16.0f %16.0f %9.2fx\n", threads, mutex_rate, ring_rate, ring_rate / mutex_rate);
+    }
+
+    return 0;
+}
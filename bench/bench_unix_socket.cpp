@@ -0,0 +1,110 @@
+#include "bench_client.hpp"
+#include "server/httpserver.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+// Compares request latency over loopback TCP with Unix domain sockets, as a
+// reverse proxy on the same host would connect. One connection by default, so
+// the latency is a single round trip through each transport.
+// Usage: bench_unix_socket [duration_seconds] [connections] [io_threads]
+
+static Router make_router()
+{
+    Router router;
+
+    router.get("/plaintext", [](const HttpRequest &) -> HttpResponse
+               {
+                   HttpResponse response;
+                   response.add_header("Content-Type", "text/plain");
+                   response.set_body("Hello, World!");
+                   return response; });
+
+    router.get("/64k", [](const HttpRequest &) -> HttpResponse
+               {
+                   HttpResponse response;
+                   response.add_header("Content-Type", "text/plain");
+                   response.set_body(std::string(64 * 1024, 'x'));
+                   return response; });
+
+    return router;
+}
+
+static LoadResult bench_transport(const ServerConfig &config, const LoadOptions &base_options, const std::string &path)
+{
+    HttpServer server;
+    server.set_router(make_router());
+    server.set_config(config);
+
+    std::thread server_thread([&server]
+                              { server.run(0, 1024); });
+
+    while (!server.is_running())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    LoadOptions options = base_options;
+    options.port = server.get_port();
+    options.unix_path = config.unix_socket_path;
+    options.request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n" +
+                      (options.keep_alive ? "" : "Connection: close\r\n") + "\r\n";
+
+    LoadResult result = run_load(options);
+
+    server.stop();
+    server_thread.join();
+
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    LoadOptions options;
+    options.duration_seconds = argc > 1 ? std::atof(argv[1]) : 2.0;
+    options.connections = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1;
+    size_t io_threads = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1;
+
+#ifdef DEBUG
+    std::printf("warning: debug build, numbers are not representative\n");
+#endif
+
+    std::string socket_file = "/tmp/bench_unix_socket-" + std::to_string(getpid()) + ".sock";
+    std::string abstract_name = "@bench_unix_socket-" + std::to_string(getpid());
+
+    std::vector<IoBackend> backends = {IoBackend::Epoll};
+#ifdef HAS_IO_URING
+    backends.push_back(IoBackend::IoUring);
+#endif
+
+    for (const std::string path : {"/plaintext", "/64k"})
+    {
+        std::printf("\n%s, %zu connections, %.1fs\n", path.c_str(), options.connections, options.duration_seconds);
+        print_result_header();
+
+        for (bool keep_alive : {true, false})
+        {
+            options.keep_alive = keep_alive;
+
+            for (IoBackend backend : backends)
+            {
+                ServerConfig config;
+                // Results go through printf; keep the server to warnings and errors.
+                config.logging.level = LogLevel::Warning;
+                config.backend = backend;
+                config.io_threads = io_threads;
+
+                std::string name = io_backend_to_string(backend) + (keep_alive ? " keep-alive" : " close");
+                print_result(name + " tcp", bench_transport(config, options, path));
+
+                config.unix_socket_path = socket_file;
+                print_result(name + " unix", bench_transport(config, options, path));
+
+                config.unix_socket_path = abstract_name;
+                print_result(name + " abstract", bench_transport(config, options, path));
+            }
+        }
+    }
+
+    return 0;
+}
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <algorithm>
+#include <cctype>
 
 inline void ltrim(std::string &s)
 {
@@ -18,4 +19,10 @@ inline void rtrim(std::string &s)
             s.end());
 }
 
+inline bool iequals(const std::string &a, const std::string &b)
+{
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](unsigned char x, unsigned char y)
+                      { return std::tolower(x) == std::tolower(y); });
+}
+
 #endif // HELPERS_HPP
\ No newline at end of file
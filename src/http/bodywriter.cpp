@@ -0,0 +1,86 @@
+#include "http/bodywriter.hpp"
+#include <cstdio>
+#include <stdexcept>
+
+BodyWriter::BodyWriter(BodyFraming framing, size_t content_length)
+    : m_output(),
+      m_framing(framing),
+      m_remaining(content_length),
+      m_finished(false)
+{
+}
+
+void BodyWriter::write(const char *data, size_t length)
+{
+    if (m_finished)
+        throw std::logic_error("Body already finished");
+
+    if (length == 0)
+        return;
+
+    switch (m_framing)
+    {
+    case BodyFraming::Chunked:
+    {
+        char size_line[20];
+        int size_length = std::snprintf(size_line, sizeof(size_line), "%zx\r\n", length);
+        m_output.append(size_line, size_length);
+        m_output.append(data, length);
+        m_output.append("\r\n");
+        break;
+    }
+
+    case BodyFraming::ContentLength:
+        if (length > m_remaining)
+            throw std::length_error("Body exceeds declared Content-Length");
+
+        m_remaining -= length;
+        m_output.append(data, length);
+        break;
+
+    case BodyFraming::Close:
+        m_output.append(data, length);
+        break;
+    }
+}
+
+void BodyWriter::write(const std::string &data)
+{
+    write(data.data(), data.size());
+}
+
+void BodyWriter::finish()
+{
+    if (m_finished)
+        return;
+
+    if (m_framing == BodyFraming::ContentLength && m_remaining > 0)
+        throw std::length_error("Body shorter than declared Content-Length");
+
+    if (m_framing == BodyFraming::Chunked)
+        m_output.append("0\r\n\r\n");
+
+    m_finished = true;
+}
+
+BodyFraming BodyWriter::get_framing() const
+{
+    return m_framing;
+}
+
+bool BodyWriter::is_finished() const
+{
+    return m_finished;
+}
+
+size_t BodyWriter::get_output_size() const
+{
+    return m_output.size();
+}
+
+std::string BodyWriter::take_output()
+{
+    std::string output = std::move(m_output);
+    m_output.clear();
+    return output;
+}
@@ -0,0 +1,43 @@
+#ifndef BODYWRITER_HPP
+#define BODYWRITER_HPP
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+enum class BodyFraming
+{
+    Chunked,
+    ContentLength,
+    Close,
+};
+
+// Frames the body pieces a streaming response writes: chunked transfer coding,
+// raw bytes checked against a declared Content-Length, or raw bytes ended by
+// closing the connection.
+class BodyWriter
+{
+private:
+    std::string m_output;
+    BodyFraming m_framing;
+    size_t m_remaining;
+    bool m_finished;
+
+public:
+    explicit BodyWriter(BodyFraming framing = BodyFraming::Chunked, size_t content_length = 0);
+
+    void write(const char *data, size_t length);
+    void write(const std::string &data);
+    void finish();
+
+    BodyFraming get_framing() const;
+    bool is_finished() const;
+    size_t get_output_size() const;
+    std::string take_output();
+};
+
+// Called whenever the connection can take more output. Writes the next piece of
+// the body and returns false once the body is complete.
+using BodyStream = std::function<bool(BodyWriter &writer)>;
+
+#endif // BODYWRITER_HPP
@@ -0,0 +1,78 @@
+#include "http/filebody.hpp"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+FileBody::FileBody(int fd, size_t size)
+    : m_fd(fd),
+      m_size(size)
+{
+}
+
+FileBody::~FileBody()
+{
+#ifdef _WIN32
+    _close(m_fd);
+#else
+    close(m_fd);
+#endif
+}
+
+std::shared_ptr<FileBody> FileBody::open(const std::string &path)
+{
+#ifdef _WIN32
+    int fd = _open(path.c_str(), _O_RDONLY | _O_BINARY);
+    struct _stat64 info;
+
+    if (fd < 0)
+        return nullptr;
+
+    if (_fstat64(fd, &info) != 0)
+    {
+        _close(fd);
+        return nullptr;
+    }
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat info;
+
+    if (fd < 0)
+        return nullptr;
+
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+    {
+        close(fd);
+        return nullptr;
+    }
+#endif
+
+    return std::shared_ptr<FileBody>(new FileBody(fd, static_cast<size_t>(info.st_size)));
+}
+
+int FileBody::get_fd() const
+{
+    return m_fd;
+}
+
+size_t FileBody::get_size() const
+{
+    return m_size;
+}
+
+long FileBody::read(char *buffer, size_t length, size_t offset) const
+{
+#ifdef _WIN32
+    if (_lseeki64(m_fd, static_cast<__int64>(offset), SEEK_SET) < 0)
+        return -1;
+    return _read(m_fd, buffer, static_cast<unsigned>(length));
+#else
+    return pread(m_fd, buffer, length, static_cast<off_t>(offset));
+#endif
+}
@@ -0,0 +1,35 @@
+#ifndef FILEBODY_HPP
+#define FILEBODY_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// Open, read-only file sent as a response body. The server hands its
+// descriptor to sendfile() or splice() so the contents never pass through
+// user space.
+class FileBody
+{
+private:
+    int m_fd;
+    size_t m_size;
+
+    FileBody(int fd, size_t size);
+
+public:
+    FileBody(const FileBody &) = delete;
+    FileBody &operator=(const FileBody &) = delete;
+
+    ~FileBody();
+
+    // Returns nullptr if the file cannot be opened.
+    static std::shared_ptr<FileBody> open(const std::string &path);
+
+    int get_fd() const;
+    size_t get_size() const;
+
+    // Copies up to length bytes at offset into buffer, for platforms without sendfile().
+    long read(char *buffer, size_t length, size_t offset) const;
+};
+
+#endif // FILEBODY_HPP
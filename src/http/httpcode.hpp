@@ -2,6 +2,7 @@
 #define HTTPCODE_HPP
 
 #include <string>
+#include <string_view>
 #include <stdexcept>
 
 enum class HttpCode
@@ -155,7 +156,7 @@ inline HttpCode http_code_from_string(const std::string &code)
     }
 }
 
-inline std::string http_code_to_string(HttpCode code)
+inline std::string_view http_code_to_string(HttpCode code)
 {
     switch (code)
     {
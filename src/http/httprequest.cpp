@@ -84,11 +84,48 @@ const std::map<std::string, std::string> &HttpRequest::get_headers() const
     return headers;
 }
 
+std::string HttpRequest::get_header(const std::string &name) const
+{
+    for (const auto &[header_name, value] : headers)
+    {
+        if (iequals(header_name, name))
+            return value;
+    }
+
+    return "";
+}
+
+bool HttpRequest::has_header(const std::string &name) const
+{
+    return std::any_of(headers.begin(), headers.end(), [&name](const auto &header)
+                       { return iequals(header.first, name); });
+}
+
 const std::string &HttpRequest::get_body() const
 {
     return body;
 }
 
+bool HttpRequest::is_keep_alive() const
+{
+    bool keep_alive = version == "HTTP/1.1";
+    std::istringstream tokens(get_header("Connection"));
+    std::string token;
+
+    while (std::getline(tokens, token, ','))
+    {
+        ltrim(token);
+        rtrim(token);
+
+        if (iequals(token, "close"))
+            return false;
+        if (iequals(token, "keep-alive"))
+            keep_alive = true;
+    }
+
+    return keep_alive;
+}
+
 void HttpRequest::set_method(HttpMethod method)
 {
     this->method = method;
@@ -119,6 +156,11 @@ void HttpRequest::set_body(const std::string &body)
     this->body = body;
 }
 
+void HttpRequest::set_body(std::string &&body)
+{
+    this->body = std::move(body);
+}
+
 std::string HttpRequest::to_string() const
 {
     std::ostringstream oss;
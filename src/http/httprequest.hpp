@@ -35,7 +35,10 @@ public:
     const std::string &get_uri() const;
     const std::string &get_version() const;
     const std::map<std::string, std::string> &get_headers() const;
+    std::string get_header(const std::string &name) const;
+    bool has_header(const std::string &name) const;
     const std::string &get_body() const;
+    bool is_keep_alive() const;
 
     void set_method(HttpMethod method);
     void set_uri(const std::string &uri);
@@ -43,6 +46,7 @@ public:
     void add_header(const std::string &name, const std::string &value);
     void remove_header(const std::string &name);
     void set_body(const std::string &body);
+    void set_body(std::string &&body);
 
     std::string to_string() const;
 };
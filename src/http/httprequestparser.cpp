@@ -0,0 +1,347 @@
+#include "helpers.hpp"
+#include "http/httprequestparser.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+HttpRequestParser::HttpRequestParser(size_t max_header_size, size_t max_body_size, size_t max_streamed_body_size)
+    : m_state(State::RequestLine),
+      m_request(),
+      m_line(),
+      m_body(),
+      m_body_sink(),
+      m_header_size(0),
+      m_content_length(0),
+      m_body_remaining(0),
+      m_body_size(0),
+      m_has_content_length(false),
+      m_chunked(false),
+      m_max_header_size(max_header_size),
+      m_max_body_size(max_body_size),
+      m_max_streamed_body_size(max_streamed_body_size)
+{
+}
+
+ParseStatus HttpRequestParser::feed(const char *data, size_t length, size_t &consumed)
+{
+    consumed = 0;
+
+    while (m_state != State::Complete)
+    {
+        switch (m_state)
+        {
+        case State::RequestLine:
+            if (!read_line(data, length, consumed))
+                return ParseStatus::NeedMore;
+
+            // Empty lines ahead of a request line are tolerated (RFC 9112 section 2.2)
+            if (!m_line.empty())
+            {
+                parse_request_line(m_line);
+                m_state = State::Headers;
+            }
+            break;
+
+        case State::Headers:
+            if (!read_line(data, length, consumed))
+                return ParseStatus::NeedMore;
+
+            if (m_line.empty())
+                return finish_headers();
+
+            parse_header(m_line, false);
+            break;
+
+        case State::Body:
+        case State::ChunkData:
+        {
+            if (consumed == length)
+                return ParseStatus::NeedMore;
+
+            size_t chunk = std::min(length - consumed, m_body_remaining);
+            append_body(data + consumed, chunk);
+            consumed += chunk;
+            m_body_remaining -= chunk;
+
+            if (m_body_remaining == 0)
+            {
+                if (m_state == State::Body)
+                    return finish_message();
+                m_state = State::ChunkDataEnd;
+            }
+            break;
+        }
+
+        case State::ChunkSize:
+            if (!read_line(data, length, consumed))
+                return ParseStatus::NeedMore;
+
+            parse_chunk_size(m_line);
+            m_state = m_body_remaining == 0 ? State::Trailers : State::ChunkData;
+            break;
+
+        case State::ChunkDataEnd:
+            if (!read_line(data, length, consumed))
+                return ParseStatus::NeedMore;
+
+            if (!m_line.empty())
+                throw std::invalid_argument("Missing CRLF after chunk data");
+
+            m_state = State::ChunkSize;
+            break;
+
+        case State::Trailers:
+            if (!read_line(data, length, consumed))
+                return ParseStatus::NeedMore;
+
+            if (m_line.empty())
+                return finish_message();
+
+            parse_header(m_line, true);
+            break;
+
+        case State::Complete:
+            break;
+        }
+    }
+
+    return ParseStatus::MessageComplete;
+}
+
+bool HttpRequestParser::read_line(const char *data, size_t length, size_t &consumed)
+{
+    if (consumed == length)
+        return false;
+
+    const char *start = data + consumed;
+    size_t available = length - consumed;
+    auto newline = static_cast<const char *>(std::memchr(start, '\n', available));
+    size_t chunk = newline ? newline - start + 1 : available;
+
+    m_line.append(start, newline ? chunk - 1 : chunk);
+    consumed += chunk;
+
+    if (m_state == State::ChunkSize || m_state == State::ChunkDataEnd)
+    {
+        if (m_line.size() > max_chunk_line_size)
+            throw std::length_error("Chunk size line too long");
+    }
+    else
+    {
+        m_header_size += chunk;
+        if (m_header_size > m_max_header_size)
+            throw std::length_error("Request headers too large");
+    }
+
+    if (!newline)
+        return false;
+
+    if (!m_line.empty() && m_line.back() == '\r')
+        m_line.pop_back();
+
+    return true;
+}
+
+void HttpRequestParser::parse_request_line(const std::string &line)
+{
+    size_t method_end = line.find(' ');
+    size_t uri_end = method_end == std::string::npos ? std::string::npos : line.find(' ', method_end + 1);
+
+    if (uri_end == std::string::npos)
+        throw std::invalid_argument("Malformed request line: " + line);
+
+    m_request.set_method(http_method_from_string(line.substr(0, method_end)));
+    m_request.set_uri(line.substr(method_end + 1, uri_end - method_end - 1));
+    m_request.set_version(line.substr(uri_end + 1));
+    m_line.clear();
+}
+
+void HttpRequestParser::parse_header(const std::string &line, bool trailer)
+{
+    auto colon_pos = line.find(':');
+
+    if (colon_pos == std::string::npos)
+    {
+        m_line.clear();
+        return;
+    }
+
+    std::string name = line.substr(0, colon_pos);
+    std::string value = line.substr(colon_pos + 1);
+    ltrim(value);
+    rtrim(value);
+    m_line.clear();
+
+    bool content_length = iequals(name, "Content-Length");
+    bool transfer_encoding = iequals(name, "Transfer-Encoding");
+
+    // Trailer fields never change framing and never override header fields
+    if (trailer)
+    {
+        if (!content_length && !transfer_encoding && !m_request.has_header(name))
+            m_request.add_header(name, value);
+        return;
+    }
+
+    if (content_length)
+    {
+        if (value.empty() || value.size() > 18 || value.find_first_not_of("0123456789") != std::string::npos)
+            throw std::invalid_argument("Invalid Content-Length: " + value);
+
+        size_t length = std::stoull(value);
+
+        // Differing lengths leave the message boundary ambiguous (RFC 9112 section 6.3)
+        if (m_has_content_length)
+        {
+            if (length != m_content_length)
+                throw std::invalid_argument("Conflicting Content-Length values");
+            return;
+        }
+
+        m_content_length = length;
+        m_has_content_length = true;
+    }
+    else if (transfer_encoding)
+    {
+        size_t last_coding = value.rfind(',');
+        std::string coding = value.substr(last_coding == std::string::npos ? 0 : last_coding + 1);
+        ltrim(coding);
+
+        if (!iequals(coding, "chunked"))
+            throw std::invalid_argument("Unsupported Transfer-Encoding: " + value);
+
+        m_chunked = true;
+    }
+
+    m_request.add_header(name, value);
+}
+
+void HttpRequestParser::parse_chunk_size(const std::string &line)
+{
+    std::string size = line.substr(0, line.find(';'));
+    ltrim(size);
+    rtrim(size);
+
+    if (size.empty() || size.size() > 15 || size.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos)
+        throw std::invalid_argument("Invalid chunk size: " + line);
+
+    m_body_remaining = std::stoull(size, nullptr, 16);
+    m_line.clear();
+}
+
+void HttpRequestParser::append_body(const char *data, size_t length)
+{
+    m_body_size += length;
+
+    if (m_body_sink)
+    {
+        if (m_max_streamed_body_size > 0 && (m_chunked ? m_body_size : m_content_length) > m_max_streamed_body_size)
+            throw std::length_error("Streamed request body too large");
+
+        m_body_sink(data, length);
+        return;
+    }
+
+    if ((m_chunked ? m_body_size : m_content_length) > m_max_body_size)
+        throw std::length_error("Request body too large");
+
+    if (m_body.empty() && !m_chunked)
+        m_body.reserve(m_content_length);
+
+    m_body.append(data, length);
+}
+
+ParseStatus HttpRequestParser::finish_headers()
+{
+    m_line.clear();
+
+    // A message with both framings is a request smuggling vector (RFC 9112 section 6.3)
+    if (m_chunked && m_has_content_length)
+        throw std::invalid_argument("Both Transfer-Encoding and Content-Length present");
+
+    if (m_chunked)
+    {
+        m_state = State::ChunkSize;
+        return ParseStatus::HeadersComplete;
+    }
+
+    // Whether a sink takes the body is only known later, so this rejects
+    // lengths that neither a buffered nor a streamed body may reach.
+    if (m_max_streamed_body_size > 0 && m_content_length > std::max(m_max_body_size, m_max_streamed_body_size))
+        throw std::length_error("Request body too large");
+
+    if (m_content_length == 0)
+        return finish_message();
+
+    m_body_remaining = m_content_length;
+    m_state = State::Body;
+    return ParseStatus::HeadersComplete;
+}
+
+ParseStatus HttpRequestParser::finish_message()
+{
+    m_line.clear();
+
+    if (!m_body_sink && !m_body.empty())
+        m_request.set_body(std::move(m_body));
+
+    m_state = State::Complete;
+    return ParseStatus::MessageComplete;
+}
+
+void HttpRequestParser::set_body_sink(BodySink sink)
+{
+    m_body_sink = std::move(sink);
+}
+
+bool HttpRequestParser::is_idle() const
+{
+    return m_state == State::RequestLine && m_line.empty();
+}
+
+bool HttpRequestParser::is_reading_body() const
+{
+    return m_state != State::RequestLine && m_state != State::Headers && m_state != State::Complete;
+}
+
+bool HttpRequestParser::is_complete() const
+{
+    return m_state == State::Complete;
+}
+
+bool HttpRequestParser::is_chunked() const
+{
+    return m_chunked;
+}
+
+size_t HttpRequestParser::get_content_length() const
+{
+    return m_content_length;
+}
+
+const HttpRequest &HttpRequestParser::get_request() const
+{
+    return m_request;
+}
+
+HttpRequest HttpRequestParser::take_request()
+{
+    HttpRequest request = std::move(m_request);
+    reset();
+    return request;
+}
+
+void HttpRequestParser::reset()
+{
+    m_state = State::RequestLine;
+    m_request = HttpRequest();
+    m_line.clear();
+    m_body.clear();
+    m_body_sink = nullptr;
+    m_header_size = 0;
+    m_content_length = 0;
+    m_body_remaining = 0;
+    m_body_size = 0;
+    m_has_content_length = false;
+    m_chunked = false;
+}
@@ -0,0 +1,88 @@
+#ifndef HTTPREQUESTPARSER_HPP
+#define HTTPREQUESTPARSER_HPP
+
+#include "http/httprequest.hpp"
+#include <cstddef>
+#include <functional>
+#include <string>
+
+enum class ParseStatus
+{
+    NeedMore,
+    HeadersComplete,
+    MessageComplete,
+};
+
+// Receives decoded body bytes as they arrive instead of buffering them in the request.
+using BodySink = std::function<void(const char *data, size_t length)>;
+
+// Incremental request parser that can be fed arbitrary chunks of a byte stream.
+// feed() never consumes bytes past the end of the current message, so
+// pipelined requests stay in the caller's buffer for the next call.
+class HttpRequestParser
+{
+private:
+    enum class State
+    {
+        RequestLine,
+        Headers,
+        Body,
+        ChunkSize,
+        ChunkData,
+        ChunkDataEnd,
+        Trailers,
+        Complete,
+    };
+
+    static constexpr size_t max_chunk_line_size = 1024;
+
+    State m_state;
+    HttpRequest m_request;
+    std::string m_line;
+    std::string m_body;
+    BodySink m_body_sink;
+    size_t m_header_size;
+    size_t m_content_length;
+    size_t m_body_remaining;
+    size_t m_body_size;
+    bool m_has_content_length;
+    bool m_chunked;
+    size_t m_max_header_size;
+    size_t m_max_body_size;
+    size_t m_max_streamed_body_size;
+
+    bool read_line(const char *data, size_t length, size_t &consumed);
+    void parse_request_line(const std::string &line);
+    void parse_header(const std::string &line, bool trailer);
+    void parse_chunk_size(const std::string &line);
+    void append_body(const char *data, size_t length);
+    ParseStatus finish_headers();
+    ParseStatus finish_message();
+
+public:
+    static constexpr size_t default_max_header_size = 64 * 1024;
+    static constexpr size_t default_max_body_size = 1024 * 1024;
+
+    // max_streamed_body_size limits bodies given to a sink; 0 leaves them unlimited.
+    explicit HttpRequestParser(size_t max_header_size = default_max_header_size,
+                               size_t max_body_size = default_max_body_size,
+                               size_t max_streamed_body_size = 0);
+
+    ParseStatus feed(const char *data, size_t length, size_t &consumed);
+
+    // Streams the body of the current message to sink; meant to be set when
+    // feed() reports HeadersComplete. Streamed bodies have their own limit.
+    void set_body_sink(BodySink sink);
+
+    bool is_idle() const;
+    bool is_reading_body() const;
+    bool is_complete() const;
+    bool is_chunked() const;
+    size_t get_content_length() const;
+    const HttpRequest &get_request() const;
+
+    HttpRequest take_request();
+    void reset();
+};
+
+#endif // HTTPREQUESTPARSER_HPP
@@ -2,6 +2,8 @@
 #include "http/httpresponse.hpp"
 #include <sstream>
 #include <algorithm>
+#include <cstring>
+#include <string_view>
 
 HttpResponse HttpResponse::from_string(std::string raw_response)
 {
@@ -57,7 +59,7 @@ void HttpResponse::parse_body(const std::string &body_content)
 }
 
 HttpResponse::HttpResponse()
-    : version("HTTP/1.1"), code(HttpCode::OK), headers(), body()
+    : version("HTTP/1.1"), code(HttpCode::OK), headers(), body(), body_stream(), body_file()
 {
 }
 
@@ -76,11 +78,43 @@ const std::map<std::string, std::string> &HttpResponse::get_headers() const
     return headers;
 }
 
+std::string HttpResponse::get_header(const std::string &name) const
+{
+    for (const auto &[header_name, value] : headers)
+    {
+        if (iequals(header_name, name))
+            return value;
+    }
+
+    return "";
+}
+
+bool HttpResponse::has_header(const std::string &name) const
+{
+    return std::any_of(headers.begin(), headers.end(), [&name](const auto &header)
+                       { return iequals(header.first, name); });
+}
+
 const std::string &HttpResponse::get_body() const
 {
     return body;
 }
 
+const BodyStream &HttpResponse::get_body_stream() const
+{
+    return body_stream;
+}
+
+bool HttpResponse::is_streaming() const
+{
+    return static_cast<bool>(body_stream);
+}
+
+const std::shared_ptr<FileBody> &HttpResponse::get_body_file() const
+{
+    return body_file;
+}
+
 void HttpResponse::set_version(const std::string &version)
 {
     this->version = version;
@@ -96,6 +130,16 @@ void HttpResponse::set_body(const std::string &body)
     this->body = body;
 }
 
+void HttpResponse::set_body_stream(BodyStream stream)
+{
+    this->body_stream = std::move(stream);
+}
+
+void HttpResponse::set_body_file(std::shared_ptr<FileBody> file)
+{
+    this->body_file = std::move(file);
+}
+
 void HttpResponse::add_header(const std::string &name, const std::string &value)
 {
     headers[name] = value;
@@ -106,18 +150,55 @@ void HttpResponse::remove_header(const std::string &name)
     headers.erase(name);
 }
 
-std::string HttpResponse::to_string() const
+std::string HttpResponse::head_to_string() const
+{
+    std::string head(get_head_size(), '\0');
+    write_head(head.data());
+    return head;
+}
+
+size_t HttpResponse::get_head_size() const
+{
+    size_t size = version.size() + http_code_to_string(code).size() + 5;
+
+    for (const auto &[name, value] : headers)
+        size += name.size() + value.size() + 4;
+
+    return size;
+}
+
+static char *write_bytes(char *out, std::string_view bytes)
+{
+    std::memcpy(out, bytes.data(), bytes.size());
+    return out + bytes.size();
+}
+
+char *HttpResponse::write_head(char *out) const
 {
-    std::ostringstream oss;
-    oss << version << " " << http_code_to_string(code) << "\r\n";
+    out = write_bytes(out, version);
+    out = write_bytes(out, " ");
+    out = write_bytes(out, http_code_to_string(code));
+    out = write_bytes(out, "\r\n");
 
     for (const auto &[name, value] : headers)
     {
-        oss << name << ": " << value << "\r\n";
+        out = write_bytes(out, name);
+        out = write_bytes(out, ": ");
+        out = write_bytes(out, value);
+        out = write_bytes(out, "\r\n");
     }
 
-    oss << "\r\n"
-        << body;
+    return write_bytes(out, "\r\n");
+}
 
-    return oss.str();
-}
\ No newline at end of file
+std::string HttpResponse::to_string() const
+{
+    return head_to_string() + body;
+}
+
+std::string HttpResponse::take_body()
+{
+    std::string taken = std::move(body);
+    body.clear();
+    return taken;
+}
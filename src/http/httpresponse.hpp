@@ -1,8 +1,11 @@
 #ifndef HTTPRESPONSE_HPP
 #define HTTPRESPONSE_HPP
 
+#include "http/bodywriter.hpp"
+#include "http/filebody.hpp"
 #include "http/httpcode.hpp"
 #include <map>
+#include <memory>
 #include <string>
 
 class HttpResponse
@@ -12,6 +15,8 @@ private:
     HttpCode code;
     std::map<std::string, std::string> headers;
     std::string body;
+    BodyStream body_stream;
+    std::shared_ptr<FileBody> body_file;
 
     void parse_response_line(const std::string &line);
     void parse_header(const std::string &header_line);
@@ -33,7 +38,12 @@ public:
     const std::string &get_version() const;
     HttpCode get_code() const;
     const std::map<std::string, std::string> &get_headers() const;
+    std::string get_header(const std::string &name) const;
+    bool has_header(const std::string &name) const;
     const std::string &get_body() const;
+    const BodyStream &get_body_stream() const;
+    bool is_streaming() const;
+    const std::shared_ptr<FileBody> &get_body_file() const;
 
     void set_version(const std::string &version);
     void set_code(HttpCode code);
@@ -41,7 +51,21 @@ public:
     void remove_header(const std::string &name);
     void set_body(const std::string &body);
 
+    // Sends the body as the stream produces it instead of from get_body(). The
+    // body goes out with Transfer-Encoding: chunked unless a Content-Length
+    // header is set.
+    void set_body_stream(BodyStream stream);
+
+    // Sends the body straight from file, with Content-Length set to its size.
+    void set_body_file(std::shared_ptr<FileBody> file);
+
+    // Status line and header block, up to and including the blank line.
+    std::string head_to_string() const;
+    size_t get_head_size() const;
+    // Writes the head to out, which must hold get_head_size() bytes, and returns its end.
+    char *write_head(char *out) const;
     std::string to_string() const;
+    std::string take_body();
 };
 
 #endif // HTTPRESPONSE_HPP
\ No newline at end of file
@@ -1,9 +1,84 @@
+#include "server/cpu_topology.hpp"
 #include "server/httpserver.hpp"
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
 
-int main()
+#ifndef _WIN32
+#include <csignal>
+#include <pthread.h>
+#endif
+
+int main(int argc, char *argv[])
 {
+#ifndef _WIN32
+    // Blocked before any thread starts, so only the signal thread receives them.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGUSR2);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+#endif
+
     HttpServer server;
     Router router;
+    ServerConfig config;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+
+        try
+        {
+            if (arg.rfind("--backend=", 0) == 0)
+                config.backend = io_backend_from_string(arg.substr(10));
+            else if (arg.rfind("--io-threads=", 0) == 0)
+                config.io_threads = std::stoul(arg.substr(13));
+            else if (arg.rfind("--unix-socket=", 0) == 0)
+                config.unix_socket_path = arg.substr(14);
+            else if (arg.rfind("--unix-socket-mode=", 0) == 0)
+                config.unix_socket_mode = std::stoi(arg.substr(19), nullptr, 8);
+            else if (arg.rfind("--workers=", 0) == 0)
+                config.topology.workers = std::stoul(arg.substr(10));
+            else if (arg.rfind("--blocking-workers=", 0) == 0)
+                config.blocking_workers = std::stoul(arg.substr(19));
+            else if (arg.rfind("--worker-cpus=", 0) == 0)
+                config.topology.worker_cpus = parse_cpu_sets(arg.substr(14));
+            else if (arg.rfind("--io-cpus=", 0) == 0)
+                config.topology.io_cpus = parse_cpu_sets(arg.substr(10));
+            else if (arg == "--pin-workers")
+                config.topology.pin_workers = true;
+            else if (arg == "--isolate-io")
+                config.topology.isolate_io_threads = true;
+            else if (arg == "--numa-buffers")
+                config.topology.numa_local_buffers = true;
+            else if (arg.rfind("--log-level=", 0) == 0)
+                config.logging.level = log_level_from_string(arg.substr(12));
+            else if (arg.rfind("--access-log=", 0) == 0)
+                config.access_log.path = arg.substr(13);
+            else if (arg.rfind("--access-log-sample=", 0) == 0)
+                parse_sample_rates(arg.substr(20), config.access_log.sample_rates);
+            else if (arg == "--reuse-port")
+                config.reuse_port_shards = true;
+            else if (arg == "--cpu-steering")
+                config.reuse_port_shards = config.shard_cpu_steering = true;
+            else
+                throw std::invalid_argument("Unknown option: " + arg);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << "\n"
+                      << "Usage: " << argv[0] << " [--backend=blocking|epoll|io_uring] [--io-threads=N]"
+                      << " [--reuse-port] [--cpu-steering] [--unix-socket=PATH|@NAME] [--unix-socket-mode=OCTAL]"
+                      << " [--workers=N] [--blocking-workers=N] [--worker-cpus=LIST[;LIST...]] [--io-cpus=LIST[;LIST...]]"
+                      << " [--pin-workers] [--isolate-io] [--numa-buffers]"
+                      << " [--log-level=debug|info|warning|error|off]"
+                      << " [--access-log=PATH] [--access-log-sample=CLASS=RATE[,CLASS=RATE...]]\n";
+            return 1;
+        }
+    }
 
     router.get("/", [&server](const HttpRequest &) -> HttpResponse
                { return server.serve_static_file("index.html"); });
@@ -27,7 +102,35 @@ int main()
                });
 
     server.set_router(router);
+    server.set_config(config);
+
+#ifndef _WIN32
+    // SIGTERM and SIGINT drain the server, and a second one stops it at once.
+    // SIGUSR2 first starts a new instance on the same listening sockets, so
+    // restarting into a new binary never leaves the port unserved.
+    std::atomic<bool> finished{false};
+    std::thread signal_thread([&]
+                              {
+                                  int received;
+                                  while (sigwait(&signals, &received) == 0 && !finished)
+                                  {
+                                      if (received == SIGUSR2 && (server.is_draining() || !server.hand_off(argv)))
+                                          continue;
+
+                                      if (server.is_draining())
+                                          server.stop();
+                                      else
+                                          server.drain();
+                                  } });
+#endif
 
     int exit_code = server.run();
+
+#ifndef _WIN32
+    finished = true;
+    pthread_kill(signal_thread.native_handle(), SIGTERM);
+    signal_thread.join();
+#endif
+
     return exit_code;
 }
\ No newline at end of file
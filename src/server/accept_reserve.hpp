@@ -0,0 +1,55 @@
+#ifndef ACCEPT_RESERVE_HPP
+#define ACCEPT_RESERVE_HPP
+
+#ifndef _WIN32
+
+#include "socket_wrapper.hpp"
+#include <fcntl.h>
+#include <sys/socket.h>
+
+// Holds a spare descriptor for when the process runs out of them. accept fails
+// with EMFILE/ENFILE but leaves the connection queued, so the listener stays
+// readable; releasing the spare lets one pending connection be taken and closed.
+class AcceptReserve
+{
+private:
+    SocketWrapper m_fd;
+
+public:
+    AcceptReserve() { restore(); }
+
+    bool release()
+    {
+        if (!m_fd.is_valid())
+            restore();
+
+        bool held = m_fd.is_valid();
+        m_fd.reset();
+        return held;
+    }
+
+    bool restore()
+    {
+        if (!m_fd.is_valid())
+            m_fd.reset(open("/dev/null", O_RDONLY | O_CLOEXEC));
+        return m_fd.is_valid();
+    }
+
+    // Accepts and closes one connection from a non-blocking listener.
+    bool shed(socket_t listen_fd)
+    {
+        if (!release())
+            return false;
+
+        socket_t client_fd = accept(listen_fd, nullptr, nullptr);
+        if (client_fd >= 0)
+            close(client_fd);
+
+        restore();
+        return client_fd >= 0;
+    }
+};
+
+#endif
+
+#endif // ACCEPT_RESERVE_HPP
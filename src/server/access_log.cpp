@@ -0,0 +1,399 @@
+#include "server/access_log.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+PeerAddress get_peer_address(socket_t fd)
+{
+    PeerAddress peer;
+    sockaddr_storage address{};
+    socklen_t length = sizeof(address);
+
+    if (getpeername(fd, reinterpret_cast<sockaddr *>(&address), &length) != 0)
+        return peer;
+
+    if (address.ss_family == AF_INET)
+    {
+        const auto *ipv4 = reinterpret_cast<const sockaddr_in *>(&address);
+        peer.family = PeerFamily::IPv4;
+        peer.port = ntohs(ipv4->sin_port);
+        std::memcpy(peer.address.data(), &ipv4->sin_addr, 4);
+    }
+    else if (address.ss_family == AF_INET6)
+    {
+        const auto *ipv6 = reinterpret_cast<const sockaddr_in6 *>(&address);
+        peer.family = PeerFamily::IPv6;
+        peer.port = ntohs(ipv6->sin6_port);
+        std::memcpy(peer.address.data(), &ipv6->sin6_addr, 16);
+    }
+#ifndef _WIN32
+    else if (address.ss_family == AF_UNIX)
+    {
+        peer.family = PeerFamily::Local;
+    }
+#endif
+
+    return peer;
+}
+
+std::string peer_address_to_string(const PeerAddress &peer)
+{
+    char text[INET6_ADDRSTRLEN] = {};
+
+    switch (peer.family)
+    {
+    case PeerFamily::IPv4:
+        inet_ntop(AF_INET, peer.address.data(), text, sizeof(text));
+        return std::string(text) + ":" + std::to_string(peer.port);
+    case PeerFamily::IPv6:
+        inet_ntop(AF_INET6, peer.address.data(), text, sizeof(text));
+        return "[" + std::string(text) + "]:" + std::to_string(peer.port);
+    case PeerFamily::Local:
+        return "local";
+    default:
+        return "-";
+    }
+}
+
+AccessLog::AccessLog(const AccessLogPolicy &policy)
+    : m_policy(policy), m_queue(std::max<size_t>(1, policy.queue_capacity))
+{
+    for (size_t i = 0; i < m_thresholds.size(); ++i)
+    {
+        double rate = std::clamp(policy.sample_rates[i], 0.0, 1.0);
+        m_thresholds[i] = rate >= 1.0 ? UINT64_MAX : static_cast<uint64_t>(rate * 18446744073709551616.0);
+    }
+
+    std::error_code error;
+    if (std::filesystem::exists(m_policy.path, error))
+        rotate_files();
+    open_file();
+
+    m_writer = std::thread([this]
+                           { run_writer(); });
+}
+
+AccessLog::~AccessLog()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_writer_mutex);
+        m_stopping = true;
+    }
+    m_writer_condition.notify_one();
+    m_writer.join();
+
+    flush();
+    close_file();
+}
+
+bool AccessLog::should_record(int status) const
+{
+    size_t status_class = std::clamp(status / 100, 1, 5) - 1;
+    uint64_t threshold = m_thresholds[status_class];
+    if (threshold == UINT64_MAX || threshold == 0)
+        return threshold != 0;
+
+    // xorshift64*, seeded per thread; good enough to pick a share of responses.
+    static thread_local uint64_t state = 0x9e3779b97f4a7c15ull ^ reinterpret_cast<uintptr_t>(&state);
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545f4914f6cdd1dull < threshold;
+}
+
+void AccessLog::record(HttpMethod method, std::string_view uri, int status, uint64_t bytes,
+                       std::chrono::steady_clock::duration duration, const PeerAddress &peer)
+{
+    AccessRecord record{};
+    record.timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                              std::chrono::system_clock::now().time_since_epoch())
+                              .count();
+    record.bytes = bytes;
+    int64_t duration_us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    record.duration_us = static_cast<uint32_t>(std::clamp<int64_t>(duration_us, 0, UINT32_MAX));
+    record.status = static_cast<uint16_t>(status);
+    record.method = static_cast<uint8_t>(method);
+    record.peer_family = static_cast<uint8_t>(peer.family);
+    std::memcpy(record.peer_address, peer.address.data(), sizeof(record.peer_address));
+    record.peer_port = peer.port;
+    record.uri_length = static_cast<uint16_t>(std::min<size_t>(uri.size(), UINT16_MAX));
+    std::memcpy(record.uri, uri.data(), std::min(uri.size(), AccessRecord::uri_size));
+
+    if (!m_queue.try_push(record))
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AccessLog::open_file()
+{
+#ifdef _WIN32
+    throw std::runtime_error("Access logs are not supported on this platform");
+#else
+    size_t record_space = m_policy.max_file_size - std::min(m_policy.max_file_size, AccessLogHeader::header_size);
+    m_capacity = std::max<size_t>(1, record_space / sizeof(AccessRecord));
+    size_t size = AccessLogHeader::header_size + m_capacity * sizeof(AccessRecord);
+
+    m_fd = ::open(m_policy.path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (m_fd < 0)
+        throw std::runtime_error("Failed to open access log " + m_policy.path + ": " + std::strerror(errno));
+
+    // Blocks are reserved up front so a full disk fails here rather than as a
+    // SIGBUS on a later store to the mapping.
+    int error = posix_fallocate(m_fd, 0, static_cast<off_t>(size));
+    if (error == EOPNOTSUPP || error == EINVAL)
+        error = ftruncate(m_fd, static_cast<off_t>(size)) == 0 ? 0 : errno;
+
+    void *map = error == 0 ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0) : MAP_FAILED;
+    if (map == MAP_FAILED)
+    {
+        std::string reason = std::strerror(error != 0 ? error : errno);
+        ::close(m_fd);
+        m_fd = -1;
+        throw std::runtime_error("Failed to map access log " + m_policy.path + ": " + reason);
+    }
+
+    m_map = static_cast<char *>(map);
+    m_count = 0;
+
+    AccessLogHeader header{};
+    std::memcpy(header.magic, AccessLogHeader::magic_value, sizeof(header.magic));
+    header.version = 1;
+    header.record_size = sizeof(AccessRecord);
+    std::memcpy(m_map, &header, sizeof(header));
+#endif
+}
+
+void AccessLog::close_file()
+{
+#ifndef _WIN32
+    if (m_fd < 0)
+        return;
+
+    munmap(m_map, AccessLogHeader::header_size + m_capacity * sizeof(AccessRecord));
+    // A file that cannot be cut keeps its unused records, which readers skip.
+    int truncated = ftruncate(m_fd, static_cast<off_t>(AccessLogHeader::header_size + m_count * sizeof(AccessRecord)));
+    (void)truncated;
+    ::close(m_fd);
+    m_fd = -1;
+    m_map = nullptr;
+#endif
+}
+
+void AccessLog::rotate_files()
+{
+    std::error_code error;
+    const std::string &path = m_policy.path;
+
+    if (m_policy.max_files == 0)
+    {
+        std::filesystem::remove(path, error);
+        return;
+    }
+
+    std::filesystem::remove(path + "." + std::to_string(m_policy.max_files), error);
+    for (size_t i = m_policy.max_files - 1; i >= 1; --i)
+        std::filesystem::rename(path + "." + std::to_string(i), path + "." + std::to_string(i + 1), error);
+    std::filesystem::rename(path, path + ".1", error);
+}
+
+size_t AccessLog::drain()
+{
+    size_t written = 0;
+    AccessRecord record;
+
+    while (m_map && m_queue.try_pop(record))
+    {
+        if (m_count == m_capacity)
+        {
+            close_file();
+            rotate_files();
+
+            // Without a next file the record is lost, and later ones wait
+            // in the queue until it fills.
+            try
+            {
+                open_file();
+            }
+            catch (const std::exception &)
+            {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+        }
+
+        std::memcpy(m_map + AccessLogHeader::header_size + m_count * sizeof(AccessRecord), &record, sizeof(record));
+        ++m_count;
+        ++written;
+    }
+
+    m_written.fetch_add(written, std::memory_order_relaxed);
+    return written;
+}
+
+void AccessLog::run_writer()
+{
+    std::unique_lock<std::mutex> lock(m_writer_mutex);
+    size_t written = 0;
+
+    while (!m_stopping)
+    {
+        if (written == 0)
+            m_writer_condition.wait_for(lock, m_policy.flush_interval);
+
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> drain_lock(m_drain_mutex);
+            written = drain();
+        }
+        lock.lock();
+    }
+}
+
+void AccessLog::flush()
+{
+    std::lock_guard<std::mutex> lock(m_drain_mutex);
+    drain();
+}
+
+uint64_t AccessLog::get_dropped_count() const
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+uint64_t AccessLog::get_written_count() const
+{
+    return m_written.load(std::memory_order_relaxed);
+}
+
+std::vector<AccessRecord> read_access_log(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("Failed to open " + path);
+
+    char header_bytes[AccessLogHeader::header_size] = {};
+    AccessLogHeader header;
+    file.read(header_bytes, sizeof(header_bytes));
+    std::memcpy(&header, header_bytes, sizeof(header));
+
+    if (!file || std::memcmp(header.magic, AccessLogHeader::magic_value, sizeof(header.magic)) != 0)
+        throw std::runtime_error(path + " is not an access log");
+    if (header.version != 1 || header.record_size != sizeof(AccessRecord))
+        throw std::runtime_error(path + " has an unsupported access log version");
+
+    std::vector<AccessRecord> records;
+    AccessRecord record;
+    while (file.read(reinterpret_cast<char *>(&record), sizeof(record)) && record.timestamp_us != 0)
+        records.push_back(record);
+
+    return records;
+}
+
+static std::string format_timestamp(uint64_t timestamp_us)
+{
+    std::time_t seconds = static_cast<std::time_t>(timestamp_us / 1000000);
+    std::tm time{};
+#ifdef _WIN32
+    gmtime_s(&time, &seconds);
+#else
+    gmtime_r(&seconds, &time);
+#endif
+
+    char text[40];
+    size_t length = std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%S", &time);
+    std::snprintf(text + length, sizeof(text) - length, ".%06uZ", static_cast<unsigned>(timestamp_us % 1000000));
+    return text;
+}
+
+static PeerAddress get_record_peer(const AccessRecord &record)
+{
+    PeerAddress peer;
+    peer.family = static_cast<PeerFamily>(record.peer_family);
+    peer.port = record.peer_port;
+    std::memcpy(peer.address.data(), record.peer_address, peer.address.size());
+    return peer;
+}
+
+// A cut URI ends in "...".
+static std::string get_record_uri(const AccessRecord &record)
+{
+    size_t length = std::min<size_t>(record.uri_length, AccessRecord::uri_size);
+    std::string uri(record.uri, length);
+    if (record.uri_length > AccessRecord::uri_size)
+        uri += "...";
+    return uri;
+}
+
+static std::string get_record_method(const AccessRecord &record)
+{
+    if (record.method > static_cast<uint8_t>(HttpMethod::TRACE))
+        return "-";
+    return http_method_to_string(static_cast<HttpMethod>(record.method));
+}
+
+std::string format_access_record(const AccessRecord &record)
+{
+    return format_timestamp(record.timestamp_us) + " " + peer_address_to_string(get_record_peer(record)) + " " +
+           get_record_method(record) + " " + get_record_uri(record) + " " + std::to_string(record.status) + " " +
+           std::to_string(record.bytes) + " " + std::to_string(record.duration_us) + "us";
+}
+
+std::string format_access_record_csv(const AccessRecord &record)
+{
+    std::string uri = "\"";
+    for (char c : get_record_uri(record))
+    {
+        if (c == '"')
+            uri += '"';
+        uri += c;
+    }
+    uri += '"';
+
+    return format_timestamp(record.timestamp_us) + "," + peer_address_to_string(get_record_peer(record)) + "," +
+           get_record_method(record) + "," + uri + "," + std::to_string(record.status) + "," +
+           std::to_string(record.bytes) + "," + std::to_string(record.duration_us);
+}
+
+std::string access_record_csv_header()
+{
+    return "timestamp,peer,method,uri,status,bytes,duration_us";
+}
+
+void parse_sample_rates(const std::string &rates, std::array<double, 5> &sample_rates)
+{
+    size_t start = 0;
+    while (start <= rates.size())
+    {
+        size_t end = rates.find(',', start);
+        if (end == std::string::npos)
+            end = rates.size();
+        std::string entry = rates.substr(start, end - start);
+
+        size_t equals = entry.find('=');
+        if (equals != 3 || entry[0] < '1' || entry[0] > '5' || entry.compare(1, 2, "xx") != 0)
+            throw std::invalid_argument("Invalid sample rate: " + entry);
+
+        size_t parsed = 0;
+        double rate = std::stod(entry.substr(4), &parsed);
+        if (parsed != entry.size() - 4 || rate < 0.0 || rate > 1.0)
+            throw std::invalid_argument("Invalid sample rate: " + entry);
+
+        sample_rates[entry[0] - '1'] = rate;
+        start = end + 1;
+    }
+}
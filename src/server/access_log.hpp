@@ -0,0 +1,140 @@
+#ifndef ACCESS_LOG_HPP
+#define ACCESS_LOG_HPP
+
+#include "http/httpmethod.hpp"
+#include "mpmc_queue.hpp"
+#include "server_config.hpp"
+#include "socket_wrapper.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+enum class PeerFamily : uint8_t
+{
+    Unknown,
+    IPv4,
+    IPv6,
+    Local,
+};
+
+// A connection's remote address in network byte order; IPv4 addresses use the
+// first four bytes.
+struct PeerAddress
+{
+    PeerFamily family = PeerFamily::Unknown;
+    uint16_t port = 0;
+    std::array<uint8_t, 16> address{};
+};
+
+PeerAddress get_peer_address(socket_t fd);
+// "192.0.2.1:80", "[2001:db8::1]:80", "local" or "-".
+std::string peer_address_to_string(const PeerAddress &peer);
+
+// One response as stored in an access log file, in the host's byte order.
+// URIs are cut to the record; uri_length keeps their full length, up to 65535.
+struct AccessRecord
+{
+    static constexpr size_t uri_size = 80;
+
+    uint64_t timestamp_us; // Microseconds since the epoch; 0 marks an unused record
+    uint64_t bytes;        // Head and body; a streamed body counts only its head
+    uint32_t duration_us;  // From reading the request to finishing its response
+    uint16_t status;
+    uint8_t method; // HttpMethod
+    uint8_t peer_family;
+    uint8_t peer_address[16];
+    uint16_t peer_port;
+    uint16_t uri_length;
+    uint8_t reserved[4];
+    char uri[uri_size];
+};
+
+static_assert(sizeof(AccessRecord) == 128, "Access records are a fixed 128 bytes");
+
+// Starts each access log file; records follow at header_size.
+struct AccessLogHeader
+{
+    static constexpr char magic_value[8] = {'H', 'T', 'T', 'P', 'A', 'C', 'C', '1'};
+    static constexpr size_t header_size = 64;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+};
+
+// Binary access records kept off the request path: a response that is sampled
+// is copied into a fixed-size record and queued, and a writer thread copies
+// queued records into a memory-mapped file preallocated to the policy's size.
+// A full file is truncated to the records in it and rotated. Records that find
+// the queue full are dropped and counted.
+class AccessLog
+{
+private:
+    AccessLogPolicy m_policy;
+    // A response of status class c is recorded when a random 64-bit value is
+    // below m_thresholds[c]; 0 never records and UINT64_MAX always does.
+    std::array<uint64_t, 5> m_thresholds;
+    MpmcQueue<AccessRecord> m_queue;
+    std::atomic<uint64_t> m_dropped{0};
+    std::atomic<uint64_t> m_written{0};
+
+    // Held by whoever empties the queue: the writer thread, or flush().
+    std::mutex m_drain_mutex;
+    int m_fd = -1;
+    char *m_map = nullptr;
+    size_t m_capacity = 0;
+    size_t m_count = 0;
+
+    std::mutex m_writer_mutex;
+    std::condition_variable m_writer_condition;
+    bool m_stopping = false;
+    std::thread m_writer;
+
+    void open_file();
+    void close_file();
+    void rotate_files();
+    // Returns the number of records written.
+    size_t drain();
+    void run_writer();
+
+public:
+    // Files left at the path by an earlier run are rotated, not overwritten.
+    // Throws std::runtime_error if the file cannot be created.
+    explicit AccessLog(const AccessLogPolicy &policy);
+
+    AccessLog(const AccessLog &) = delete;
+    AccessLog &operator=(const AccessLog &) = delete;
+
+    // Writes every queued record and truncates the file to them.
+    ~AccessLog();
+
+    // Samples a response by its status class; call before gathering a record.
+    bool should_record(int status) const;
+    void record(HttpMethod method, std::string_view uri, int status, uint64_t bytes,
+                std::chrono::steady_clock::duration duration, const PeerAddress &peer);
+    // Writes every record queued before the call.
+    void flush();
+
+    uint64_t get_dropped_count() const;
+    uint64_t get_written_count() const;
+};
+
+// Reads the records of an access log file, stopping at its first unused one.
+// Throws std::runtime_error if the file cannot be read or is not an access log.
+std::vector<AccessRecord> read_access_log(const std::string &path);
+std::string format_access_record(const AccessRecord &record);
+std::string format_access_record_csv(const AccessRecord &record);
+std::string access_record_csv_header();
+// Parses "2xx=0.01,5xx=1" into the rates of the classes named, keeping the
+// others. Throws std::invalid_argument on anything else.
+void parse_sample_rates(const std::string &rates, std::array<double, 5> &sample_rates);
+
+#endif // ACCESS_LOG_HPP
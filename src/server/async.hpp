@@ -0,0 +1,183 @@
+#ifndef ASYNC_HPP
+#define ASYNC_HPP
+
+#include "task.hpp"
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <utility>
+#include <variant>
+
+// A coroutine producing a T, for route handlers that wait on sockets, timers
+// or files without holding a thread. It starts suspended and runs once awaited
+// by another coroutine, which it resumes when it returns, or once started by
+// whoever owns it. The owner destroys the frame with the Async object.
+template <typename T>
+class Async
+{
+public:
+    struct promise_type;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+private:
+    // Resumes the awaiting coroutine, or else tells the owner that started it.
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        std::coroutine_handle<> await_suspend(handle_type handle) noexcept
+        {
+            promise_type &promise = handle.promise();
+            if (promise.continuation)
+                return promise.continuation;
+
+            // Moved out first, since the callback may destroy the frame.
+            Task on_done = std::move(promise.on_done);
+            if (on_done)
+                on_done();
+            return std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept
+        {
+        }
+    };
+
+public:
+    struct promise_type
+    {
+        std::variant<std::monostate, T, std::exception_ptr> result;
+        std::coroutine_handle<> continuation;
+        Task on_done;
+
+        Async get_return_object()
+        {
+            return Async(handle_type::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() const noexcept
+        {
+            return {};
+        }
+
+        FinalAwaiter final_suspend() const noexcept
+        {
+            return {};
+        }
+
+        template <typename U>
+        void return_value(U &&value)
+        {
+            result.template emplace<1>(std::forward<U>(value));
+        }
+
+        void unhandled_exception()
+        {
+            result.template emplace<2>(std::current_exception());
+        }
+    };
+
+private:
+    handle_type m_handle;
+
+    explicit Async(handle_type handle)
+        : m_handle(handle)
+    {
+    }
+
+public:
+    Async() : m_handle(nullptr) {}
+
+    Async(Async &&other) noexcept
+        : m_handle(std::exchange(other.m_handle, nullptr))
+    {
+    }
+
+    Async &operator=(Async &&other) noexcept
+    {
+        if (this != &other)
+        {
+            if (m_handle)
+                m_handle.destroy();
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+
+    Async(const Async &) = delete;
+    Async &operator=(const Async &) = delete;
+
+    ~Async()
+    {
+        if (m_handle)
+            m_handle.destroy();
+    }
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        m_handle.promise().continuation = awaiting;
+        return m_handle;
+    }
+
+    T await_resume()
+    {
+        return get_result();
+    }
+
+    // Runs the coroutine until it first suspends. on_done runs once it has
+    // returned, on the thread that resumed it last; it may destroy this object,
+    // which is not touched again once the coroutine is running.
+    void start(Task on_done)
+    {
+        handle_type handle = m_handle;
+        handle.promise().on_done = std::move(on_done);
+        handle.resume();
+    }
+
+    bool is_done() const
+    {
+        return m_handle && m_handle.done();
+    }
+
+    // The returned value; rethrows what the coroutine threw.
+    T get_result()
+    {
+        auto &result = m_handle.promise().result;
+        if (result.index() == 2)
+            std::rethrow_exception(std::get<2>(result));
+        return std::move(std::get<1>(result));
+    }
+};
+
+// Runs a coroutine on the calling thread and blocks until it returns, for
+// callers outside an event loop such as blocking workers.
+template <typename T>
+T sync_wait(Async<T> async)
+{
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool done = false;
+
+    async.start([&mutex, &condition, &done]
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    done = true;
+                    condition.notify_one(); });
+
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [&done]
+                   { return done; });
+
+    return async.get_result();
+}
+
+#endif // ASYNC_HPP
@@ -0,0 +1,135 @@
+#include "server/async_io.hpp"
+#include "server/io_loop.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <thread>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+static AsyncOperation::clock::time_point deadline_after(AsyncOperation::clock::duration timeout)
+{
+    auto now = AsyncOperation::clock::now();
+    if (timeout >= AsyncOperation::clock::time_point::max() - now)
+        return AsyncOperation::clock::time_point::max();
+    return now + timeout;
+}
+
+bool AsyncOperation::await_suspend(std::coroutine_handle<> awaiting)
+{
+    IoLoop *loop = IoLoop::get_current();
+
+    if (!loop)
+    {
+        run_blocking();
+        return false;
+    }
+
+    handle = awaiting;
+    loop->start_operation(*this);
+    return true;
+}
+
+void AsyncOperation::run_blocking()
+{
+    switch (kind)
+    {
+    case Kind::Sleep:
+        std::this_thread::sleep_until(deadline);
+        result = 0;
+        break;
+    case Kind::Poll:
+    {
+#ifdef _WIN32
+        result = events;
+#else
+        pollfd descriptor{fd, events, 0};
+        int timeout = -1;
+
+        if (deadline != clock::time_point::max())
+        {
+            auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - clock::now());
+            timeout = static_cast<int>(std::max<int64_t>(0, remaining.count()));
+        }
+
+        int ready;
+        while ((ready = poll(&descriptor, 1, timeout)) < 0 && errno == EINTR)
+        {
+        }
+
+        result = ready < 0 ? -errno : (ready == 0 ? 0 : descriptor.revents);
+#endif
+        break;
+    }
+    case Kind::Read:
+    {
+#ifdef _WIN32
+        result = -ENOSYS;
+#else
+        ssize_t bytes = pread(fd, buffer, length, static_cast<off_t>(offset));
+        result = bytes < 0 ? -errno : bytes;
+#endif
+        break;
+    }
+    }
+}
+
+AsyncOperation sleep_until(AsyncOperation::clock::time_point deadline)
+{
+    AsyncOperation operation;
+    operation.kind = AsyncOperation::Kind::Sleep;
+    operation.deadline = deadline;
+    return operation;
+}
+
+AsyncOperation sleep_for(AsyncOperation::clock::duration duration)
+{
+    return sleep_until(deadline_after(duration));
+}
+
+static AsyncOperation wait_for_events(int fd, short events, AsyncOperation::clock::duration timeout)
+{
+    AsyncOperation operation;
+    operation.kind = AsyncOperation::Kind::Poll;
+    operation.deadline = deadline_after(timeout);
+    operation.fd = fd;
+    operation.events = events;
+    return operation;
+}
+
+AsyncOperation wait_readable(int fd, AsyncOperation::clock::duration timeout)
+{
+    return wait_for_events(fd, POLLIN, timeout);
+}
+
+AsyncOperation wait_writable(int fd, AsyncOperation::clock::duration timeout)
+{
+    return wait_for_events(fd, POLLOUT, timeout);
+}
+
+AsyncOperation read_file(int fd, void *buffer, size_t length, uint64_t offset)
+{
+    AsyncOperation operation;
+    operation.kind = AsyncOperation::Kind::Read;
+    operation.fd = fd;
+    operation.buffer = buffer;
+    operation.length = length;
+    operation.offset = offset;
+    return operation;
+}
+
+static thread_local IoLoop *current_loop = nullptr;
+
+IoLoop *IoLoop::get_current()
+{
+    return current_loop;
+}
+
+void IoLoop::set_current(IoLoop *loop)
+{
+    current_loop = loop;
+}
@@ -0,0 +1,67 @@
+#ifndef ASYNC_IO_HPP
+#define ASYNC_IO_HPP
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+
+// An operation a coroutine waits on: a timer, readiness of a descriptor, or a
+// file read. It lives in the coroutine's frame while the event loop running
+// the coroutine carries it out, and the loop resumes the coroutine on its own
+// thread when it completes or its deadline passes. Outside a loop, as on
+// blocking workers, the operation is done in place before it returns.
+struct AsyncOperation
+{
+    using clock = std::chrono::steady_clock;
+
+    enum class Kind : uint8_t
+    {
+        Sleep,
+        Poll,
+        Read,
+    };
+
+    Kind kind = Kind::Sleep;
+    // A Sleep ends and a Poll gives up at the deadline; a Read has none.
+    clock::time_point deadline = clock::time_point::max();
+    int fd = -1;
+    // POLLIN or POLLOUT for a Poll.
+    short events = 0;
+    void *buffer = nullptr;
+    size_t length = 0;
+    uint64_t offset = 0;
+
+    std::coroutine_handle<> handle;
+    // A Poll's ready events, 0 once it timed out; a Read's bytes read. Errors
+    // are -errno.
+    int64_t result = 0;
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> awaiting);
+
+    int64_t await_resume() const noexcept
+    {
+        return result;
+    }
+
+    // Does the operation on the calling thread.
+    void run_blocking();
+};
+
+AsyncOperation sleep_until(AsyncOperation::clock::time_point deadline);
+AsyncOperation sleep_for(AsyncOperation::clock::duration duration);
+
+// Resolve to the ready poll events, or 0 when the timeout passes first.
+AsyncOperation wait_readable(int fd, AsyncOperation::clock::duration timeout = AsyncOperation::clock::duration::max());
+AsyncOperation wait_writable(int fd, AsyncOperation::clock::duration timeout = AsyncOperation::clock::duration::max());
+
+// Reads up to length bytes at offset of a file, which may well block under
+// epoll, so the epoll backend reads on a worker; io_uring reads in the kernel.
+AsyncOperation read_file(int fd, void *buffer, size_t length, uint64_t offset);
+
+#endif // ASYNC_IO_HPP
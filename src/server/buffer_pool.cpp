@@ -0,0 +1,247 @@
+#include "server/buffer_pool.hpp"
+#include "server/cpu_topology.hpp"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+BufferPool::Buffer::Buffer(BufferPool *pool)
+    : m_pool(pool),
+      m_data(nullptr),
+      m_size(0),
+      m_capacity(0),
+      m_class(class_count)
+{
+}
+
+BufferPool::Buffer::~Buffer()
+{
+    free_storage();
+}
+
+BufferPool::Buffer::Buffer(Buffer &&other) noexcept
+    : m_pool(other.m_pool),
+      m_data(std::exchange(other.m_data, nullptr)),
+      m_size(std::exchange(other.m_size, 0)),
+      m_capacity(std::exchange(other.m_capacity, 0)),
+      m_class(other.m_class)
+{
+}
+
+BufferPool::Buffer &BufferPool::Buffer::operator=(Buffer &&other) noexcept
+{
+    if (this != &other)
+    {
+        free_storage();
+        m_pool = other.m_pool;
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_capacity = std::exchange(other.m_capacity, 0);
+        m_class = other.m_class;
+    }
+    return *this;
+}
+
+char *BufferPool::Buffer::data()
+{
+    return m_data;
+}
+
+const char *BufferPool::Buffer::data() const
+{
+    return m_data;
+}
+
+size_t BufferPool::Buffer::size() const
+{
+    return m_size;
+}
+
+size_t BufferPool::Buffer::capacity() const
+{
+    return m_capacity;
+}
+
+size_t BufferPool::Buffer::get_free_space() const
+{
+    return m_capacity - m_size;
+}
+
+bool BufferPool::Buffer::empty() const
+{
+    return m_size == 0;
+}
+
+char *BufferPool::Buffer::reserve(size_t min_space)
+{
+    if (get_free_space() >= min_space)
+        return m_data + m_size;
+
+    size_t needed = m_size + min_space;
+    size_t size_class = m_pool ? class_of(needed) : class_count;
+
+    if (size_class < class_count)
+    {
+        replace(m_pool->acquire(size_class), class_sizes[size_class], size_class);
+    }
+    else
+    {
+        size_t capacity = std::max(needed, 2 * m_capacity);
+        replace(new char[capacity], capacity, class_count);
+    }
+
+    return m_data + m_size;
+}
+
+void BufferPool::Buffer::commit(size_t length)
+{
+    m_size += length;
+}
+
+void BufferPool::Buffer::append(const char *data, size_t length)
+{
+    std::memcpy(reserve(length), data, length);
+    m_size += length;
+}
+
+void BufferPool::Buffer::erase_front(size_t length)
+{
+    std::memmove(m_data, m_data + length, m_size - length);
+    m_size -= length;
+}
+
+void BufferPool::Buffer::reset()
+{
+    free_storage();
+    m_data = nullptr;
+    m_size = 0;
+    m_capacity = 0;
+    m_class = class_count;
+}
+
+void BufferPool::Buffer::replace(char *data, size_t capacity, size_t size_class)
+{
+    if (m_size > 0)
+        std::memcpy(data, m_data, m_size);
+
+    free_storage();
+    m_data = data;
+    m_capacity = capacity;
+    m_class = size_class;
+}
+
+void BufferPool::Buffer::free_storage()
+{
+    if (!m_data)
+        return;
+
+    if (m_class < class_count)
+        m_pool->release(m_data, m_class);
+    else
+        delete[] m_data;
+}
+
+BufferPool::BufferPool(bool huge_pages, bool numa_local)
+    : m_huge_pages(huge_pages),
+      m_numa_local(numa_local),
+      m_free(),
+      m_slabs(),
+      m_borrowed(0)
+{
+}
+
+BufferPool::~BufferPool()
+{
+    for (void *slab : m_slabs)
+    {
+#ifdef _WIN32
+        ::operator delete(slab);
+#else
+        munmap(slab, slab_size);
+#endif
+    }
+}
+
+size_t BufferPool::class_of(size_t size)
+{
+    size_t size_class = 0;
+    while (size_class < class_count && class_sizes[size_class] < size)
+        ++size_class;
+    return size_class;
+}
+
+char *BufferPool::acquire(size_t size_class)
+{
+    if (!m_free[size_class])
+        grow(size_class);
+
+    FreeBuffer *buffer = m_free[size_class];
+    m_free[size_class] = buffer->next;
+    ++m_borrowed;
+    return reinterpret_cast<char *>(buffer);
+}
+
+void BufferPool::release(char *buffer, size_t size_class)
+{
+    auto *node = reinterpret_cast<FreeBuffer *>(buffer);
+    node->next = m_free[size_class];
+    m_free[size_class] = node;
+    --m_borrowed;
+}
+
+void BufferPool::grow(size_t size_class)
+{
+#ifdef _WIN32
+    void *slab = ::operator new(slab_size);
+#else
+    void *slab = MAP_FAILED;
+
+    // Explicit huge pages need pages reserved by the administrator; without
+    // them the slab asks for transparent huge pages instead.
+#ifdef MAP_HUGETLB
+    if (m_huge_pages)
+        slab = mmap(nullptr, slab_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+
+    if (slab == MAP_FAILED)
+    {
+        slab = mmap(nullptr, slab_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (slab == MAP_FAILED)
+            throw std::bad_alloc();
+
+#ifdef MADV_HUGEPAGE
+        if (m_huge_pages)
+            madvise(slab, slab_size, MADV_HUGEPAGE);
+#endif
+    }
+
+    // Bound before the free list below touches the slab's pages.
+    if (m_numa_local)
+        bind_to_local_node(slab, slab_size);
+#endif
+
+    m_slabs.push_back(slab);
+
+    // Threaded from the end so buffers are handed out in address order.
+    size_t buffer_size = class_sizes[size_class];
+    for (size_t offset = slab_size; offset >= buffer_size; offset -= buffer_size)
+    {
+        auto *node = reinterpret_cast<FreeBuffer *>(static_cast<char *>(slab) + offset - buffer_size);
+        node->next = m_free[size_class];
+        m_free[size_class] = node;
+    }
+}
+
+size_t BufferPool::get_borrowed_count() const
+{
+    return m_borrowed;
+}
+
+size_t BufferPool::get_slab_count() const
+{
+    return m_slabs.size();
+}
@@ -0,0 +1,93 @@
+#ifndef BUFFER_POOL_HPP
+#define BUFFER_POOL_HPP
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+// Fixed-size I/O buffers in a few size classes, carved out of 2 MiB slabs and
+// recycled through a free list per class, so borrowing and returning a buffer
+// never touches the heap once the pool has grown to the working set. A pool is
+// owned by one thread, an event loop or a blocking worker, and is not locked.
+class BufferPool
+{
+public:
+    static constexpr size_t class_count = 3;
+    static constexpr std::array<size_t, class_count> class_sizes = {4 * 1024, 16 * 1024, 64 * 1024};
+    static constexpr size_t slab_size = 2 * 1024 * 1024;
+
+    // A growable byte buffer whose storage is borrowed from a pool. It holds no
+    // storage until bytes are reserved and gives it back on reset; past the
+    // largest size class it falls back to the heap.
+    class Buffer
+    {
+    private:
+        BufferPool *m_pool;
+        char *m_data;
+        size_t m_size;
+        size_t m_capacity;
+        size_t m_class;
+
+        void replace(char *data, size_t capacity, size_t size_class);
+        void free_storage();
+
+    public:
+        explicit Buffer(BufferPool *pool = nullptr);
+        ~Buffer();
+
+        Buffer(const Buffer &) = delete;
+        Buffer &operator=(const Buffer &) = delete;
+
+        Buffer(Buffer &&other) noexcept;
+        Buffer &operator=(Buffer &&other) noexcept;
+
+        char *data();
+        const char *data() const;
+        size_t size() const;
+        size_t capacity() const;
+        size_t get_free_space() const;
+        bool empty() const;
+
+        // Room for at least min_space more bytes at the end, moving into a
+        // larger class when needed; the bytes written there count once committed.
+        char *reserve(size_t min_space);
+        void commit(size_t length);
+        void append(const char *data, size_t length);
+        void erase_front(size_t length);
+        void reset();
+    };
+
+private:
+    struct FreeBuffer
+    {
+        FreeBuffer *next;
+    };
+
+    bool m_huge_pages;
+    bool m_numa_local;
+    std::array<FreeBuffer *, class_count> m_free;
+    std::vector<void *> m_slabs;
+    size_t m_borrowed;
+
+    void grow(size_t size_class);
+
+public:
+    // With numa_local, slabs prefer the NUMA node of the CPU the pool's thread
+    // runs on when they are mapped; meant for threads pinned to one node.
+    explicit BufferPool(bool huge_pages = false, bool numa_local = false);
+    ~BufferPool();
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    // Smallest class holding size bytes, or class_count when none does.
+    static size_t class_of(size_t size);
+
+    char *acquire(size_t size_class);
+    void release(char *buffer, size_t size_class);
+
+    size_t get_borrowed_count() const;
+    size_t get_slab_count() const;
+};
+
+#endif // BUFFER_POOL_HPP
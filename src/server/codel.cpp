@@ -0,0 +1,75 @@
+#include "server/codel.hpp"
+#include <cmath>
+
+CoDel::CoDel(clock::duration target, clock::duration interval)
+    : m_target(target),
+      m_interval(interval),
+      m_first_above(),
+      m_drop_next(),
+      m_dropping(false),
+      m_count(0),
+      m_last_count(0)
+{
+}
+
+// True once the sojourn has been above the target for a whole interval. The
+// last item in the queue is never dropped, since the queue is draining.
+bool CoDel::is_standing(clock::duration sojourn, clock::time_point now, size_t remaining)
+{
+    if (sojourn < m_target || remaining == 0)
+    {
+        m_first_above = clock::time_point();
+        return false;
+    }
+
+    if (m_first_above == clock::time_point())
+    {
+        m_first_above = now + m_interval;
+        return false;
+    }
+
+    return now >= m_first_above;
+}
+
+CoDel::clock::time_point CoDel::control_law(clock::time_point time) const
+{
+    return time + std::chrono::duration_cast<clock::duration>(m_interval / std::sqrt(static_cast<double>(m_count)));
+}
+
+bool CoDel::should_drop(clock::duration sojourn, clock::time_point now, size_t remaining)
+{
+    bool standing = is_standing(sojourn, now, remaining);
+
+    if (m_dropping)
+    {
+        if (!standing)
+        {
+            m_dropping = false;
+            return false;
+        }
+
+        if (now < m_drop_next)
+            return false;
+
+        ++m_count;
+        m_drop_next = control_law(m_drop_next);
+        return true;
+    }
+
+    if (!standing)
+        return false;
+
+    // Re-entering the dropping state soon after leaving it resumes near the
+    // previous drop rate instead of starting over.
+    m_dropping = true;
+    uint32_t delta = m_count - m_last_count;
+    m_count = delta > 1 && now - m_drop_next < 16 * m_interval ? delta : 1;
+    m_last_count = m_count;
+    m_drop_next = control_law(now);
+    return true;
+}
+
+bool CoDel::is_dropping() const
+{
+    return m_dropping;
+}
@@ -0,0 +1,38 @@
+#ifndef CODEL_HPP
+#define CODEL_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// CoDel (RFC 8289) decides from the time each item spent queued, its sojourn,
+// whether to drop it. A queue that drains within the target delay is never
+// touched, however deep a burst makes it; once the sojourn has stayed above
+// the target for a whole interval, items are dropped at a rate that rises with
+// the square root of the drops until the sojourn falls below the target again.
+class CoDel
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+private:
+    clock::duration m_target;
+    clock::duration m_interval;
+    clock::time_point m_first_above;
+    clock::time_point m_drop_next;
+    bool m_dropping;
+    uint32_t m_count;
+    uint32_t m_last_count;
+
+    bool is_standing(clock::duration sojourn, clock::time_point now, size_t remaining);
+    clock::time_point control_law(clock::time_point time) const;
+
+public:
+    CoDel(clock::duration target, clock::duration interval);
+
+    // Called for each item as it leaves the queue, with the number still queued behind it.
+    bool should_drop(clock::duration sojourn, clock::time_point now, size_t remaining);
+    bool is_dropping() const;
+};
+
+#endif // CODEL_HPP
@@ -0,0 +1,454 @@
+#include "helpers.hpp"
+#include "server/connection.hpp"
+#include <cstring>
+#include <stdexcept>
+
+Connection::Connection(uint64_t id, SocketWrapper socket, BufferPool &buffer_pool, size_t max_header_size,
+                       size_t max_body_size, size_t max_streamed_body_size, size_t output_high_water_mark)
+    : m_id(id),
+      m_socket(std::move(socket)),
+      m_buffer_pool(&buffer_pool),
+      m_state(ConnectionState::Reading),
+      m_input(&buffer_pool),
+      m_input_offset(0),
+      m_max_input_size(max_header_size + pipeline_input_allowance),
+      m_parser(max_header_size, max_body_size, max_streamed_body_size),
+      m_parse_error(),
+      m_router(nullptr),
+      m_output(),
+      m_output_offset(0),
+      m_output_size(0),
+      m_output_high_water_mark(output_high_water_mark),
+      m_body_stream(),
+      m_body_file(),
+      m_file_offset(0),
+      m_deferred_responses(),
+      m_producing_body(false),
+      m_corked(false),
+      m_last_output_progress(std::chrono::steady_clock::now()),
+      m_peer_closed(false),
+      m_keep_alive(false),
+      m_requests_served(0),
+      m_last_activity(std::chrono::steady_clock::now()),
+      m_request_start(m_last_activity),
+      m_timer(id)
+{
+}
+
+uint64_t Connection::get_id() const
+{
+    return m_id;
+}
+
+socket_t Connection::get_fd() const
+{
+    return m_socket.get();
+}
+
+const PeerAddress &Connection::get_peer() const
+{
+    return m_peer;
+}
+
+void Connection::set_peer(const PeerAddress &peer)
+{
+    m_peer = peer;
+}
+
+ConnectionState Connection::get_state() const
+{
+    return m_state;
+}
+
+void Connection::set_state(ConnectionState state)
+{
+    m_state = state;
+}
+
+bool Connection::is_peer_closed() const
+{
+    return m_peer_closed;
+}
+
+void Connection::set_peer_closed()
+{
+    m_peer_closed = true;
+}
+
+bool Connection::is_keep_alive() const
+{
+    return m_keep_alive;
+}
+
+void Connection::set_keep_alive(bool keep_alive)
+{
+    m_keep_alive = keep_alive;
+}
+
+size_t Connection::get_requests_served() const
+{
+    return m_requests_served;
+}
+
+void Connection::count_requests(size_t count)
+{
+    m_requests_served += count;
+}
+
+std::chrono::steady_clock::time_point Connection::get_last_activity() const
+{
+    return m_last_activity;
+}
+
+void Connection::touch()
+{
+    m_last_activity = std::chrono::steady_clock::now();
+}
+
+std::chrono::steady_clock::time_point Connection::get_request_start() const
+{
+    return m_request_start;
+}
+
+ReadPhase Connection::get_read_phase() const
+{
+    if (m_parser.is_reading_body())
+        return ReadPhase::Body;
+    return has_partial_request() ? ReadPhase::Headers : ReadPhase::Idle;
+}
+
+bool Connection::is_idle_keep_alive() const
+{
+    return m_state == ConnectionState::Reading && m_requests_served > 0 && get_read_phase() == ReadPhase::Idle;
+}
+
+TimerWheel::Timer &Connection::get_timer()
+{
+    return m_timer;
+}
+
+void Connection::set_router(const Router *router)
+{
+    m_router = router;
+}
+
+// Parsed bytes ahead of pipelined input are dropped before the buffer grows.
+void Connection::compact_input(size_t length)
+{
+    if (m_input_offset > 0 && m_input.get_free_space() < length)
+    {
+        m_input.erase_front(m_input_offset);
+        m_input_offset = 0;
+    }
+}
+
+char *Connection::reserve_input(size_t &length)
+{
+    compact_input(read_size);
+    char *space = m_input.reserve(read_size);
+    length = m_input.get_free_space();
+    return space;
+}
+
+void Connection::commit_input(size_t length)
+{
+    if (!has_partial_request())
+        m_request_start = std::chrono::steady_clock::now();
+
+    m_input.commit(length);
+}
+
+void Connection::append_input(const char *data, size_t length)
+{
+    if (!has_partial_request())
+        m_request_start = std::chrono::steady_clock::now();
+
+    compact_input(length);
+    m_input.append(data, length);
+}
+
+size_t Connection::get_input_size() const
+{
+    return m_input.size() - m_input_offset;
+}
+
+bool Connection::is_input_full() const
+{
+    return get_input_size() > m_max_input_size;
+}
+
+bool Connection::has_partial_request() const
+{
+    return get_input_size() > 0 || !m_parser.is_idle();
+}
+
+bool Connection::extract_request(HttpRequest &request)
+{
+    // A parse error leaves the stream unusable; keep reporting it until the connection closes.
+    if (m_parse_error)
+        std::rethrow_exception(m_parse_error);
+
+    ParseStatus status;
+
+    try
+    {
+        do
+        {
+            size_t consumed;
+            status = m_parser.feed(m_input.data() + m_input_offset, m_input.size() - m_input_offset, consumed);
+            m_input_offset += consumed;
+
+            if (status == ParseStatus::HeadersComplete && m_router)
+                m_parser.set_body_sink(m_router->open_body_sink(m_parser.get_request()));
+        } while (status == ParseStatus::HeadersComplete);
+    }
+    catch (const std::exception &)
+    {
+        m_parse_error = std::current_exception();
+        throw;
+    }
+
+    // The parser keeps partial lines and bodies itself, so once all input is
+    // consumed the buffer goes back to the pool.
+    if (m_input_offset == m_input.size())
+    {
+        m_input.reset();
+        m_input_offset = 0;
+    }
+
+    if (status != ParseStatus::MessageComplete)
+        return false;
+
+    request = m_parser.take_request();
+
+    // Pipelined bytes already buffered start the next request.
+    if (get_input_size() > 0)
+        m_request_start = std::chrono::steady_clock::now();
+
+    return true;
+}
+
+size_t Connection::extract_requests(std::vector<HttpRequest> &requests, size_t max_requests)
+{
+    HttpRequest request;
+
+    while (requests.size() < max_requests)
+    {
+        // A malformed request behind complete ones is reported once the
+        // requests before it have been answered.
+        try
+        {
+            if (!extract_request(request))
+                break;
+        }
+        catch (const std::exception &)
+        {
+            if (requests.empty())
+                throw;
+            break;
+        }
+
+        requests.push_back(std::move(request));
+    }
+
+    return requests.size();
+}
+
+void Connection::queue_response(HttpResponse response)
+{
+    if (m_body_stream || m_body_file || !m_deferred_responses.empty() || is_output_full())
+    {
+        m_deferred_responses.push_back(std::move(response));
+        return;
+    }
+
+    write_response(std::move(response));
+}
+
+void Connection::write_response(HttpResponse response)
+{
+    if (!has_pending_output())
+        m_last_output_progress = std::chrono::steady_clock::now();
+
+    const std::string &body = response.get_body();
+    size_t head_size = response.get_head_size();
+    size_t copied_size = head_size + (body.size() <= max_copied_body_size ? body.size() : 0);
+
+    char *out = response.write_head(reserve_output(copied_size));
+    if (copied_size > head_size)
+        std::memcpy(out, body.data(), body.size());
+
+    m_output.back().buffer.commit(copied_size);
+    m_output_size += copied_size;
+
+    if (copied_size == head_size && !body.empty())
+        m_output_size += m_output.emplace_back(OutputSegment{BufferPool::Buffer(), response.take_body()}).size();
+
+    if (response.is_streaming())
+    {
+        size_t content_length;
+        BodyFraming framing = ResponseStream::framing_of(response, content_length);
+        m_body_stream = std::make_shared<ResponseStream>(response.get_body_stream(), framing, content_length);
+    }
+    else if (response.get_body_file() && response.get_body_file()->get_size() > 0)
+    {
+        m_body_file = response.get_body_file();
+        m_file_offset = 0;
+    }
+}
+
+// Room for length bytes at the end of the last pooled segment, or of a new one.
+char *Connection::reserve_output(size_t length)
+{
+    if (m_output.empty() || !m_output.back().body.empty() || m_output.back().buffer.get_free_space() < length)
+        m_output.push_back(OutputSegment{BufferPool::Buffer(m_buffer_pool), std::string()});
+
+    return m_output.back().buffer.reserve(length);
+}
+
+void Connection::release_deferred_responses()
+{
+    while (!m_deferred_responses.empty() && !m_body_stream && !m_body_file && !is_output_full())
+    {
+        HttpResponse response = std::move(m_deferred_responses.front());
+        m_deferred_responses.pop_front();
+        write_response(std::move(response));
+    }
+}
+
+std::shared_ptr<ResponseStream> Connection::get_body_stream() const
+{
+    return m_body_stream;
+}
+
+void Connection::queue_body_output(std::string output)
+{
+    if (!has_pending_output())
+        m_last_output_progress = std::chrono::steady_clock::now();
+
+    if (!output.empty())
+        m_output_size += m_output.emplace_back(OutputSegment{BufferPool::Buffer(), std::move(output)}).size();
+
+    if (!m_body_stream || !m_body_stream->is_finished())
+        return;
+
+    m_body_stream.reset();
+    release_deferred_responses();
+}
+
+bool Connection::is_producing_body() const
+{
+    return m_producing_body;
+}
+
+void Connection::set_producing_body(bool producing)
+{
+    m_producing_body = producing;
+}
+
+bool Connection::is_corked() const
+{
+    return m_corked;
+}
+
+void Connection::set_corked(bool corked)
+{
+    m_corked = corked;
+}
+
+const FileBody *Connection::get_body_file() const
+{
+    return m_body_file.get();
+}
+
+size_t Connection::get_file_offset() const
+{
+    return m_file_offset;
+}
+
+size_t Connection::get_pending_file_size() const
+{
+    return m_body_file ? m_body_file->get_size() - m_file_offset : 0;
+}
+
+void Connection::consume_file_output(size_t length)
+{
+    m_file_offset += length;
+    m_last_output_progress = std::chrono::steady_clock::now();
+
+    if (m_file_offset < m_body_file->get_size())
+        return;
+
+    m_body_file.reset();
+    m_file_offset = 0;
+    release_deferred_responses();
+}
+
+bool Connection::has_pending_file_output() const
+{
+    return m_body_file != nullptr;
+}
+
+#ifdef _WIN32
+const char *Connection::get_pending_segment() const
+{
+    return m_output.front().data() + m_output_offset;
+}
+
+size_t Connection::get_pending_segment_size() const
+{
+    return m_output.front().size() - m_output_offset;
+}
+#else
+size_t Connection::get_output_iovecs(struct iovec *vectors, size_t max_vectors) const
+{
+    size_t count = 0;
+    size_t offset = m_output_offset;
+
+    for (auto it = m_output.begin(); it != m_output.end() && count < max_vectors; ++it)
+    {
+        vectors[count].iov_base = const_cast<char *>(it->data() + offset);
+        vectors[count].iov_len = it->size() - offset;
+        offset = 0;
+        ++count;
+    }
+
+    return count;
+}
+#endif
+
+size_t Connection::get_pending_output_size() const
+{
+    return m_output_size;
+}
+
+void Connection::consume_output(size_t length)
+{
+    m_output_size -= length;
+    m_last_output_progress = std::chrono::steady_clock::now();
+    m_output_offset += length;
+
+    while (!m_output.empty() && m_output_offset >= m_output.front().size())
+    {
+        m_output_offset -= m_output.front().size();
+        m_output.pop_front();
+    }
+
+    if (!m_deferred_responses.empty())
+        release_deferred_responses();
+}
+
+bool Connection::has_pending_output() const
+{
+    return m_output_size > 0;
+}
+
+bool Connection::is_output_full() const
+{
+    return has_pending_output() && m_output_size >= m_output_high_water_mark;
+}
+
+std::chrono::steady_clock::time_point Connection::get_last_output_progress() const
+{
+    return m_last_output_progress;
+}
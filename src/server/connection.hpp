@@ -0,0 +1,201 @@
+#ifndef CONNECTION_HPP
+#define CONNECTION_HPP
+
+#include "http/httprequest.hpp"
+#include "http/httprequestparser.hpp"
+#include "http/httpresponse.hpp"
+#include "access_log.hpp"
+#include "buffer_pool.hpp"
+#include "response_stream.hpp"
+#include "router.hpp"
+#include "socket_wrapper.hpp"
+#include "timer_wheel.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
+
+enum class ConnectionState
+{
+    Reading,
+    Processing,
+    Writing,
+    Closed,
+};
+
+// Where a Reading connection is in its next request
+enum class ReadPhase
+{
+    Idle,
+    Headers,
+    Body,
+};
+
+// A run of pending output: response heads and small bodies copied into a
+// pooled buffer, or a larger body moved in from its response.
+struct OutputSegment
+{
+    BufferPool::Buffer buffer;
+    std::string body;
+
+    const char *data() const { return body.empty() ? buffer.data() : body.data(); }
+    size_t size() const { return body.empty() ? buffer.size() : body.size(); }
+};
+
+// Where a batch of requests came from and when it was dispatched, for the
+// access log.
+struct RequestOrigin
+{
+    PeerAddress peer;
+    std::chrono::steady_clock::time_point dispatched;
+};
+
+class Connection
+{
+private:
+    uint64_t m_id;
+    SocketWrapper m_socket;
+    BufferPool *m_buffer_pool;
+    ConnectionState m_state;
+    BufferPool::Buffer m_input;
+    size_t m_input_offset;
+    size_t m_max_input_size;
+    HttpRequestParser m_parser;
+    std::exception_ptr m_parse_error;
+    const Router *m_router;
+    std::deque<OutputSegment> m_output;
+    size_t m_output_offset;
+    size_t m_output_size;
+    size_t m_output_high_water_mark;
+    std::shared_ptr<ResponseStream> m_body_stream;
+    std::shared_ptr<FileBody> m_body_file;
+    size_t m_file_offset;
+    std::deque<HttpResponse> m_deferred_responses;
+    bool m_producing_body;
+    bool m_corked;
+    std::chrono::steady_clock::time_point m_last_output_progress;
+
+    void write_response(HttpResponse response);
+    void release_deferred_responses();
+    void compact_input(size_t length);
+    char *reserve_output(size_t length);
+    bool m_peer_closed;
+    bool m_keep_alive;
+    size_t m_requests_served;
+    std::chrono::steady_clock::time_point m_last_activity;
+    std::chrono::steady_clock::time_point m_request_start;
+    TimerWheel::Timer m_timer;
+    PeerAddress m_peer;
+
+public:
+    static constexpr size_t max_pipeline_depth = 32;
+    static constexpr size_t max_output_vectors = 64;
+    static constexpr size_t read_size = 4096;
+    // Unparsed input allowed beyond one request head, for pipelined requests.
+    static constexpr size_t pipeline_input_allowance = 64 * 1024;
+    static constexpr size_t max_copied_body_size = 4096;
+    static constexpr size_t default_output_high_water_mark = 256 * 1024;
+
+    Connection(uint64_t id, SocketWrapper socket, BufferPool &buffer_pool,
+               size_t max_header_size = HttpRequestParser::default_max_header_size,
+               size_t max_body_size = HttpRequestParser::default_max_body_size,
+               size_t max_streamed_body_size = 0,
+               size_t output_high_water_mark = default_output_high_water_mark);
+
+    Connection(const Connection &) = delete;
+    Connection &operator=(const Connection &) = delete;
+
+    uint64_t get_id() const;
+    socket_t get_fd() const;
+
+    // Set only while access records are kept.
+    const PeerAddress &get_peer() const;
+    void set_peer(const PeerAddress &peer);
+
+    ConnectionState get_state() const;
+    void set_state(ConnectionState state);
+
+    bool is_peer_closed() const;
+    void set_peer_closed();
+
+    bool is_keep_alive() const;
+    void set_keep_alive(bool keep_alive);
+
+    size_t get_requests_served() const;
+    void count_requests(size_t count);
+
+    std::chrono::steady_clock::time_point get_last_activity() const;
+    void touch();
+
+    // Time the first byte of the current request arrived, or the connection
+    // was accepted while no request has been started.
+    std::chrono::steady_clock::time_point get_request_start() const;
+    ReadPhase get_read_phase() const;
+    // A persistent connection waiting for its next request, which can be
+    // closed without losing one.
+    bool is_idle_keep_alive() const;
+    // Deadline timer for an event loop's wheel; its owner is the connection id.
+    TimerWheel::Timer &get_timer();
+
+    // Lets streaming routes of router consume request bodies as they arrive.
+    void set_router(const Router *router);
+
+    // Input is read into a buffer borrowed from the pool, which goes back as
+    // soon as every byte in it has been parsed; an idle connection holds none.
+    char *reserve_input(size_t &length);
+    void commit_input(size_t length);
+    void append_input(const char *data, size_t length);
+    size_t get_input_size() const;
+    // More unparsed input than a request head plus the pipelining allowance;
+    // the connection should be closed rather than buffer more.
+    bool is_input_full() const;
+    bool has_partial_request() const;
+    bool extract_request(HttpRequest &request);
+    size_t extract_requests(std::vector<HttpRequest> &requests, size_t max_requests = max_pipeline_depth);
+
+    // Responses queued behind a streamed or file body wait until that body is
+    // complete, and responses queued while the pending output is at the
+    // high-water mark wait until it drains below it.
+    void queue_response(HttpResponse response);
+    std::shared_ptr<ResponseStream> get_body_stream() const;
+    void queue_body_output(std::string output);
+    bool is_producing_body() const;
+    void set_producing_body(bool producing);
+    bool is_corked() const;
+    void set_corked(bool corked);
+
+    // A file body is sent after the pending output, straight from its descriptor.
+    const FileBody *get_body_file() const;
+    size_t get_file_offset() const;
+    size_t get_pending_file_size() const;
+    void consume_file_output(size_t length);
+    bool has_pending_file_output() const;
+    // Pending output is a queue of segments. Heads and bodies of up to
+    // max_copied_body_size share pooled buffers, appended to only within their
+    // capacity so bytes already handed to the kernel never move; larger bodies
+    // are moved in as segments of their own.
+#ifdef _WIN32
+    const char *get_pending_segment() const;
+    size_t get_pending_segment_size() const;
+#else
+    size_t get_output_iovecs(struct iovec *vectors, size_t max_vectors) const;
+#endif
+    size_t get_pending_output_size() const;
+    void consume_output(size_t length);
+    bool has_pending_output() const;
+    bool is_output_full() const;
+
+    // Time output was last queued into an empty queue or partly sent; a stalled
+    // reader is detected by this not advancing while output is pending.
+    std::chrono::steady_clock::time_point get_last_output_progress() const;
+};
+
+#endif // CONNECTION_HPP
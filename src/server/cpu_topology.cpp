@@ -0,0 +1,329 @@
+#include "server/cpu_topology.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+CpuSet parse_cpu_list(const std::string &list)
+{
+    std::set<int> cpus;
+    std::stringstream stream(list);
+    std::string range;
+
+    while (std::getline(stream, range, ','))
+    {
+        size_t dash = range.find('-');
+        size_t first_end = 0;
+        size_t last_end = 0;
+        int first = 0;
+        int last = 0;
+
+        try
+        {
+            first = std::stoi(range.substr(0, dash), &first_end);
+            last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1), &last_end);
+        }
+        catch (const std::exception &)
+        {
+            throw std::invalid_argument("Invalid CPU list: " + list);
+        }
+
+        bool trailing = first_end != range.substr(0, dash).size() ||
+                        (dash != std::string::npos && last_end != range.size() - dash - 1);
+        if (trailing || first < 0 || last < first)
+            throw std::invalid_argument("Invalid CPU list: " + list);
+
+        for (int cpu = first; cpu <= last; ++cpu)
+            cpus.insert(cpu);
+    }
+
+    if (cpus.empty())
+        throw std::invalid_argument("Invalid CPU list: " + list);
+
+    return CpuSet(cpus.begin(), cpus.end());
+}
+
+std::vector<CpuSet> parse_cpu_sets(const std::string &lists)
+{
+    std::vector<CpuSet> sets;
+    std::stringstream stream(lists);
+    std::string list;
+
+    while (std::getline(stream, list, ';'))
+        sets.push_back(parse_cpu_list(list));
+
+    if (sets.empty())
+        throw std::invalid_argument("Invalid CPU list: " + lists);
+
+    return sets;
+}
+
+std::string format_cpu_list(const CpuSet &cpus)
+{
+    std::string list;
+
+    for (size_t i = 0; i < cpus.size();)
+    {
+        size_t end = i;
+        while (end + 1 < cpus.size() && cpus[end + 1] == cpus[end] + 1)
+            ++end;
+
+        if (!list.empty())
+            list += ',';
+        list += std::to_string(cpus[i]);
+        if (end > i)
+            list += '-' + std::to_string(cpus[end]);
+
+        i = end + 1;
+    }
+
+    return list;
+}
+
+CpuSet get_allowed_cpus()
+{
+    CpuSet allowed;
+
+#ifdef __linux__
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+
+    if (sched_getaffinity(0, sizeof(cpus), &cpus) == 0)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &cpus))
+                allowed.push_back(cpu);
+        }
+    }
+#endif
+
+    if (allowed.empty())
+    {
+        for (unsigned cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu)
+            allowed.push_back(static_cast<int>(cpu));
+    }
+
+    return allowed;
+}
+
+// Read once from sysfs; NUMA nodes do not change while the server runs.
+static std::map<int, int> read_numa_nodes()
+{
+    std::map<int, int> nodes;
+
+#ifdef __linux__
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator("/sys/devices/system/node", error))
+    {
+        std::string name = entry.path().filename().string();
+        if (name.rfind("node", 0) != 0 || name.size() == 4 ||
+            name.find_first_not_of("0123456789", 4) != std::string::npos)
+            continue;
+
+        std::ifstream file(entry.path() / "cpulist");
+        std::string list;
+        if (!std::getline(file, list) || list.empty())
+            continue;
+
+        try
+        {
+            for (int cpu : parse_cpu_list(list))
+                nodes[cpu] = std::stoi(name.substr(4));
+        }
+        catch (const std::invalid_argument &)
+        {
+        }
+    }
+#endif
+
+    return nodes;
+}
+
+int get_numa_node(int cpu)
+{
+    static const std::map<int, int> nodes = read_numa_nodes();
+
+    auto node = nodes.find(cpu);
+    return node == nodes.end() ? -1 : node->second;
+}
+
+bool set_thread_affinity(std::thread &thread, const CpuSet &cpus)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+
+    for (int cpu : cpus)
+    {
+        if (cpu >= CPU_SETSIZE)
+            return false;
+        CPU_SET(cpu, &set);
+    }
+
+    return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+#else
+    (void)thread;
+    (void)cpus;
+    return false;
+#endif
+}
+
+CpuSet get_thread_affinity(std::thread &thread)
+{
+    CpuSet affinity;
+
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+
+    if (pthread_getaffinity_np(thread.native_handle(), sizeof(set), &set) == 0)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &set))
+                affinity.push_back(cpu);
+        }
+    }
+#else
+    (void)thread;
+#endif
+
+    return affinity;
+}
+
+bool bind_to_local_node(void *memory, size_t size)
+{
+#ifdef __linux__
+    int node = get_numa_node(sched_getcpu());
+    if (node < 0)
+        return false;
+
+    // MPOL_PREFERRED falls back to other nodes when this one runs out of memory.
+    constexpr size_t word_bits = sizeof(unsigned long) * 8;
+    std::vector<unsigned long> mask(static_cast<size_t>(node) / word_bits + 1, 0);
+    mask[static_cast<size_t>(node) / word_bits] |= 1ul << (static_cast<size_t>(node) % word_bits);
+
+    return syscall(SYS_mbind, memory, size, MPOL_PREFERRED, mask.data(), mask.size() * word_bits + 1, 0) == 0;
+#else
+    (void)memory;
+    (void)size;
+    return false;
+#endif
+}
+
+ThreadPlacement plan_thread_placement(const ThreadTopology &topology, size_t io_threads, bool steer_shards,
+                                      const CpuSet &allowed)
+{
+    ThreadPlacement placement;
+    unsigned hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_t i = 0; i < io_threads; ++i)
+    {
+        if (!topology.io_cpus.empty())
+            placement.io_cpus.push_back(topology.io_cpus[i % topology.io_cpus.size()]);
+        else if (steer_shards)
+            placement.io_cpus.push_back({static_cast<int>(i % hardware_threads)});
+        else if (topology.isolate_io_threads && !allowed.empty())
+            placement.io_cpus.push_back({allowed[i % allowed.size()]});
+        else
+            placement.io_cpus.emplace_back();
+    }
+
+    // CPUs left to workers once the I/O threads' CPUs are set aside.
+    CpuSet worker_pool = allowed;
+    if (topology.isolate_io_threads && io_threads > 0)
+    {
+        std::set<int> io_cpus;
+        for (const CpuSet &cpus : placement.io_cpus)
+            io_cpus.insert(cpus.begin(), cpus.end());
+
+        worker_pool.erase(std::remove_if(worker_pool.begin(), worker_pool.end(), [&io_cpus](int cpu)
+                                         { return io_cpus.count(cpu) > 0; }),
+                          worker_pool.end());
+
+        if (worker_pool.empty())
+        {
+            placement.isolation_failed = true;
+            worker_pool = allowed;
+        }
+    }
+
+    size_t workers = topology.workers > 0 ? topology.workers : std::max<size_t>(1, worker_pool.size());
+    bool isolated = topology.isolate_io_threads && io_threads > 0 && !placement.isolation_failed;
+
+    for (size_t i = 0; i < workers; ++i)
+    {
+        if (!topology.worker_cpus.empty())
+            placement.worker_cpus.push_back(topology.worker_cpus[i % topology.worker_cpus.size()]);
+        else if (topology.pin_workers && !worker_pool.empty())
+            placement.worker_cpus.push_back({worker_pool[i % worker_pool.size()]});
+        else if (isolated)
+            placement.worker_cpus.push_back(worker_pool);
+        else
+            placement.worker_cpus.emplace_back();
+    }
+
+    return placement;
+}
+
+static std::string describe_cpus(const CpuSet &cpus)
+{
+    if (cpus.empty())
+        return "unpinned";
+
+    std::set<int> nodes;
+    for (int cpu : cpus)
+        nodes.insert(get_numa_node(cpu));
+
+    std::string description = (cpus.size() == 1 ? "CPU " : "CPUs ") + format_cpu_list(cpus);
+    if (nodes.count(-1) == 0)
+    {
+        CpuSet node_list(nodes.begin(), nodes.end());
+        description += (nodes.size() == 1 ? " (node " : " (nodes ") + format_cpu_list(node_list) + ")";
+    }
+
+    return description;
+}
+
+static void describe_threads(std::string &report, const char *kind, const std::vector<CpuSet> &threads)
+{
+    for (size_t i = 0; i < threads.size();)
+    {
+        size_t end = i;
+        while (end + 1 < threads.size() && threads[end + 1] == threads[i])
+            ++end;
+
+        report += "  ";
+        report += kind;
+        report += end > i ? "s " + std::to_string(i) + "-" + std::to_string(end) : " " + std::to_string(i);
+        report += ": " + describe_cpus(threads[i]) + "\n";
+
+        i = end + 1;
+    }
+}
+
+std::string format_thread_placement(const ThreadPlacement &placement)
+{
+    std::string report = "Thread placement: " + std::to_string(placement.io_cpus.size()) + " I/O thread(s), " +
+                         std::to_string(placement.worker_cpus.size()) + " worker(s)\n";
+
+    describe_threads(report, "I/O thread", placement.io_cpus);
+    describe_threads(report, "worker", placement.worker_cpus);
+
+    if (placement.isolation_failed)
+        report += "  I/O threads are not isolated: no CPU is left to the workers\n";
+
+    return report;
+}
@@ -0,0 +1,54 @@
+#ifndef CPU_TOPOLOGY_HPP
+#define CPU_TOPOLOGY_HPP
+
+#include "server_config.hpp"
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+// CPU sets chosen for each of the server's threads; an empty set leaves the
+// thread unpinned.
+struct ThreadPlacement
+{
+    std::vector<CpuSet> io_cpus;
+    std::vector<CpuSet> worker_cpus;
+    // Set when isolation was asked for but no CPU was left to the workers.
+    bool isolation_failed = false;
+
+    size_t get_worker_count() const
+    {
+        return worker_cpus.size();
+    }
+};
+
+// Parses a kernel-style CPU list such as "0-3,8"; throws std::invalid_argument
+// when it is malformed or empty.
+CpuSet parse_cpu_list(const std::string &list);
+// Parses CPU lists separated by ';', one per thread, such as "0-3;4-7".
+std::vector<CpuSet> parse_cpu_sets(const std::string &lists);
+// Formats sorted CPUs back into ranges, "0-3,8".
+std::string format_cpu_list(const CpuSet &cpus);
+
+// CPUs this process may run on.
+CpuSet get_allowed_cpus();
+// NUMA node of a CPU, or -1 when the system does not say.
+int get_numa_node(int cpu);
+
+bool set_thread_affinity(std::thread &thread, const CpuSet &cpus);
+CpuSet get_thread_affinity(std::thread &thread);
+
+// Makes the kernel prefer the NUMA node of the calling thread's CPU for pages
+// of memory not touched yet; false when it cannot.
+bool bind_to_local_node(void *memory, size_t size);
+
+// Resolves the topology into a CPU set per thread. io_threads is 0 when
+// connections are handled on the calling thread; steer_shards pins I/O thread
+// i to CPU i, where reuseport CPU steering sends its connections.
+ThreadPlacement plan_thread_placement(const ThreadTopology &topology, size_t io_threads, bool steer_shards,
+                                      const CpuSet &allowed);
+
+// One line per run of threads with the same CPU set and NUMA nodes.
+std::string format_thread_placement(const ThreadPlacement &placement);
+
+#endif // CPU_TOPOLOGY_HPP
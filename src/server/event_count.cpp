@@ -0,0 +1,66 @@
+#include "server/event_count.hpp"
+#include <climits>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+uint32_t EventCount::prepare_wait()
+{
+    m_waiters.fetch_add(1, std::memory_order_seq_cst);
+
+    // Orders the announcement before the caller's last look at the queue.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return m_epoch.load(std::memory_order_acquire);
+}
+
+void EventCount::cancel_wait()
+{
+    m_waiters.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void EventCount::wait(uint32_t epoch)
+{
+#ifdef __linux__
+    // Returns at once if the epoch already moved on; spurious wakeups are
+    // fine, since the caller looks at its queue again.
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&m_epoch), FUTEX_WAIT_PRIVATE, epoch, nullptr, nullptr, 0);
+#else
+    m_epoch.wait(epoch, std::memory_order_acquire);
+#endif
+
+    m_waiters.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool EventCount::notify_one()
+{
+    return wake(false);
+}
+
+bool EventCount::notify_all()
+{
+    return wake(true);
+}
+
+bool EventCount::wake(bool all)
+{
+    // Orders the producer's push before its look at the waiters.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_waiters.load(std::memory_order_relaxed) == 0)
+        return false;
+
+    m_epoch.fetch_add(1, std::memory_order_release);
+
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&m_epoch), FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1, nullptr, nullptr, 0);
+#else
+    if (all)
+        m_epoch.notify_all();
+    else
+        m_epoch.notify_one();
+#endif
+
+    return true;
+}
@@ -0,0 +1,30 @@
+#ifndef EVENT_COUNT_HPP
+#define EVENT_COUNT_HPP
+
+#include <atomic>
+#include <cstdint>
+
+// Lets consumers of a lock-free queue sleep without the producers taking a
+// lock. A consumer announces itself with prepare_wait, checks the queue once
+// more and only then waits for the epoch to move on; a producer bumps the
+// epoch and wakes someone only if a consumer has announced itself, so the
+// fast path is a load. Waiting is a futex on Linux and std::atomic::wait elsewhere.
+class EventCount
+{
+private:
+    std::atomic<uint32_t> m_epoch{0};
+    std::atomic<uint32_t> m_waiters{0};
+
+    bool wake(bool all);
+
+public:
+    uint32_t prepare_wait();
+    void cancel_wait();
+    void wait(uint32_t epoch);
+
+    // True if a waiter had announced itself and was woken.
+    bool notify_one();
+    bool notify_all();
+};
+
+#endif // EVENT_COUNT_HPP
@@ -0,0 +1,768 @@
+#ifdef __linux__
+
+#include "server/event_loop.hpp"
+#include "server/httpserver.hpp"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static HttpResponse make_bad_request_response()
+{
+    HttpResponse response;
+    response.set_code(HttpCode::BadRequest);
+    response.add_header("Content-Type", "text/html");
+    response.set_body("<html><body><h1>400 Bad Request</h1></body></html>");
+    return response;
+}
+
+EventLoop::EventLoop(HttpServer &server, socket_t listen_fd, bool inline_handlers)
+    : m_server(server),
+      m_listen_fd(listen_fd),
+      m_inline_handlers(inline_handlers),
+      m_epoll_fd(epoll_create1(EPOLL_CLOEXEC)),
+      m_wake_fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      m_next_id(wake_id + 1),
+      m_timers(timer_tick),
+      m_buffer_pool(server.get_config().huge_page_buffers, server.get_config().topology.numa_local_buffers)
+{
+    if (!m_epoll_fd.is_valid() || !m_wake_fd.is_valid())
+        throw std::runtime_error(std::string("Failed to create event loop: ") + strerror(errno));
+
+    struct epoll_event event{};
+    event.events = EPOLLIN | EPOLLEXCLUSIVE;
+    event.data.u64 = listener_id;
+
+    if (epoll_ctl(m_epoll_fd.get(), EPOLL_CTL_ADD, m_listen_fd, &event) != 0)
+        throw std::runtime_error(std::string("Failed to watch server socket: ") + strerror(errno));
+
+    event.events = EPOLLIN | EPOLLET;
+    event.data.u64 = wake_id;
+
+    if (epoll_ctl(m_epoll_fd.get(), EPOLL_CTL_ADD, m_wake_fd.get(), &event) != 0)
+        throw std::runtime_error(std::string("Failed to watch wake descriptor: ") + strerror(errno));
+}
+
+EventLoop::~EventLoop()
+{
+    if (m_epoll_fd.is_valid())
+        epoll_ctl(m_epoll_fd.get(), EPOLL_CTL_DEL, m_listen_fd, nullptr);
+}
+
+void EventLoop::run()
+{
+    struct epoll_event events[max_events];
+    set_current(this);
+
+    while (!m_stopping)
+    {
+        int timeout = m_unread.empty() ? m_timers.get_next_timeout_ms(std::chrono::steady_clock::now()) : 0;
+        int count = epoll_wait(m_epoll_fd.get(), events, max_events, timeout);
+
+        if (count < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            m_server.m_logger.error() << "epoll_wait failed: " << strerror(errno);
+            break;
+        }
+
+        for (int i = 0; i < count; ++i)
+            handle_event(events[i].data.u64, events[i].events);
+
+        read_unread();
+
+        m_timers.advance(std::chrono::steady_clock::now(), [this](TimerWheel::Timer &timer)
+                         { expire_timer(timer.get_owner()); });
+    }
+
+    m_connections.clear();
+    set_current(nullptr);
+}
+
+void EventLoop::stop()
+{
+    m_stopping = true;
+
+    uint64_t value = 1;
+    [[maybe_unused]] ssize_t written = write(m_wake_fd.get(), &value, sizeof(value));
+}
+
+void EventLoop::drain()
+{
+    post([this]
+         { begin_drain(); });
+}
+
+void EventLoop::post(Task callback)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_pending_mutex);
+        m_pending.push_back(std::move(callback));
+    }
+
+    uint64_t value = 1;
+    [[maybe_unused]] ssize_t written = write(m_wake_fd.get(), &value, sizeof(value));
+}
+
+void EventLoop::run_pending()
+{
+    uint64_t value;
+    while (read(m_wake_fd.get(), &value, sizeof(value)) > 0)
+    {
+    }
+
+    std::vector<Task> pending;
+    {
+        std::lock_guard<std::mutex> lock(m_pending_mutex);
+        pending.swap(m_pending);
+    }
+
+    for (auto &callback : pending)
+        callback();
+}
+
+void EventLoop::read_unread()
+{
+    std::vector<uint64_t> unread;
+    unread.swap(m_unread);
+
+    for (uint64_t id : unread)
+        handle_event(id, EPOLLIN);
+}
+
+void EventLoop::accept_connections()
+{
+    size_t batch_size = std::max<size_t>(1, m_server.get_config().accept_batch_size);
+    size_t accepted = 0;
+
+    while (accepted < batch_size)
+    {
+        socket_t client_fd = accept4(m_listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (client_fd < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            if (errno == EMFILE || errno == ENFILE)
+            {
+                if (m_accept_reserve.shed(m_listen_fd))
+                {
+                    m_server.log_shed_connection();
+                    continue;
+                }
+            }
+            else if (errno != EAGAIN && errno != EWOULDBLOCK && !m_stopping)
+            {
+                m_server.m_logger.error() << "Failed to accept connection: " << strerror(errno);
+            }
+            break;
+        }
+
+        uint64_t id = m_next_id++;
+        const ServerConfig &config = m_server.get_config();
+        auto connection = std::make_unique<Connection>(id, SocketWrapper(client_fd), m_buffer_pool,
+                                                       config.max_request_header_size, config.max_request_body_size,
+                                                       config.max_streamed_body_size, config.output_high_water_mark);
+        connection->set_router(&m_server.get_router());
+        m_server.capture_peer(*connection);
+
+        struct epoll_event event{};
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.u64 = id;
+
+        if (epoll_ctl(m_epoll_fd.get(), EPOLL_CTL_ADD, client_fd, &event) != 0)
+        {
+            m_server.m_logger.error() << "Failed to watch client socket: " << strerror(errno);
+            continue;
+        }
+
+        update_timer(*connection);
+        m_connections.emplace(id, std::move(connection));
+        count_accepted();
+        ++accepted;
+    }
+
+    // The listener is level-triggered, so connections left past a full batch
+    // are picked up on the next wakeup after the events already returned.
+    if (accepted > 0)
+        m_server.log_connected(accepted);
+}
+
+void EventLoop::handle_event(uint64_t id, uint32_t events)
+{
+    if (id == listener_id)
+    {
+        if (!m_draining)
+            accept_connections();
+        return;
+    }
+
+    if (id == wake_id)
+    {
+        run_pending();
+        return;
+    }
+
+    if (m_operations.count(id) > 0)
+    {
+        // epoll and poll share their event bits on Linux.
+        finish_operation(id, events & (EPOLLIN | EPOLLOUT | EPOLLERR | EPOLLHUP));
+        return;
+    }
+
+    auto it = m_connections.find(id);
+    if (it == m_connections.end())
+        return;
+
+    Connection &connection = *it->second;
+
+    if (events & (EPOLLERR | EPOLLHUP))
+    {
+        close_connection(id);
+        return;
+    }
+
+    if (events & (EPOLLIN | EPOLLRDHUP))
+    {
+        on_readable(connection);
+
+        if (connection.get_state() == ConnectionState::Closed)
+        {
+            close_connection(id);
+            return;
+        }
+    }
+
+    if ((events & EPOLLOUT) && connection.get_state() == ConnectionState::Writing)
+    {
+        on_writable(connection);
+
+        if (connection.get_state() == ConnectionState::Closed)
+        {
+            close_connection(id);
+            return;
+        }
+    }
+
+    update_timer(connection);
+}
+
+// Input is only read while the connection waits for a request. Bytes sent
+// behind a request being processed stay in the socket until its responses are
+// written, so TCP flow control holds back a client that floods the connection.
+void EventLoop::on_readable(Connection &connection)
+{
+    while (connection.get_state() == ConnectionState::Reading)
+    {
+        size_t space;
+        char *input = connection.reserve_input(space);
+        ssize_t bytes_received = recv(connection.get_fd(), input, space, 0);
+
+        if (bytes_received > 0)
+        {
+            connection.commit_input(bytes_received);
+            connection.touch();
+            count_received(bytes_received);
+
+            // A full buffer is parsed before reading on, so a large body
+            // passes through one pooled buffer instead of growing it.
+            if (static_cast<size_t>(bytes_received) == space || connection.is_input_full())
+            {
+                process_input(connection);
+                if (connection.get_state() == ConnectionState::Closed)
+                    return;
+            }
+
+            if (connection.is_input_full())
+            {
+                m_server.m_logger.error() << "Closing connection that sent more input than it may buffer";
+                connection.set_state(ConnectionState::Closed);
+                return;
+            }
+            continue;
+        }
+
+        if (bytes_received == 0)
+        {
+            connection.set_peer_closed();
+            break;
+        }
+
+        if (errno == EINTR)
+            continue;
+
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            m_server.m_logger.error() << "Failed to receive request: " << strerror(errno);
+            connection.set_state(ConnectionState::Closed);
+            return;
+        }
+
+        break;
+    }
+
+    if (connection.get_state() == ConnectionState::Reading)
+        process_input(connection);
+}
+
+void EventLoop::process_input(Connection &connection)
+{
+    std::vector<HttpRequest> requests;
+
+    try
+    {
+        if (connection.extract_requests(requests) > 0)
+        {
+            dispatch(connection, std::move(requests));
+            return;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        m_server.m_logger.error() << "Failed to parse HTTP request: " << e.what();
+        HttpResponse response = make_bad_request_response();
+        m_server.finalize_response(response, false);
+        connection.set_keep_alive(false);
+        connection.queue_response(std::move(response));
+        connection.set_state(ConnectionState::Writing);
+        on_writable(connection);
+        return;
+    }
+
+    if (connection.is_peer_closed())
+    {
+        m_server.m_logger.debug() << "Client disconnected";
+        connection.set_state(ConnectionState::Closed);
+    }
+}
+
+void EventLoop::dispatch(Connection &connection, std::vector<HttpRequest> requests)
+{
+    connection.set_state(ConnectionState::Processing);
+
+    uint64_t id = connection.get_id();
+    size_t requests_served = connection.get_requests_served();
+    RequestOrigin origin{connection.get_peer(), std::chrono::steady_clock::now()};
+    connection.count_requests(requests.size());
+
+    std::optional<ExecutionPolicy> policy = m_server.get_batch_policy(requests, m_inline_handlers);
+    if (!policy)
+    {
+        dispatch_async(connection, std::move(requests), origin, requests_served);
+        return;
+    }
+
+    if (*policy == ExecutionPolicy::Inline)
+    {
+        std::vector<HttpResponse> responses;
+        bool keep_alive = m_server.process_requests(requests, origin, requests_served, true, responses);
+        write_responses(connection, responses, keep_alive);
+        return;
+    }
+
+    m_server.enqueue_task([this, id, origin, requests_served, requests = std::move(requests)]()
+                          {
+                              std::vector<HttpResponse> responses;
+                              bool keep_alive = m_server.process_requests(requests, origin, requests_served, true, responses);
+                              post([this, id, keep_alive, responses = std::move(responses)]() mutable
+                                   { complete(id, responses, keep_alive); }); },
+                          [this, id]()
+                          {
+                              std::vector<HttpResponse> responses = {m_server.get_overload_response()};
+                              post([this, id, responses = std::move(responses)]() mutable
+                                   { complete(id, responses, false); }); },
+                          *policy);
+}
+
+void EventLoop::dispatch_async(Connection &connection, std::vector<HttpRequest> requests, RequestOrigin origin,
+                               size_t requests_served)
+{
+    uint64_t id = connection.get_id();
+    AsyncBatch &batch = m_async_batches[id];
+
+    batch.coroutine = m_server.process_requests_async(std::move(requests), origin, requests_served, m_inline_handlers,
+                                                      batch.responses);
+    batch.coroutine.start([this, id]
+                          { complete_async(id); });
+
+    auto it = m_async_batches.find(id);
+    if (it != m_async_batches.end())
+        it->second.dispatching = false;
+}
+
+// Runs when a batch's coroutine returns, from within its final suspension.
+void EventLoop::complete_async(uint64_t id)
+{
+    auto it = m_async_batches.find(id);
+    if (it == m_async_batches.end())
+        return;
+
+    AsyncBatch batch = std::move(it->second);
+    m_async_batches.erase(it);
+
+    bool keep_alive = false;
+    try
+    {
+        keep_alive = batch.coroutine.get_result();
+    }
+    catch (const std::exception &e)
+    {
+        m_server.m_logger.error() << "Failed to process requests: " << e.what();
+    }
+
+    // A batch that never suspended is still inside dispatch, whose caller
+    // closes the connection if needed.
+    if (batch.dispatching)
+    {
+        auto connection = m_connections.find(id);
+        if (connection != m_connections.end())
+            write_responses(*connection->second, batch.responses, keep_alive);
+        return;
+    }
+
+    complete(id, batch.responses, keep_alive);
+}
+
+void EventLoop::start_operation(AsyncOperation &operation)
+{
+    uint64_t id = m_next_id++;
+    PendingOperation &pending = m_operations.try_emplace(id, &operation, id).first->second;
+
+    if (operation.kind == AsyncOperation::Kind::Read)
+    {
+        // Reads land in a buffer of the task's own, since the awaiting
+        // coroutine may be gone by the time the worker finishes.
+        m_server.enqueue_task([this, id, fd = operation.fd, length = operation.length, offset = operation.offset]
+                              {
+                                  std::string data(length, '\0');
+                                  ssize_t bytes = pread(fd, data.data(), length, static_cast<off_t>(offset));
+                                  int64_t result = bytes < 0 ? -errno : bytes;
+                                  post([this, id, result, data = std::move(data)]
+                                       {
+                                           auto it = m_operations.find(id);
+                                           if (it != m_operations.end() && result > 0)
+                                               memcpy(it->second.operation->buffer, data.data(), static_cast<size_t>(result));
+                                           finish_operation(id, result); }); });
+        return;
+    }
+
+    if (operation.kind == AsyncOperation::Kind::Poll)
+    {
+        struct epoll_event event{};
+        event.events = EPOLLONESHOT | ((operation.events & POLLIN) ? EPOLLIN : 0u) |
+                       ((operation.events & POLLOUT) ? EPOLLOUT : 0u);
+        event.data.u64 = id;
+
+        if (epoll_ctl(m_epoll_fd.get(), EPOLL_CTL_ADD, operation.fd, &event) == 0)
+        {
+            pending.polling = true;
+        }
+        else
+        {
+            // Regular files cannot be watched and are always ready, as with poll().
+            int64_t result = errno == EPERM ? operation.events : -errno;
+            post([this, id, result]
+                 { finish_operation(id, result); });
+            return;
+        }
+    }
+
+    if (operation.deadline != AsyncOperation::clock::time_point::max())
+        m_timers.schedule(pending.timer, operation.deadline);
+}
+
+void EventLoop::finish_operation(uint64_t id, int64_t result)
+{
+    auto it = m_operations.find(id);
+    if (it == m_operations.end())
+        return;
+
+    AsyncOperation &operation = *it->second.operation;
+    if (it->second.polling)
+        epoll_ctl(m_epoll_fd.get(), EPOLL_CTL_DEL, operation.fd, nullptr);
+    m_operations.erase(it);
+
+    operation.result = result;
+    operation.handle.resume();
+}
+
+void EventLoop::complete(uint64_t id, std::vector<HttpResponse> &responses, bool keep_alive)
+{
+    auto it = m_connections.find(id);
+    if (it == m_connections.end())
+        return;
+
+    Connection &connection = *it->second;
+    write_responses(connection, responses, keep_alive);
+
+    if (connection.get_state() == ConnectionState::Closed)
+        close_connection(id);
+    else
+        update_timer(connection);
+}
+
+void EventLoop::write_responses(Connection &connection, std::vector<HttpResponse> &responses, bool keep_alive)
+{
+    connection.set_keep_alive(keep_alive);
+
+    for (auto &response : responses)
+        connection.queue_response(std::move(response));
+
+    count_requests(responses.size());
+    connection.set_state(ConnectionState::Writing);
+    on_writable(connection);
+}
+
+void EventLoop::on_writable(Connection &connection)
+{
+    size_t high_water_mark = m_server.get_config().output_high_water_mark;
+    m_server.set_corked(connection, true);
+
+    while (true)
+    {
+        int flushed = flush_output(connection);
+
+        if (flushed < 0)
+        {
+            connection.set_state(ConnectionState::Closed);
+            return;
+        }
+
+        // A streamed body is produced ahead of the socket until the pending
+        // output reaches the high-water mark; a full queue waits for EPOLLOUT.
+        std::shared_ptr<ResponseStream> stream = connection.get_body_stream();
+        if (!stream)
+        {
+            if (flushed == 0)
+                return;
+            break;
+        }
+
+        if (connection.is_producing_body() || connection.get_pending_output_size() >= high_water_mark)
+            return;
+
+        if (!m_inline_handlers)
+        {
+            produce_body(connection, std::move(stream));
+            return;
+        }
+
+        std::string output;
+        if (!m_server.produce_body(*stream, output))
+        {
+            connection.set_state(ConnectionState::Closed);
+            return;
+        }
+
+        connection.queue_body_output(std::move(output));
+    }
+
+    finish_response(connection);
+}
+
+int EventLoop::flush_output(Connection &connection)
+{
+    while (true)
+    {
+        ssize_t bytes_sent;
+
+        if (connection.has_pending_output())
+        {
+            struct iovec vectors[Connection::max_output_vectors];
+            struct msghdr message{};
+            message.msg_iov = vectors;
+            message.msg_iovlen = connection.get_output_iovecs(vectors, Connection::max_output_vectors);
+
+            // Headers ahead of a file body are held back to share segments with it.
+            int flags = MSG_NOSIGNAL | (connection.has_pending_file_output() ? MSG_MORE : 0);
+
+            bytes_sent = sendmsg(connection.get_fd(), &message, flags);
+
+            if (bytes_sent >= 0)
+            {
+                connection.consume_output(bytes_sent);
+                count_sent(bytes_sent);
+                continue;
+            }
+        }
+        else if (connection.has_pending_file_output())
+        {
+            off_t offset = static_cast<off_t>(connection.get_file_offset());
+            bytes_sent = sendfile(connection.get_fd(), connection.get_body_file()->get_fd(), &offset,
+                                  connection.get_pending_file_size());
+
+            if (bytes_sent > 0)
+            {
+                connection.consume_file_output(bytes_sent);
+                count_sent(bytes_sent);
+                continue;
+            }
+
+            if (bytes_sent == 0)
+            {
+                m_server.m_logger.error() << "Failed to send response file: file is shorter than its size";
+                return -1;
+            }
+        }
+        else
+        {
+            return 1;
+        }
+
+        if (errno == EINTR)
+            continue;
+
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return 0;
+
+        m_server.m_logger.error() << "Failed to send response: " << strerror(errno);
+        return -1;
+    }
+}
+
+void EventLoop::produce_body(Connection &connection, std::shared_ptr<ResponseStream> stream)
+{
+    connection.set_producing_body(true);
+    uint64_t id = connection.get_id();
+
+    m_server.enqueue_task([this, id, stream = std::move(stream)]()
+                          {
+                              std::string output;
+                              bool produced = m_server.produce_body(*stream, output);
+                              post([this, id, produced, output = std::move(output)]() mutable
+                                   { write_body(id, std::move(output), produced); }); });
+}
+
+void EventLoop::write_body(uint64_t id, std::string output, bool produced)
+{
+    auto it = m_connections.find(id);
+    if (it == m_connections.end())
+        return;
+
+    if (!produced)
+    {
+        close_connection(id);
+        return;
+    }
+
+    Connection &connection = *it->second;
+    connection.set_producing_body(false);
+    connection.queue_body_output(std::move(output));
+    on_writable(connection);
+
+    if (connection.get_state() == ConnectionState::Closed)
+        close_connection(id);
+    else
+        update_timer(connection);
+}
+
+void EventLoop::finish_response(Connection &connection)
+{
+    m_server.set_corked(connection, false);
+
+    if (!connection.is_keep_alive() || connection.is_peer_closed() || m_stopping)
+    {
+        connection.set_state(ConnectionState::Closed);
+        return;
+    }
+
+    connection.set_state(ConnectionState::Reading);
+    connection.touch();
+    process_input(connection);
+
+    // Pipelined requests already received are still answered while draining.
+    if (m_draining && connection.is_idle_keep_alive())
+    {
+        connection.set_state(ConnectionState::Closed);
+        return;
+    }
+
+    // Edge-triggered, so input that arrived while the responses were written
+    // gives no new event. It is read on the next pass of the loop rather than
+    // here, where a client that keeps sending would deepen the recursion.
+    if (connection.get_state() == ConnectionState::Reading)
+        m_unread.push_back(connection.get_id());
+}
+
+void EventLoop::close_connection(uint64_t id)
+{
+    auto it = m_connections.find(id);
+    if (it == m_connections.end())
+        return;
+
+    epoll_ctl(m_epoll_fd.get(), EPOLL_CTL_DEL, it->second->get_fd(), nullptr);
+    m_connections.erase(it);
+
+    if (m_draining && m_connections.empty())
+        m_stopping = true;
+}
+
+// Runs on the loop's thread. The listener is only unwatched, not shut down,
+// since a successor may be accepting on it.
+void EventLoop::begin_drain()
+{
+    if (m_draining)
+        return;
+
+    m_draining = true;
+    epoll_ctl(m_epoll_fd.get(), EPOLL_CTL_DEL, m_listen_fd, nullptr);
+
+    std::vector<uint64_t> idle;
+    for (const auto &[id, connection] : m_connections)
+    {
+        if (connection->is_idle_keep_alive())
+            idle.push_back(id);
+    }
+
+    for (uint64_t id : idle)
+        close_connection(id);
+
+    if (m_connections.empty())
+        m_stopping = true;
+}
+
+// Called after every event on a connection, so the timer always tracks the
+// deadline of the phase the connection is in.
+void EventLoop::update_timer(Connection &connection)
+{
+    m_timers.schedule(connection.get_timer(), m_server.get_deadline(connection));
+}
+
+void EventLoop::expire_timer(uint64_t id)
+{
+    if (m_operations.count(id) > 0)
+    {
+        finish_operation(id, 0);
+        return;
+    }
+
+    auto it = m_connections.find(id);
+    if (it == m_connections.end())
+        return;
+
+    Connection &connection = *it->second;
+
+    // A request still arriving is answered with 408 before closing.
+    if (!m_server.queue_timeout_response(connection))
+    {
+        close_connection(id);
+        return;
+    }
+
+    on_writable(connection);
+
+    if (connection.get_state() == ConnectionState::Closed)
+        close_connection(id);
+    else
+        update_timer(connection);
+}
+
+#endif // __linux__
@@ -0,0 +1,113 @@
+#ifndef EVENT_LOOP_HPP
+#define EVENT_LOOP_HPP
+
+#ifdef __linux__
+
+#include "http/httprequest.hpp"
+#include "http/httpresponse.hpp"
+#include "accept_reserve.hpp"
+#include "async.hpp"
+#include "async_io.hpp"
+#include "buffer_pool.hpp"
+#include "connection.hpp"
+#include "io_loop.hpp"
+#include "socket_wrapper.hpp"
+#include "timer_wheel.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class HttpServer;
+
+class EventLoop : public IoLoop
+{
+private:
+    static constexpr uint64_t listener_id = 0;
+    static constexpr uint64_t wake_id = 1;
+    static constexpr int max_events = 256;
+    static constexpr std::chrono::milliseconds timer_tick{10};
+
+    // An operation awaited by a coroutine on this loop; the timer carries its deadline.
+    struct PendingOperation
+    {
+        AsyncOperation *operation;
+        TimerWheel::Timer timer;
+        bool polling = false;
+
+        PendingOperation(AsyncOperation *o, uint64_t id)
+            : operation(o), timer(id) {}
+    };
+
+    // Requests with async routes, answered by a coroutine on this thread.
+    struct AsyncBatch
+    {
+        std::vector<HttpResponse> responses;
+        Async<bool> coroutine;
+        bool dispatching = true;
+    };
+
+    HttpServer &m_server;
+    socket_t m_listen_fd;
+    bool m_inline_handlers;
+    SocketWrapper m_epoll_fd;
+    SocketWrapper m_wake_fd;
+    uint64_t m_next_id;
+    TimerWheel m_timers;
+    BufferPool m_buffer_pool;
+    std::unordered_map<uint64_t, std::unique_ptr<Connection>> m_connections;
+    std::unordered_map<uint64_t, PendingOperation> m_operations;
+    std::unordered_map<uint64_t, AsyncBatch> m_async_batches;
+    AcceptReserve m_accept_reserve;
+    // Connections back in Reading whose socket may hold input sent while they were busy.
+    std::vector<uint64_t> m_unread;
+
+    std::mutex m_pending_mutex;
+    std::vector<Task> m_pending;
+    std::atomic<bool> m_stopping{false};
+    bool m_draining = false;
+
+    void accept_connections();
+    void handle_event(uint64_t id, uint32_t events);
+    void on_readable(Connection &connection);
+    void on_writable(Connection &connection);
+    int flush_output(Connection &connection);
+    void produce_body(Connection &connection, std::shared_ptr<ResponseStream> stream);
+    void write_body(uint64_t id, std::string output, bool produced);
+    void finish_response(Connection &connection);
+    void process_input(Connection &connection);
+    void dispatch(Connection &connection, std::vector<HttpRequest> requests);
+    void dispatch_async(Connection &connection, std::vector<HttpRequest> requests, RequestOrigin origin,
+                        size_t requests_served);
+    void complete(uint64_t id, std::vector<HttpResponse> &responses, bool keep_alive);
+    void complete_async(uint64_t id);
+    void finish_operation(uint64_t id, int64_t result);
+    void write_responses(Connection &connection, std::vector<HttpResponse> &responses, bool keep_alive);
+    void close_connection(uint64_t id);
+    void update_timer(Connection &connection);
+    void expire_timer(uint64_t id);
+    void begin_drain();
+    void run_pending();
+    void read_unread();
+
+public:
+    EventLoop(HttpServer &server, socket_t listen_fd, bool inline_handlers = false);
+
+    EventLoop(const EventLoop &) = delete;
+    EventLoop &operator=(const EventLoop &) = delete;
+
+    ~EventLoop() override;
+
+    void run() override;
+    void stop() override;
+    void drain() override;
+    void post(Task callback) override;
+    void start_operation(AsyncOperation &operation) override;
+};
+
+#endif // __linux__
+
+#endif // EVENT_LOOP_HPP
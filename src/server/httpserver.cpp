@@ -1,12 +1,14 @@
+#include "helpers.hpp"
+#include "server/accept_reserve.hpp"
+#include "server/cpu_topology.hpp"
 #include "server/httpserver.hpp"
+#include "server/listen_fds.hpp"
 #include <thread>
 #include <mutex>
 #include <atomic>
 #include <cerrno>
+#include <cstddef>
 #include <cstring>
-#include <iostream>
-#include <fstream>
-#include <sstream>
 #include <filesystem>
 #include <functional>
 
@@ -50,8 +52,16 @@ std::string get_error_string(int error_code)
     return result;
 }
 #else
+#include <csignal>
 #include <unistd.h>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <poll.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <sys/un.h>
 #include <netinet/in.h>
 
 int get_last_error()
@@ -65,217 +75,1217 @@ std::string get_error_string(int error_code)
 }
 #endif
 
+#ifdef __linux__
+#include <linux/filter.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/sendfile.h>
+
+// Selects the reuseport group member by the CPU that processed the SYN, so a
+// connection lands on the shard pinned to that CPU (Linux 4.6+).
+static bool attach_cpu_steering(socket_t listener)
+{
+    struct sock_filter code[] = {
+        {BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)},
+        {BPF_RET | BPF_A, 0, 0, 0},
+    };
+
+    struct sock_fprog program{};
+    program.len = sizeof(code) / sizeof(code[0]);
+    program.filter = code;
+
+    return setsockopt(listener, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) == 0;
+}
+#endif
+
+// Blocking workers wake up this often while waiting on a persistent connection
+// so they can notice the idle timeout, a stop request or queued connections.
+static constexpr int receive_poll_interval_ms = 100;
+
+static void set_socket_timeout(socket_t socket, int option, long long timeout_ms)
+{
+#ifdef _WIN32
+    DWORD timeout = static_cast<DWORD>(timeout_ms);
+#else
+    struct timeval timeout{};
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+#endif
+    setsockopt(socket, SOL_SOCKET, option, (const char *)&timeout, sizeof(timeout));
+}
+
+#ifndef _WIN32
+static socket_t accept_client(socket_t listen_fd)
+{
+#ifdef __linux__
+    return accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+#else
+    // BSDs pass the listener's O_NONBLOCK on to accepted sockets; workers block on them.
+    socket_t client_fd = accept(listen_fd, nullptr, nullptr);
+    if (client_fd >= 0)
+        fcntl(client_fd, F_SETFL, fcntl(client_fd, F_GETFL, 0) & ~O_NONBLOCK);
+    return client_fd;
+#endif
+}
+#endif
+
+// Sends the next part of a file body; Linux sends it without copying it through user space.
+static long send_file_part(socket_t socket, const FileBody &file, size_t offset, size_t length)
+{
+#ifdef __linux__
+    off_t file_offset = static_cast<off_t>(offset);
+    return sendfile(socket, file.get_fd(), &file_offset, length);
+#else
+    char buffer[64 * 1024];
+    long bytes_read = file.read(buffer, std::min(length, sizeof(buffer)), offset);
+    if (bytes_read <= 0)
+        return bytes_read;
+    return send(socket, buffer, static_cast<int>(bytes_read), 0);
+#endif
+}
+
+static bool is_timeout_error(int error_code)
+{
+#ifdef _WIN32
+    return error_code == WSAETIMEDOUT || error_code == WSAEWOULDBLOCK;
+#else
+    return error_code == EAGAIN || error_code == EWOULDBLOCK;
+#endif
+}
+
 HttpServer::HttpServer()
     : m_server_socket(),
       m_server_address{}
 {
-    init_thread_pool();
 }
 
-HttpServer::HttpServer(const Router &router)
-    : m_server_socket(),
-      m_server_address{},
-      m_router(router)
+HttpServer::HttpServer(const Router &router)
+    : m_server_socket(),
+      m_server_address{},
+      m_router(router)
+{
+}
+
+HttpServer::~HttpServer()
+{
+    shutdown_thread_pool();
+    m_logger.info() << "Server socket closed";
+}
+
+void HttpServer::set_router(const Router &router)
+{
+    m_router = router;
+}
+
+const Router &HttpServer::get_router() const
+{
+    return m_router;
+}
+
+void HttpServer::set_config(const ServerConfig &config)
+{
+    m_config = config;
+}
+
+const ServerConfig &HttpServer::get_config() const
+{
+    return m_config;
+}
+
+int HttpServer::run(int port, int connection_backlog, int reuse)
+{
+    m_logger.configure(m_config.logging);
+
+#ifndef _WIN32
+    // sendfile() has no MSG_NOSIGNAL, so a peer closing mid-file would raise
+    // SIGPIPE and kill the process; let the write fail with EPIPE instead.
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+    m_unix_socket = !m_config.unix_socket_path.empty();
+    m_handed_off = false;
+    bool sharded = m_config.reuse_port_shards && m_config.backend != IoBackend::Blocking && !m_unix_socket;
+
+    if (connection_backlog <= 0)
+        connection_backlog = m_config.socket_policy.backlog;
+
+    size_t listener_count = sharded ? std::max<size_t>(1, m_config.io_threads) : 1;
+    m_shard_sockets.clear();
+
+    // Listeners passed by a predecessor or a service manager keep the
+    // connections already queued on them; the port is then theirs.
+#ifdef _WIN32
+    std::vector<SocketWrapper> inherited;
+#else
+    std::vector<SocketWrapper> inherited = take_listen_fds();
+#endif
+
+    if (!inherited.empty())
+    {
+        m_logger.info() << "Using " << inherited.size() << " inherited listening socket(s)";
+        m_server_socket = std::move(inherited.front());
+
+        for (size_t i = 1; i < std::min(inherited.size(), listener_count); ++i)
+            m_shard_sockets.push_back(std::move(inherited[i]));
+    }
+    else if (m_unix_socket)
+    {
+        m_server_socket = open_unix_listener(connection_backlog);
+    }
+    else
+    {
+        m_server_socket = open_listener(port, connection_backlog, reuse, sharded);
+    }
+
+    if (!m_server_socket.is_valid())
+        return 1;
+
+    socklen_t address_length = sizeof(m_server_address);
+    getsockname(m_server_socket.get(), (struct sockaddr *)&m_server_address, &address_length);
+    m_unix_socket = m_server_address.ss_family == AF_UNIX;
+
+    for (size_t i = 1 + m_shard_sockets.size(); i < listener_count; ++i)
+    {
+        m_shard_sockets.push_back(open_listener(get_port(), connection_backlog, reuse, true));
+        if (!m_shard_sockets.back().is_valid())
+            return 1;
+    }
+
+    m_logger.info() << "Waiting for a client to connect...";
+
+    build_overload_response();
+    {
+        std::lock_guard<std::mutex> lock(m_codel_mutex);
+        m_codel = CoDel(m_config.queue_target_delay, m_config.queue_interval);
+        m_codel_idle = true;
+    }
+
+    // Workers are started here rather than with the server, once the
+    // configuration saying where they run is known.
+    size_t io_thread_count = m_config.backend == IoBackend::Blocking ? 0 : std::max<size_t>(1, m_config.io_threads);
+    m_thread_placement = plan_thread_placement(m_config.topology, io_thread_count,
+                                               !m_shard_sockets.empty() && m_config.shard_cpu_steering, get_allowed_cpus());
+    init_thread_pool(m_thread_placement);
+
+    // Replaced only once the previous run's workers are gone.
+    m_access_log.reset();
+    if (!m_config.access_log.path.empty())
+    {
+        try
+        {
+            m_access_log = std::make_unique<AccessLog>(m_config.access_log);
+        }
+        catch (const std::exception &e)
+        {
+            m_logger.error() << e.what();
+            return 1;
+        }
+    }
+
+    m_draining = false;
+    m_running = true;
+
+    int exit_code = m_config.backend == IoBackend::Blocking ? run_blocking() : run_io_loops();
+
+    m_running = false;
+    m_serving = false;
+
+    if (m_access_log)
+        m_access_log->flush();
+
+    // Only this process's copies of the listeners are closed; a successor may
+    // still be accepting on them.
+    if (m_draining)
+    {
+        m_server_socket.reset();
+        m_shard_sockets.clear();
+    }
+
+    if (!m_handed_off)
+        remove_unix_socket_file();
+
+    return exit_code;
+}
+
+SocketWrapper HttpServer::open_listener(int port, int connection_backlog, int reuse, bool reuse_port)
+{
+    SocketWrapper listener(socket(AF_INET, SOCK_STREAM, 0));
+
+    if (!listener.is_valid())
+    {
+        int error = get_last_error();
+        m_logger.error() << "Failed to create server socket: " << get_error_string(error);
+        return SocketWrapper();
+    }
+
+    if (setsockopt(listener.get(), SOL_SOCKET, SO_REUSEADDR, (const char *)&reuse, sizeof(reuse)) < 0)
+    {
+        int error = get_last_error();
+        m_logger.error() << "setsockopt failed: " << get_error_string(error);
+        return SocketWrapper();
+    }
+
+#ifdef SO_REUSEPORT
+    int one = 1;
+    if (reuse_port && setsockopt(listener.get(), SOL_SOCKET, SO_REUSEPORT, (const char *)&one, sizeof(one)) < 0)
+    {
+        int error = get_last_error();
+        m_logger.error() << "Failed to enable SO_REUSEPORT: " << get_error_string(error);
+        return SocketWrapper();
+    }
+#else
+    if (reuse_port)
+    {
+        m_logger.error() << "SO_REUSEPORT is not available on this platform";
+        return SocketWrapper();
+    }
+#endif
+
+    struct sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(port);
+
+    if (bind(listener.get(), (struct sockaddr *)&address, sizeof(address)) != 0)
+    {
+        int error = get_last_error();
+        m_logger.error() << "Failed to bind to port " << port << ": " << get_error_string(error);
+        return SocketWrapper();
+    }
+
+    apply_listener_policy(listener.get());
+
+    if (listen(listener.get(), connection_backlog) != 0)
+    {
+        int error = get_last_error();
+        m_logger.error() << "listen failed: " << get_error_string(error);
+        return SocketWrapper();
+    }
+
+    return listener;
+}
+
+SocketWrapper HttpServer::open_unix_listener(int connection_backlog)
+{
+#ifdef _WIN32
+    (void)connection_backlog;
+    m_logger.error() << "Unix domain sockets are not supported on this platform";
+    return SocketWrapper();
+#else
+    const std::string &path = m_config.unix_socket_path;
+    struct sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        m_logger.error() << "Unix socket path is too long: " << path;
+        return SocketWrapper();
+    }
+
+    // An abstract address is the name after a NUL byte, and its length counts no terminator.
+    bool abstract = path.front() == '@';
+    path.copy(address.sun_path, path.size());
+    if (abstract)
+        address.sun_path[0] = '\0';
+    socklen_t address_length = offsetof(struct sockaddr_un, sun_path) + path.size() + (abstract ? 0 : 1);
+
+    SocketWrapper listener(socket(AF_UNIX, SOCK_STREAM, 0));
+
+    if (!listener.is_valid())
+    {
+        m_logger.error() << "Failed to create server socket: " << strerror(errno);
+        return SocketWrapper();
+    }
+
+    // A socket file nobody accepts on is left by a server that died; one a
+    // live server accepts on is kept, and bind reports it as in use.
+    struct stat status{};
+    if (!abstract && lstat(address.sun_path, &status) == 0 && S_ISSOCK(status.st_mode))
+    {
+        SocketWrapper probe(socket(AF_UNIX, SOCK_STREAM, 0));
+        if (connect(probe.get(), (struct sockaddr *)&address, address_length) != 0 && errno == ECONNREFUSED)
+            unlink(address.sun_path);
+    }
+
+    if (bind(listener.get(), (struct sockaddr *)&address, address_length) != 0)
+    {
+        m_logger.error() << "Failed to bind to " << path << ": " << strerror(errno);
+        return SocketWrapper();
+    }
+
+    if (!abstract && chmod(address.sun_path, m_config.unix_socket_mode) != 0)
+    {
+        m_logger.error() << "Failed to set permissions of " << path << ": " << strerror(errno);
+        unlink(address.sun_path);
+        return SocketWrapper();
+    }
+
+    apply_listener_policy(listener.get());
+
+    if (listen(listener.get(), connection_backlog) != 0)
+    {
+        m_logger.error() << "listen failed: " << strerror(errno);
+        if (!abstract)
+            unlink(address.sun_path);
+        return SocketWrapper();
+    }
+
+    return listener;
+#endif
+}
+
+void HttpServer::remove_unix_socket_file() const
+{
+#ifndef _WIN32
+    if (!m_unix_socket)
+        return;
+
+    const auto &address = reinterpret_cast<const struct sockaddr_un &>(m_server_address);
+    if (address.sun_path[0] != '\0')
+        unlink(address.sun_path);
+#endif
+}
+
+int HttpServer::run_blocking()
+{
+    report_thread_placement({});
+    m_serving = m_running.load();
+
+    std::vector<socket_t> accepted;
+    accepted.reserve(std::max<size_t>(1, m_config.accept_batch_size));
+
+#ifdef _WIN32
+    struct sockaddr_in client_address;
+    int client_address_length = sizeof(client_address);
+
+    while (m_running && !m_draining)
+    {
+        socket_t client_fd = accept(m_server_socket.get(), (struct sockaddr *)&client_address, &client_address_length);
+
+        if (client_fd == INVALID_SOCKET)
+        {
+            int error = get_last_error();
+            if (!m_running || m_draining || error == WSAEINTR || error == WSAENOTSOCK)
+                break;
+            m_logger.error() << "Failed to accept connection: " << get_error_string(error);
+            continue;
+        }
+
+        accepted.push_back(client_fd);
+        log_connected(accepted.size());
+        enqueue_clients(accepted);
+    }
+#else
+    int flags = fcntl(m_server_socket.get(), F_GETFL, 0);
+    if (flags < 0 || fcntl(m_server_socket.get(), F_SETFL, flags | O_NONBLOCK) < 0)
+    {
+        m_logger.error() << "Failed to make server socket non-blocking: " << strerror(errno);
+        return 1;
+    }
+
+    AcceptReserve reserve;
+
+    while (m_running && !m_draining)
+    {
+        // Woken periodically to notice a drain, which leaves the listener open.
+        struct pollfd listener{m_server_socket.get(), POLLIN, 0};
+        int ready = poll(&listener, 1, receive_poll_interval_ms);
+
+        if (ready < 0 && errno != EINTR)
+        {
+            m_logger.error() << "poll failed: " << strerror(errno);
+            break;
+        }
+
+        if (ready <= 0)
+            continue;
+
+        // Drain the listen queue before handing the batch to the workers under one lock.
+        while (accepted.size() < accepted.capacity())
+        {
+            socket_t client_fd = accept_client(m_server_socket.get());
+
+            if (client_fd >= 0)
+            {
+                accepted.push_back(client_fd);
+                continue;
+            }
+
+            if (errno == EINTR)
+                continue;
+
+            if (errno == EMFILE || errno == ENFILE)
+            {
+                if (reserve.shed(m_server_socket.get()))
+                {
+                    log_shed_connection();
+                    continue;
+                }
+            }
+            else if (errno != EAGAIN && errno != EWOULDBLOCK && m_running)
+            {
+                m_logger.error() << "Failed to accept connection: " << strerror(errno);
+            }
+            break;
+        }
+
+        if (accepted.empty())
+            continue;
+
+        log_connected(accepted.size());
+        enqueue_clients(accepted);
+    }
+#endif
+
+    wait_for_drain([this]
+                   { return m_active_clients == 0; });
+    return 0;
+}
+
+int HttpServer::run_io_loops()
+{
+    std::vector<socket_t> listeners = {m_server_socket.get()};
+    for (const auto &shard_socket : m_shard_sockets)
+        listeners.push_back(shard_socket.get());
+
+    bool sharded = listeners.size() > 1;
+
+#ifdef __linux__
+    if (m_config.backend == IoBackend::Epoll)
+    {
+        for (socket_t listener : listeners)
+        {
+            int flags = fcntl(listener, F_GETFL, 0);
+            if (flags < 0 || fcntl(listener, F_SETFL, flags | O_NONBLOCK) < 0)
+            {
+                m_logger.error() << "Failed to make server socket non-blocking: " << strerror(errno);
+                return 1;
+            }
+        }
+    }
+
+    if (sharded && m_config.shard_cpu_steering && !attach_cpu_steering(m_server_socket.get()))
+        m_logger.error() << "Failed to attach reuseport CPU steering program: " << strerror(errno);
+#endif
+
+    std::vector<std::thread> io_threads;
+    std::vector<CpuSet> io_cpus;
+    {
+        std::lock_guard<std::mutex> lock(m_io_loops_mutex);
+
+        if (!m_running)
+            return 0;
+
+        try
+        {
+            m_io_loops.clear();
+            for (size_t i = 0; i < std::max<size_t>(1, m_config.io_threads); ++i)
+                m_io_loops.push_back(create_io_loop(listeners[sharded ? i : 0], sharded));
+        }
+        catch (const std::exception &e)
+        {
+            m_io_loops.clear();
+            m_logger.error() << "Failed to start " << io_backend_to_string(m_config.backend)
+                             << " backend: " << e.what();
+            return 1;
+        }
+
+        {
+            std::lock_guard<std::mutex> drain_lock(m_drain_mutex);
+            m_running_loops = m_io_loops.size();
+        }
+
+        for (size_t i = 0; i < m_io_loops.size(); ++i)
+        {
+            io_threads.emplace_back([this, loop = m_io_loops[i].get()]
+                                    {
+                                        loop->run();
+                                        notify_drain(m_running_loops); });
+
+            const CpuSet &cpus = m_thread_placement.io_cpus[i];
+            if (cpus.empty())
+                io_cpus.emplace_back();
+            else if (set_thread_affinity(io_threads.back(), cpus))
+                io_cpus.push_back(get_thread_affinity(io_threads.back()));
+            else
+            {
+                io_cpus.emplace_back();
+                m_logger.error() << "Failed to pin I/O thread " << i << " to CPUs " << format_cpu_list(cpus);
+            }
+        }
+
+        report_thread_placement(io_cpus);
+        m_serving = true;
+
+        // A drain that started before the loops existed reaches them here.
+        if (m_draining)
+        {
+            for (auto &loop : m_io_loops)
+                loop->drain();
+        }
+    }
+
+    wait_for_drain([this]
+                   { return m_running_loops == 0; });
+    stop();
+
+    for (auto &thread : io_threads)
+        thread.join();
+
+    return 0;
+}
+
+std::unique_ptr<IoLoop> HttpServer::create_io_loop(socket_t listen_fd, bool inline_handlers)
+{
+    switch (m_config.backend)
+    {
+#ifdef __linux__
+    case IoBackend::Epoll:
+        return std::make_unique<EventLoop>(*this, listen_fd, inline_handlers);
+#endif
+#ifdef HAS_IO_URING
+    case IoBackend::IoUring:
+        return std::make_unique<IoUringLoop>(*this, listen_fd, m_config.io_uring_buffer_ring, inline_handlers);
+#endif
+    default:
+        throw std::runtime_error("backend is not available on this platform");
+    }
+}
+
+// Deadline of the connection's current phase: reading a request's headers or
+// body, waiting for the next request, or sending output. None while a handler runs.
+std::chrono::steady_clock::time_point HttpServer::get_deadline(const Connection &connection) const
+{
+    if (connection.get_state() == ConnectionState::Reading)
+    {
+        switch (connection.get_read_phase())
+        {
+        case ReadPhase::Headers:
+            return connection.get_request_start() + m_config.request_header_timeout;
+        case ReadPhase::Body:
+            return connection.get_last_activity() + m_config.request_body_timeout;
+        case ReadPhase::Idle:
+            if (connection.get_requests_served() == 0)
+                return connection.get_request_start() + m_config.request_header_timeout;
+            return connection.get_last_activity() + m_config.keep_alive_timeout;
+        }
+    }
+
+    if (connection.get_state() == ConnectionState::Writing &&
+        (connection.has_pending_output() || connection.has_pending_file_output()))
+        return connection.get_last_output_progress() + m_config.send_stall_timeout;
+
+    return std::chrono::steady_clock::time_point::max();
+}
+
+// Answers a request that did not arrive in time with 408 and moves the
+// connection to Writing; false if there is no started request to answer.
+bool HttpServer::queue_timeout_response(Connection &connection) const
+{
+    if (connection.get_state() != ConnectionState::Reading || connection.get_read_phase() == ReadPhase::Idle)
+        return false;
+
+    HttpResponse response;
+    response.set_code(HttpCode::RequestTimeout);
+    response.add_header("Content-Type", "text/html");
+    response.set_body("<html><body><h1>408 Request Timeout</h1></body></html>");
+    finalize_response(response, false);
+
+    connection.set_keep_alive(false);
+    connection.queue_response(std::move(response));
+    connection.set_state(ConnectionState::Writing);
+    return true;
+}
+
+void HttpServer::set_socket_option(socket_t socket, int level, int option, int value, const char *name) const
+{
+    if (setsockopt(socket, level, option, (const char *)&value, sizeof(value)) < 0)
+    {
+        int error = get_last_error();
+        m_logger.error() << "Failed to set " << name << ": " << get_error_string(error);
+    }
+}
+
+void HttpServer::apply_listener_policy(socket_t listener) const
+{
+    const SocketPolicy &policy = m_config.socket_policy;
+
+#ifdef TCP_DEFER_ACCEPT
+    if (policy.defer_accept_seconds > 0 && !m_unix_socket)
+        set_socket_option(listener, IPPROTO_TCP, TCP_DEFER_ACCEPT, policy.defer_accept_seconds, "TCP_DEFER_ACCEPT");
+#endif
+#if defined(TCP_FASTOPEN) && !defined(_WIN32)
+    if (policy.fast_open_queue > 0 && !m_unix_socket)
+        set_socket_option(listener, IPPROTO_TCP, TCP_FASTOPEN, policy.fast_open_queue, "TCP_FASTOPEN");
+#endif
+
+#ifdef __linux__
+    // Sockets accepted on Linux inherit these, so accepting costs no extra system calls.
+    apply_connection_policy(listener);
+#endif
+}
+
+void HttpServer::apply_connection_policy(socket_t socket) const
+{
+    const SocketPolicy &policy = m_config.socket_policy;
+
+    if (policy.nagle == NagleStrategy::NoDelay && !m_unix_socket)
+        set_socket_option(socket, IPPROTO_TCP, TCP_NODELAY, 1, "TCP_NODELAY");
+    if (policy.send_buffer_size > 0)
+        set_socket_option(socket, SOL_SOCKET, SO_SNDBUF, policy.send_buffer_size, "SO_SNDBUF");
+    if (policy.receive_buffer_size > 0)
+        set_socket_option(socket, SOL_SOCKET, SO_RCVBUF, policy.receive_buffer_size, "SO_RCVBUF");
+#ifdef SO_BUSY_POLL
+    if (policy.busy_poll_us > 0)
+        set_socket_option(socket, SOL_SOCKET, SO_BUSY_POLL, policy.busy_poll_us, "SO_BUSY_POLL");
+#endif
+}
+
+// Corks the connection while a response is written, so its pieces leave in full
+// segments; uncorking sends the remainder at once.
+void HttpServer::set_corked(Connection &connection, bool corked) const
+{
+#ifdef TCP_CORK
+    if (m_config.socket_policy.nagle != NagleStrategy::Cork || m_unix_socket || connection.is_corked() == corked)
+        return;
+
+    int value = corked ? 1 : 0;
+    setsockopt(connection.get_fd(), IPPROTO_TCP, TCP_CORK, &value, sizeof(value));
+    connection.set_corked(corked);
+#else
+    (void)connection;
+    (void)corked;
+#endif
+}
+
+void HttpServer::log_connected(size_t count) const
+{
+    if (count == 1)
+        m_logger.debug() << "Client connected";
+    else
+        m_logger.debug() << count << " clients connected";
+}
+
+void HttpServer::log_shed_connection() const
+{
+    m_logger.error() << "Out of file descriptors; dropped a pending connection";
+}
+
+void HttpServer::stop()
+{
+    m_running = false;
+    m_serving = false;
+
+    {
+        std::lock_guard<std::mutex> lock(m_io_loops_mutex);
+        for (auto &loop : m_io_loops)
+            loop->stop();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_drain_mutex);
+    }
+    m_drain_condition.notify_all();
+
+#ifdef _WIN32
+    closesocket(m_server_socket.release());
+#else
+    // Shutting down a listener would also stop a successor it was handed to.
+    if (m_draining)
+        return;
+
+    shutdown(m_server_socket.get(), SHUT_RDWR);
+
+    for (const auto &shard_socket : m_shard_sockets)
+        shutdown(shard_socket.get(), SHUT_RDWR);
+#endif
+}
+
+void HttpServer::drain()
+{
+    if (!m_running || m_draining.exchange(true))
+        return;
+
+    m_logger.info() << "Draining connections...";
+
+    {
+        std::lock_guard<std::mutex> lock(m_io_loops_mutex);
+        for (auto &loop : m_io_loops)
+            loop->drain();
+    }
+
+#ifdef _WIN32
+    closesocket(m_server_socket.release());
+#endif
+
+    {
+        std::lock_guard<std::mutex> lock(m_drain_mutex);
+    }
+    m_drain_condition.notify_all();
+}
+
+// Returns once the server stops, or once it is draining and drained() holds
+// or the drain timeout passes.
+void HttpServer::wait_for_drain(const std::function<bool()> &drained)
+{
+    std::unique_lock<std::mutex> lock(m_drain_mutex);
+    m_drain_condition.wait(lock, [this]
+                           { return !m_running || m_draining; });
+
+    if (!m_drain_condition.wait_for(lock, m_config.drain_timeout, [this, &drained]
+                                    { return !m_running || drained(); }))
+    {
+        m_logger.error() << "Drain timeout expired; closing remaining connections";
+    }
+}
+
+void HttpServer::notify_drain(size_t &counter)
 {
-    init_thread_pool();
+    {
+        std::lock_guard<std::mutex> lock(m_drain_mutex);
+        --counter;
+    }
+    m_drain_condition.notify_all();
 }
 
-HttpServer::~HttpServer()
+#ifndef _WIN32
+bool HttpServer::hand_off(char *const argv[])
 {
-    shutdown_thread_pool();
-    std::cout << "Server socket closed\n";
+    std::vector<socket_t> listeners = {m_server_socket.get()};
+    for (const auto &shard_socket : m_shard_sockets)
+        listeners.push_back(shard_socket.get());
+
+    pid_t pid = m_running ? spawn_with_listen_fds(argv[0], argv, listeners) : -1;
+    int error = m_running ? errno : ENOTCONN;
+
+    if (pid < 0)
+    {
+        m_logger.error() << "Failed to start " << argv[0] << ": " << strerror(error);
+        return false;
+    }
+
+    m_handed_off = true;
+    m_logger.info() << "Handed listening sockets to process " << pid;
+    return true;
 }
+#endif
 
-void HttpServer::set_router(const Router &router)
+bool HttpServer::is_running() const
 {
-    m_router = router;
+    return m_serving;
 }
 
-const Router &HttpServer::get_router() const
+bool HttpServer::is_draining() const
 {
-    return m_router;
+    return m_draining;
 }
 
-int HttpServer::run(int port, int connection_backlog, int reuse)
+int HttpServer::get_port() const
 {
-    std::cout << std::unitbuf;
-    std::cerr << std::unitbuf;
+    if (m_server_address.ss_family != AF_INET)
+        return 0;
+    return ntohs(reinterpret_cast<const struct sockaddr_in &>(m_server_address).sin_port);
+}
 
-    m_server_socket.reset(socket(AF_INET, SOCK_STREAM, 0));
+std::vector<IoLoopStats> HttpServer::get_io_loop_stats()
+{
+    std::lock_guard<std::mutex> lock(m_io_loops_mutex);
 
-    if (!m_server_socket.is_valid())
-    {
-        int error = get_last_error();
-        std::cerr << "Failed to create server socket: " << get_error_string(error) << "\n";
-        return 1;
-    }
+    std::vector<IoLoopStats> stats;
+    for (const auto &loop : m_io_loops)
+        stats.push_back(loop->get_stats());
 
-    if (setsockopt(m_server_socket.get(), SOL_SOCKET, SO_REUSEADDR, (const char *)&reuse, sizeof(reuse)) < 0)
-    {
-        int error = get_last_error();
-        std::cerr << "setsockopt failed: " << get_error_string(error) << "\n";
-        return 1;
-    }
+    return stats;
+}
+
+void HttpServer::handle_client(SocketWrapper client_socket)
+{
+    // A send that makes no progress for the stall timeout fails, so a reader
+    // that stops reading cannot hold a worker forever.
+    set_socket_timeout(client_socket.get(), SO_RCVTIMEO, receive_poll_interval_ms);
+    set_socket_timeout(client_socket.get(), SO_SNDTIMEO, m_config.send_stall_timeout.count());
+
+#ifndef __linux__
+    apply_connection_policy(client_socket.get());
+#endif
+
+    // Workers outlive the connections they serve, so each keeps its own pool.
+    static thread_local BufferPool buffer_pool(m_config.huge_page_buffers, m_config.topology.numa_local_buffers);
 
-    m_server_address.sin_family = AF_INET;
-    m_server_address.sin_addr.s_addr = INADDR_ANY;
-    m_server_address.sin_port = htons(port);
+    Connection connection(0, std::move(client_socket), buffer_pool, m_config.max_request_header_size,
+                          m_config.max_request_body_size, m_config.max_streamed_body_size,
+                          m_config.output_high_water_mark);
+    connection.set_router(&m_router);
+    capture_peer(connection);
+    bool keep_alive = true;
 
-    if (bind(m_server_socket.get(), (struct sockaddr *)&m_server_address, sizeof(m_server_address)) != 0)
+    while (keep_alive)
     {
-        int error = get_last_error();
-        std::cerr << "Failed to bind to port " << port << ": " << get_error_string(error) << "\n";
-        return 1;
+        std::vector<HttpRequest> requests(1);
+
+        if (receive_request(connection, requests.front()) <= 0)
+            return;
+
+        connection.extract_requests(requests);
+
+        // A worker is tied to its connection here, so persistence is only
+        // offered while no other accepted connection is waiting for a worker.
+        std::vector<HttpResponse> responses;
+        RequestOrigin origin{connection.get_peer(), std::chrono::steady_clock::now()};
+        keep_alive = process_requests(requests, origin, connection.get_requests_served(), !has_queued_tasks(), responses);
+        connection.count_requests(requests.size());
+
+        for (auto &response : responses)
+            connection.queue_response(std::move(response));
+
+        if (send_response(connection) < 0)
+        {
+            m_logger.error() << "Failed to send response to client";
+            return;
+        }
+
+        connection.touch();
     }
+}
+
+void HttpServer::handle_client_fd(socket_t client_fd)
+{
+    SocketWrapper client_socket(client_fd);
+    handle_client(std::move(client_socket));
+}
 
-    if (listen(m_server_socket.get(), connection_backlog) != 0)
+int HttpServer::receive_request(Connection &connection, HttpRequest &request)
+{
+    while (true)
     {
+        try
+        {
+            if (connection.extract_request(request))
+                break;
+        }
+        catch (const std::exception &e)
+        {
+            m_logger.error() << "Failed to parse HTTP request: " << e.what();
+            return -1;
+        }
+
+        // Checked on every pass, since a client trickling bytes never lets recv time out.
+        if (std::chrono::steady_clock::now() >= get_deadline(connection))
+        {
+            if (queue_timeout_response(connection))
+                send_response(connection);
+            return 0;
+        }
+
+        size_t space;
+        char *input = connection.reserve_input(space);
+        int bytes_received = recv(connection.get_fd(), input, static_cast<int>(space), 0);
+
+        if (bytes_received > 0)
+        {
+            connection.commit_input(bytes_received);
+            connection.touch();
+            continue;
+        }
+
+        if (bytes_received == 0)
+        {
+            m_logger.debug() << "Client disconnected";
+            return 0;
+        }
+
         int error = get_last_error();
-        std::cerr << "listen failed: " << get_error_string(error) << "\n";
-        return 1;
+
+        if (is_timeout_error(error))
+        {
+            bool idle = !connection.has_partial_request() && connection.get_requests_served() > 0;
+
+            if (!m_running || (idle && (m_draining || has_queued_tasks())))
+                return 0;
+
+            continue;
+        }
+
+        m_logger.error() << "Failed to receive request: " << get_error_string(error);
+        return -1;
     }
 
-    struct sockaddr_in client_address;
-    int client_address_length = sizeof(client_address);
+    m_logger.debug() << "Received request: " << http_method_to_string(request.get_method())
+                     << " " << request.get_uri();
 
-    std::cout << "Waiting for a client to connect...\n";
+    return 1;
+}
 
-    std::atomic<bool> running(true);
+int HttpServer::send_response(Connection &connection)
+{
+    set_corked(connection, true);
 
-    while (running)
+    while (true)
     {
-        socket_t client_fd = accept(m_server_socket.get(), (struct sockaddr *)&client_address, (socklen_t *)&client_address_length);
+        int flags = 0;
+#ifdef MSG_MORE
+        // Headers ahead of a file body are held back to share segments with it.
+        if (connection.has_pending_file_output())
+            flags = MSG_MORE;
+#endif
 
-#ifdef _WIN32
-        if (client_fd == INVALID_SOCKET)
+        while (connection.has_pending_output())
         {
-            int error = get_last_error();
-            if (error == WSAEINTR || error == WSAENOTSOCK)
-                break;
+#ifdef _WIN32
+            int bytes_sent = send(connection.get_fd(), connection.get_pending_segment(),
+                                  static_cast<int>(connection.get_pending_segment_size()), flags);
+#else
+            struct iovec vectors[Connection::max_output_vectors];
+            struct msghdr message{};
+            message.msg_iov = vectors;
+            message.msg_iovlen = connection.get_output_iovecs(vectors, Connection::max_output_vectors);
+
+            ssize_t bytes_sent = sendmsg(connection.get_fd(), &message, flags | MSG_NOSIGNAL);
+#endif
+
+            if (bytes_sent < 0)
             {
-                std::lock_guard<std::mutex> lock(m_output_mutex);
-                std::cerr << "Failed to accept connection: " << get_error_string(error) << "\n";
+                int error = get_last_error();
+                m_logger.error() << "Failed to send response: " << get_error_string(error);
+                return -1;
             }
-            continue;
+
+            connection.consume_output(bytes_sent);
         }
-#else
-        if (client_fd < 0)
+
+        while (connection.has_pending_file_output())
         {
-            if (errno == EINTR || errno == EBADF)
-                break;
+            long bytes_sent = send_file_part(connection.get_fd(), *connection.get_body_file(),
+                                             connection.get_file_offset(), connection.get_pending_file_size());
+
+            if (bytes_sent <= 0)
             {
-                std::lock_guard<std::mutex> lock(m_output_mutex);
-                std::cerr << "Failed to accept connection: " << strerror(errno) << "\n";
+                int error = get_last_error();
+                m_logger.error() << "Failed to send response file: "
+                                 << (bytes_sent == 0 ? "file is shorter than its size" : get_error_string(error));
+                return -1;
             }
-            continue;
+
+            connection.consume_file_output(bytes_sent);
         }
-#endif
 
+        if (connection.has_pending_output())
+            continue;
+
+        // The blocking send above is the flow control: a streamed body is
+        // produced up to the high-water mark, then sent before producing more.
+        std::shared_ptr<ResponseStream> stream = connection.get_body_stream();
+        if (!stream)
         {
-            std::lock_guard<std::mutex> lock(m_output_mutex);
-            std::cout << "Client connected\n";
+            set_corked(connection, false);
+            return 1;
         }
 
+        while (stream && connection.get_pending_output_size() < m_config.output_high_water_mark)
         {
-            std::lock_guard<std::mutex> lock(m_queue_mutex);
-            m_task_queue.emplace(std::bind(&HttpServer::handle_client_fd, this, client_fd));
+            std::string output;
+            if (!produce_body(*stream, output))
+                return -1;
+
+            connection.queue_body_output(std::move(output));
+            stream = connection.get_body_stream();
         }
-        m_condition.notify_one();
     }
+}
 
-    return 0;
+bool HttpServer::should_keep_alive(const HttpRequest &request, size_t requests_served) const
+{
+    return m_running && !m_draining && request.is_keep_alive() && requests_served < m_config.max_keep_alive_requests;
 }
 
-void HttpServer::handle_client(SocketWrapper client_socket)
+bool HttpServer::finalize_response(HttpResponse &response, bool keep_alive, bool chunked_allowed) const
 {
-    HttpRequest request;
+    HttpCode code = response.get_code();
+    bool has_body = static_cast<int>(code) >= 200 && code != HttpCode::NoContent && code != HttpCode::NotModified;
 
-    if (receive_request(client_socket, request) < 0)
+    if (!has_body)
     {
-        {
-            std::lock_guard<std::mutex> lock(m_output_mutex);
-            int error = get_last_error();
-            std::cerr << "Failed to receive request: " << get_error_string(error) << "\n";
-        }
-        return;
+        response.set_body_stream(nullptr);
+        response.set_body_file(nullptr);
     }
 
-    HttpResponse response = m_router.handle_request(request);
-
-    if (send_response(client_socket, response) < 0)
+    // A streamed body without a known length is chunked, or delimited by
+    // closing the connection for clients that predate chunked coding.
+    if (has_body && response.is_streaming() && !response.has_header("Content-Length"))
     {
-        std::lock_guard<std::mutex> lock(m_output_mutex);
-        std::cerr << "Failed to send response to client\n";
+        if (chunked_allowed)
+            response.add_header("Transfer-Encoding", "chunked");
+        else
+            keep_alive = false;
     }
-    else
+    else if (has_body && !response.has_header("Content-Length"))
     {
-        std::lock_guard<std::mutex> lock(m_output_mutex);
-        std::cout << "Request processed: " << static_cast<int>(request.get_method())
-                  << " " << request.get_uri() << " -> "
-                  << static_cast<int>(response.get_code()) << "\n";
+        const auto &file = response.get_body_file();
+        response.add_header("Content-Length", std::to_string(file ? file->get_size() : response.get_body().size()));
     }
+
+    if (response.has_header("Connection"))
+        return keep_alive && !iequals(response.get_header("Connection"), "close");
+
+    response.add_header("Connection", keep_alive ? "keep-alive" : "close");
+    return keep_alive;
 }
 
-void HttpServer::handle_client_fd(socket_t client_fd)
+bool HttpServer::process_requests(const std::vector<HttpRequest> &requests, const RequestOrigin &origin,
+                                  size_t requests_served, bool keep_alive_allowed, std::vector<HttpResponse> &responses)
 {
-    SocketWrapper client_socket(client_fd);
-    handle_client(std::move(client_socket));
+    bool keep_alive = true;
+
+    // Pipelined requests are answered in order; anything after a request that
+    // closes the connection is dropped.
+    for (const auto &request : requests)
+    {
+        HttpResponse response = process_request(request);
+        keep_alive = finalize_response(response, keep_alive_allowed && should_keep_alive(request, ++requests_served),
+                                       request.get_version() != "HTTP/1.0");
+        record_access(request, response, origin);
+        responses.push_back(std::move(response));
+
+        if (!keep_alive)
+            break;
+    }
+
+    return keep_alive;
 }
 
-int HttpServer::receive_request(const SocketWrapper &client_socket, HttpRequest &request)
+ExecutionPolicy HttpServer::get_request_policy(const HttpRequest &request, bool inline_handlers) const
 {
-    char buffer[4096];
-    int bytes_received = recv(client_socket.get(), buffer, sizeof(buffer) - 1, 0);
+    ExecutionPolicy policy = m_router.get_execution_policy(request);
+    return policy == ExecutionPolicy::Worker && inline_handlers ? ExecutionPolicy::Inline : policy;
+}
+
+std::optional<ExecutionPolicy> HttpServer::get_batch_policy(const std::vector<HttpRequest> &requests,
+                                                            bool inline_handlers) const
+{
+    std::optional<ExecutionPolicy> batch;
 
-    if (bytes_received <= 0)
+    for (const auto &request : requests)
     {
-        std::lock_guard<std::mutex> lock(m_output_mutex);
-        if (bytes_received == 0)
-            std::cout << "Client disconnected\n";
+        if (m_router.is_async(request))
+            return std::nullopt;
+
+        ExecutionPolicy policy = get_request_policy(request, inline_handlers);
+        if (batch && *batch != policy)
+            return std::nullopt;
+        batch = policy;
+    }
+
+    return batch;
+}
+
+Async<bool> HttpServer::process_requests_async(std::vector<HttpRequest> requests, RequestOrigin origin,
+                                               size_t requests_served, bool inline_handlers,
+                                               std::vector<HttpResponse> &responses)
+{
+    bool keep_alive = true;
+
+    for (const auto &request : requests)
+    {
+        HttpResponse response;
+
+        bool async = m_router.is_async(request);
+        ExecutionPolicy policy = async ? ExecutionPolicy::Inline : get_request_policy(request, inline_handlers);
+
+        if (async)
+        {
+            response = co_await process_request_async(request);
+        }
+        else if (policy == ExecutionPolicy::Inline)
+        {
+            response = process_request(request);
+        }
         else
         {
-            int error = get_last_error();
-            std::cerr << "Failed to receive request: " << get_error_string(error) << "\n";
+            OffloadedRequest offloaded{*this, request, HttpResponse(), policy};
+            response = co_await offloaded;
+
+            // A shed request closes the connection, dropping those behind it.
+            if (offloaded.shed)
+            {
+                finalize_response(response, false);
+                record_access(request, response, origin);
+                responses.push_back(std::move(response));
+                co_return false;
+            }
         }
 
-        return bytes_received;
+        keep_alive = finalize_response(response, should_keep_alive(request, ++requests_served),
+                                       request.get_version() != "HTTP/1.0");
+        record_access(request, response, origin);
+        responses.push_back(std::move(response));
+
+        if (!keep_alive)
+            break;
     }
 
-    buffer[bytes_received] = '\0';
+    co_return keep_alive;
+}
 
-    {
-        std::lock_guard<std::mutex> lock(m_output_mutex);
-        std::cout << "Received request:\n"
-                  << buffer << "\n";
-    }
+Async<HttpResponse> HttpServer::process_request_async(const HttpRequest &request)
+{
+    co_return co_await m_router.handle_request_async(request);
+}
+
+void HttpServer::OffloadedRequest::await_suspend(std::coroutine_handle<> handle)
+{
+    IoLoop *loop = IoLoop::get_current();
+
+    server.enqueue_task([this, loop, handle]
+                        {
+                            response = server.process_request(request);
+                            loop->post([handle]
+                                       { handle.resume(); }); },
+                        [this, loop, handle]
+                        {
+                            response = server.get_overload_response();
+                            shed = true;
+                            loop->post([handle]
+                                       { handle.resume(); }); },
+                        policy);
+}
 
+bool HttpServer::produce_body(ResponseStream &stream, std::string &output)
+{
     try
     {
-        request = HttpRequest::from_string(std::string(buffer, bytes_received));
+        output = stream.produce();
+        return true;
     }
     catch (const std::exception &e)
     {
-        std::lock_guard<std::mutex> lock(m_output_mutex);
-        std::cerr << "Failed to parse HTTP request: " << e.what() << "\n";
-        return -1;
+        m_logger.error() << "Failed to produce response body: " << e.what();
+        return false;
     }
+}
 
-    return bytes_received;
+HttpResponse HttpServer::process_request(const HttpRequest &request)
+{
+    return m_router.handle_request(request);
 }
 
-int HttpServer::send_response(const SocketWrapper &client_socket, HttpResponse &response)
+void HttpServer::record_access(const HttpRequest &request, const HttpResponse &response,
+                               const RequestOrigin &origin) const
 {
-    std::string response_str = response.to_string();
-    int bytes_sent = send(client_socket.get(), response_str.c_str(), response_str.size(), 0);
+    int status = static_cast<int>(response.get_code());
+    if (!m_access_log || !m_access_log->should_record(status))
+        return;
 
-    if (bytes_sent < 0)
-    {
-        std::lock_guard<std::mutex> lock(m_output_mutex);
-        int error = get_last_error();
-        std::cerr << "Failed to send response: " << get_error_string(error) << "\n";
-    }
+    // A streamed body's size is not known when its head is queued.
+    const auto &file = response.get_body_file();
+    uint64_t bytes = response.get_head_size() + (file ? file->get_size() : response.get_body().size());
+    m_access_log->record(request.get_method(), request.get_uri(), status, bytes,
+                         std::chrono::steady_clock::now() - origin.dispatched, origin.peer);
+}
 
-    return bytes_sent;
+void HttpServer::capture_peer(Connection &connection) const
+{
+    if (m_access_log)
+        connection.set_peer(get_peer_address(connection.get_fd()));
 }
 
 HttpResponse HttpServer::serve_static_file(const std::string &file_path, const std::string &web_root)
@@ -332,8 +1342,8 @@ HttpResponse HttpServer::serve_static_file(const std::string &file_path, const s
         return response;
     }
 
-    std::ifstream file(canonical_full_path, std::ios::binary);
-    if (!file.is_open())
+    std::shared_ptr<FileBody> file = FileBody::open(canonical_full_path.string());
+    if (!file)
     {
         response.set_code(HttpCode::InternalServerError);
         response.set_body("<html><body><h1>500 Internal Server Error</h1></body></html>");
@@ -341,10 +1351,6 @@ HttpResponse HttpServer::serve_static_file(const std::string &file_path, const s
         return response;
     }
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    std::string content = buffer.str();
-
     std::string extension = canonical_full_path.extension().string();
     std::string content_type = "text/plain";
 
@@ -386,61 +1392,222 @@ HttpResponse HttpServer::serve_static_file(const std::string &file_path, const s
     }
 
     response.set_code(HttpCode::OK);
-    response.set_body(content);
+    response.set_body_file(file);
     response.add_header("Content-Type", content_type);
-    response.add_header("Content-Length", std::to_string(content.length()));
+    response.add_header("Content-Length", std::to_string(file->get_size()));
 
     return response;
 }
 
-void HttpServer::init_thread_pool(size_t num_threads)
+// Each pool's queues hold its admission limit on top of their own capacity,
+// so admitted requests leave room for the continuations of work in progress.
+void HttpServer::init_thread_pool(const ThreadPlacement &placement)
 {
-    for (size_t i = 0; i < num_threads; ++i)
+    size_t workers = std::max<size_t>(1, placement.get_worker_count());
+    m_worker_pool.reset();
+    m_worker_pool = std::make_unique<WorkerPool>(workers, [this](QueuedTask &task)
+                                                 { execute_task(task); }, placement.worker_cpus,
+                                                 WorkerPool::queue_capacity + m_config.max_queue_depth / workers);
+
+    m_blocking_pool.reset();
+    if (m_config.blocking_workers > 0 && m_config.backend != IoBackend::Blocking)
     {
-        m_worker_threads.emplace_back(&HttpServer::worker_thread, this);
+        m_blocking_pool = std::make_unique<WorkerPool>(m_config.blocking_workers, [](QueuedTask &task)
+                                                       { task.run(); }, std::vector<CpuSet>(),
+                                                       WorkerPool::queue_capacity +
+                                                           m_config.max_blocking_queue_depth / m_config.blocking_workers);
     }
 }
 
-void HttpServer::worker_thread()
+void HttpServer::report_thread_placement(const std::vector<CpuSet> &io_cpus)
 {
-    while (true)
+    ThreadPlacement applied;
+    applied.io_cpus = io_cpus;
+    applied.worker_cpus = m_worker_pool->get_worker_cpus();
+    applied.isolation_failed = m_thread_placement.isolation_failed;
+
+    // One line each, as a queued line is short.
+    std::string report = format_thread_placement(applied);
+    for (size_t start = 0, end; (end = report.find('\n', start)) != std::string::npos; start = end + 1)
+        m_logger.info() << std::string_view(report).substr(start, end - start);
+}
+
+void HttpServer::execute_task(QueuedTask &task)
+{
+    auto now = std::chrono::steady_clock::now();
+    bool overloaded = is_overloaded(now - task.enqueued, now);
+
+    if (overloaded && task.shed)
+    {
+        ++m_tasks_shed;
+        task.shed();
+    }
+    else
+    {
+        task.run();
+    }
+}
+
+void HttpServer::enqueue_task(Task task, Task shed, ExecutionPolicy policy)
+{
+    if (policy == ExecutionPolicy::Blocking && m_blocking_pool)
     {
-        std::function<void()> task;
+        size_t limit = m_config.max_blocking_queue_depth;
+        if (shed && limit > 0 && m_blocking_pool->get_queued_count() >= limit)
         {
-            std::unique_lock<std::mutex> lock(m_queue_mutex);
-            m_condition.wait(lock, [this]
-                             { return m_stop_threads || !m_task_queue.empty(); });
+            ++m_tasks_shed;
+            shed();
+            return;
+        }
 
-            if (m_stop_threads && m_task_queue.empty())
-                break;
+        QueuedTask queued{std::move(task), std::move(shed), std::chrono::steady_clock::now()};
+        push_task(*m_blocking_pool, queued);
+        return;
+    }
 
-            task = std::move(m_task_queue.front());
-            m_task_queue.pop();
-        }
-        task();
+    if (shed && is_queue_full())
+    {
+        ++m_tasks_shed;
+        shed();
+        return;
     }
+
+    QueuedTask queued{std::move(task), std::move(shed), std::chrono::steady_clock::now()};
+    push_task(*m_worker_pool, queued);
 }
 
-void HttpServer::shutdown_thread_pool()
+void HttpServer::enqueue_clients(std::vector<socket_t> &client_fds)
 {
-    m_stop_threads = true;
-    m_condition.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(m_drain_mutex);
+        m_active_clients += client_fds.size();
+    }
 
-    for (auto &thread : m_worker_threads)
+    for (socket_t client_fd : client_fds)
     {
-        if (thread.joinable())
-        {
-            thread.join();
-        }
+        enqueue_task([this, client_fd]
+                     {
+                         handle_client_fd(client_fd);
+                         notify_drain(m_active_clients); },
+                     [this, client_fd]
+                     {
+                         shed_client(client_fd);
+                         notify_drain(m_active_clients); });
     }
 
-    m_worker_threads.clear();
+    client_fds.clear();
+}
 
+// Queues only fill past the admission limits when they are disabled or
+// continuations pile up. A task that can be shed is then answered with 503; one
+// that continues admitted work holds its producer until a worker frees a slot.
+void HttpServer::push_task(WorkerPool &pool, QueuedTask &task)
+{
+    while (!pool.push(task))
     {
-        std::lock_guard<std::mutex> lock(m_queue_mutex);
-        while (!m_task_queue.empty())
+        if (task.shed)
         {
-            m_task_queue.pop();
+            ++m_tasks_shed;
+            task.shed();
+            return;
         }
+
+        std::this_thread::yield();
+    }
+}
+
+size_t HttpServer::get_queued_count() const
+{
+    return m_worker_pool ? m_worker_pool->get_queued_count() : 0;
+}
+
+bool HttpServer::has_queued_tasks() const
+{
+    return get_queued_count() > 0;
+}
+
+bool HttpServer::is_queue_full() const
+{
+    return m_config.max_queue_depth > 0 && get_queued_count() >= m_config.max_queue_depth;
+}
+
+// Called for every task a worker takes, so CoDel sees the sojourn of the whole
+// queue and not only of the work it may shed. Below the target CoDel only
+// resets its state, so its lock is skipped until a task waits longer.
+bool HttpServer::is_overloaded(std::chrono::steady_clock::duration sojourn, std::chrono::steady_clock::time_point now)
+{
+    bool late = m_config.max_queue_delay.count() > 0 && sojourn > m_config.max_queue_delay;
+
+    if (m_config.queue_target_delay.count() <= 0)
+        return late;
+
+    bool below_target = sojourn < m_config.queue_target_delay;
+    if (below_target && m_codel_idle.load(std::memory_order_relaxed))
+        return late;
+
+    std::lock_guard<std::mutex> lock(m_codel_mutex);
+    bool dropping = m_codel.should_drop(sojourn, now, get_queued_count());
+    m_codel_idle.store(below_target, std::memory_order_relaxed);
+    return dropping || late;
+}
+
+// Built once per run, so refusing work costs a copy rather than a response.
+void HttpServer::build_overload_response()
+{
+    HttpResponse response;
+    response.set_code(HttpCode::ServiceUnavailable);
+    response.add_header("Content-Type", "text/html");
+    response.add_header("Retry-After", std::to_string(m_config.retry_after_seconds));
+    response.set_body("<html><body><h1>503 Service Unavailable</h1></body></html>");
+    finalize_response(response, false);
+
+    m_overload_bytes = response.to_string();
+    m_overload_response = std::move(response);
+}
+
+const HttpResponse &HttpServer::get_overload_response() const
+{
+    return m_overload_response;
+}
+
+// Refuses a connection of the blocking backend without tying up a worker.
+void HttpServer::shed_client(socket_t client_fd)
+{
+    SocketWrapper client_socket(client_fd);
+
+#ifdef _WIN32
+    send(client_fd, m_overload_bytes.data(), static_cast<int>(m_overload_bytes.size()), 0);
+#else
+    // Reading a request that already arrived keeps close() from resetting the
+    // connection before the client has read the 503.
+    char buffer[4096];
+    while (recv(client_fd, buffer, sizeof(buffer), MSG_DONTWAIT) > 0)
+    {
     }
+
+    send(client_fd, m_overload_bytes.data(), m_overload_bytes.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+#endif
+}
+
+uint64_t HttpServer::get_shed_count() const
+{
+    return m_tasks_shed;
+}
+
+std::vector<WorkerStats> HttpServer::get_worker_stats() const
+{
+    if (!m_worker_pool)
+        return {};
+    return m_worker_pool->get_stats();
+}
+
+Logger &HttpServer::get_logger()
+{
+    return m_logger;
+}
+
+void HttpServer::shutdown_thread_pool()
+{
+    m_blocking_pool.reset();
+    m_worker_pool.reset();
 }
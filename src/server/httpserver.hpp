@@ -3,15 +3,31 @@
 
 #include "http/httprequest.hpp"
 #include "http/httpresponse.hpp"
+#include "access_log.hpp"
+#include "async.hpp"
+#include "codel.hpp"
+#include "connection.hpp"
+#include "cpu_topology.hpp"
+#include "event_loop.hpp"
+#include "io_loop.hpp"
+#include "io_uring_loop.hpp"
+#include "logger.hpp"
 #include "router.hpp"
+#include "server_config.hpp"
 #include "socket_wrapper.hpp"
+#include "task.hpp"
+#include "worker_pool.hpp"
+#include <chrono>
 #include <mutex>
 #include <atomic>
 #include <condition_variable>
 #include <thread>
 #include <vector>
-#include <queue>
+#include <deque>
 #include <functional>
+#include <memory>
+#include <optional>
+#include <string>
 
 #ifdef _WIN32
 #include <winsock2.h>
@@ -24,21 +40,124 @@
 
 class HttpServer
 {
+#ifdef __linux__
+    friend class EventLoop;
+#endif
+#ifdef HAS_IO_URING
+    friend class IoUringLoop;
+#endif
+
 private:
     SocketWrapper m_server_socket;
-    struct sockaddr_in m_server_address;
+    std::vector<SocketWrapper> m_shard_sockets;
+    struct sockaddr_storage m_server_address;
+    bool m_unix_socket = false;
+    std::atomic<bool> m_handed_off{false};
     Router m_router;
-    mutable std::mutex m_output_mutex;
+    ServerConfig m_config;
+    // Declared early, so it outlives the threads that log to it.
+    mutable Logger m_logger;
+    // Set by run() when the config names a file; outlives the worker pool too.
+    std::unique_ptr<AccessLog> m_access_log;
+    std::atomic<bool> m_running{false};
+    // What is_running() reports: set only once the listeners and I/O loops exist.
+    std::atomic<bool> m_serving{false};
+    std::atomic<bool> m_draining{false};
+
+    // Signalled when a drain starts, the server stops, or an I/O loop or
+    // blocking client finishes, so run() can tell when draining is done.
+    std::mutex m_drain_mutex;
+    std::condition_variable m_drain_condition;
+    size_t m_running_loops = 0;
+    size_t m_active_clients = 0;
 
-    std::vector<std::thread> m_worker_threads;
-    std::queue<std::function<void()>> m_task_queue;
-    std::mutex m_queue_mutex;
-    std::condition_variable m_condition;
-    std::atomic<bool> m_stop_threads{false};
+    std::vector<std::unique_ptr<IoLoop>> m_io_loops;
+    std::mutex m_io_loops_mutex;
 
-    void worker_thread();
-    void init_thread_pool(size_t num_threads = std::thread::hardware_concurrency());
+    // Handler threads; each has its own run queue and steals from the others
+    // when it runs dry. They are started by run(), placed as the topology says.
+    ThreadPlacement m_thread_placement;
+    std::unique_ptr<WorkerPool> m_worker_pool;
+    // Threads for blocking routes, unpinned and outside admission control but
+    // for their queue's depth limit.
+    std::unique_ptr<WorkerPool> m_blocking_pool;
+    std::mutex m_codel_mutex;
+    std::atomic<bool> m_codel_idle{true};
+    CoDel m_codel{std::chrono::milliseconds(100), std::chrono::milliseconds(1000)};
+    std::atomic<uint64_t> m_tasks_shed{0};
+    HttpResponse m_overload_response;
+    std::string m_overload_bytes;
+
+    void execute_task(QueuedTask &task);
+    void init_thread_pool(const ThreadPlacement &placement);
+    void report_thread_placement(const std::vector<CpuSet> &io_cpus);
     void shutdown_thread_pool();
+    // Blocking tasks go to the blocking pool when there is one.
+    void enqueue_task(Task task, Task shed = nullptr, ExecutionPolicy policy = ExecutionPolicy::Worker);
+    void enqueue_clients(std::vector<socket_t> &client_fds);
+    void push_task(WorkerPool &pool, QueuedTask &task);
+    size_t get_queued_count() const;
+    bool has_queued_tasks() const;
+    bool is_queue_full() const;
+    bool is_overloaded(std::chrono::steady_clock::duration sojourn, std::chrono::steady_clock::time_point now);
+    void build_overload_response();
+    const HttpResponse &get_overload_response() const;
+    void shed_client(socket_t client_fd);
+
+    bool should_keep_alive(const HttpRequest &request, size_t requests_served) const;
+    bool finalize_response(HttpResponse &response, bool keep_alive, bool chunked_allowed = true) const;
+    bool process_requests(const std::vector<HttpRequest> &requests, const RequestOrigin &origin, size_t requests_served,
+                          bool keep_alive_allowed, std::vector<HttpResponse> &responses);
+    void record_access(const HttpRequest &request, const HttpResponse &response, const RequestOrigin &origin) const;
+    void capture_peer(Connection &connection) const;
+
+    // Hands a request with a synchronous handler from a coroutine on an I/O
+    // thread to the worker pool, and resumes the coroutine on that thread.
+    struct OffloadedRequest
+    {
+        HttpServer &server;
+        const HttpRequest &request;
+        HttpResponse response;
+        ExecutionPolicy policy;
+        bool shed = false;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle);
+        HttpResponse await_resume() { return std::move(response); }
+    };
+
+    // Answers a batch holding async routes or mixed policies as a coroutine on
+    // the calling I/O thread; synchronous handlers in it run inline or are
+    // offloaded as their policy says.
+    Async<bool> process_requests_async(std::vector<HttpRequest> requests, RequestOrigin origin, size_t requests_served,
+                                       bool inline_handlers, std::vector<HttpResponse> &responses);
+    Async<HttpResponse> process_request_async(const HttpRequest &request);
+    // Worker routes run inline when inline_handlers is set.
+    ExecutionPolicy get_request_policy(const HttpRequest &request, bool inline_handlers) const;
+    // The policy every request of a batch runs under, or none when the batch
+    // has to be run request by request.
+    std::optional<ExecutionPolicy> get_batch_policy(const std::vector<HttpRequest> &requests,
+                                                    bool inline_handlers) const;
+    bool produce_body(ResponseStream &stream, std::string &output);
+    std::chrono::steady_clock::time_point get_deadline(const Connection &connection) const;
+    bool queue_timeout_response(Connection &connection) const;
+
+    void log_connected(size_t count) const;
+    void log_shed_connection() const;
+
+    void set_socket_option(socket_t socket, int level, int option, int value, const char *name) const;
+    void apply_listener_policy(socket_t listener) const;
+    void apply_connection_policy(socket_t socket) const;
+    void set_corked(Connection &connection, bool corked) const;
+
+    SocketWrapper open_listener(int port, int connection_backlog, int reuse, bool reuse_port);
+    SocketWrapper open_unix_listener(int connection_backlog);
+    void remove_unix_socket_file() const;
+    void wait_for_drain(const std::function<bool()> &drained);
+    void notify_drain(size_t &counter);
+    int run_blocking();
+    int run_io_loops();
+    std::unique_ptr<IoLoop> create_io_loop(socket_t listen_fd, bool inline_handlers);
 
 public:
     HttpServer();
@@ -55,12 +174,37 @@ public:
     void set_router(const Router &router);
     const Router &get_router() const;
 
-    int run(int port = 8080, int connection_backlog = 5, int reuse = 1);
+    void set_config(const ServerConfig &config);
+    const ServerConfig &get_config() const;
+
+    // A connection_backlog of 0 uses the socket policy's backlog.
+    int run(int port = 8080, int connection_backlog = 0, int reuse = 1);
+    void stop();
+    // Stops accepting and lets started requests finish, closing each connection
+    // after its current response, until none remain or the drain timeout passes.
+    void drain();
+#ifndef _WIN32
+    // Starts argv[0] with this server's listening sockets (see listen_fds.hpp),
+    // so it accepts connections while this server drains.
+    bool hand_off(char *const argv[]);
+#endif
+    bool is_running() const;
+    bool is_draining() const;
+    // 0 when listening on a Unix socket.
+    int get_port() const;
+    std::vector<IoLoopStats> get_io_loop_stats();
+    // Requests answered with 503 by admission control.
+    uint64_t get_shed_count() const;
+    // Per-worker counters of the pool started by the last run().
+    std::vector<WorkerStats> get_worker_stats() const;
+    // The server's log, for handlers to write to as well.
+    Logger &get_logger();
 
     void handle_client(SocketWrapper client_socket);
     void handle_client_fd(socket_t client_fd);
-    int receive_request(const SocketWrapper &client_socket, HttpRequest &request);
-    int send_response(const SocketWrapper &client_socket, HttpResponse &response);
+    int receive_request(Connection &connection, HttpRequest &request);
+    int send_response(Connection &connection);
+    HttpResponse process_request(const HttpRequest &request);
 
     HttpResponse serve_static_file(const std::string &file_path, const std::string &web_root = "www");
 };
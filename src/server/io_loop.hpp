@@ -0,0 +1,67 @@
+#ifndef IO_LOOP_HPP
+#define IO_LOOP_HPP
+
+#include "async_io.hpp"
+#include "task.hpp"
+#include <atomic>
+#include <cstdint>
+
+struct IoLoopStats
+{
+    uint64_t connections_accepted = 0;
+    uint64_t requests_processed = 0;
+    uint64_t bytes_received = 0;
+    uint64_t bytes_sent = 0;
+};
+
+class IoLoop
+{
+private:
+    std::atomic<uint64_t> m_connections_accepted{0};
+    std::atomic<uint64_t> m_requests_processed{0};
+    std::atomic<uint64_t> m_bytes_received{0};
+    std::atomic<uint64_t> m_bytes_sent{0};
+
+    // Counters have a single writer, the loop's own thread, so a relaxed
+    // load/store pair is enough and avoids a locked read-modify-write.
+    static void add(std::atomic<uint64_t> &counter, uint64_t value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+protected:
+    void count_accepted() { add(m_connections_accepted, 1); }
+    void count_requests(uint64_t count) { add(m_requests_processed, count); }
+    void count_received(uint64_t bytes) { add(m_bytes_received, bytes); }
+    void count_sent(uint64_t bytes) { add(m_bytes_sent, bytes); }
+
+public:
+    virtual ~IoLoop() = default;
+
+    virtual void run() = 0;
+    virtual void stop() = 0;
+    // Stops accepting and closes idle keep-alive connections; the loop returns
+    // from run() once its remaining connections have closed.
+    virtual void drain() = 0;
+    virtual void post(Task callback) = 0;
+
+    // Carries out an operation a coroutine running on this loop's thread waits
+    // on, and resumes the coroutine on that thread once it completes.
+    virtual void start_operation(AsyncOperation &operation) = 0;
+
+    // The loop whose thread is calling, or nullptr off the loops' threads.
+    static IoLoop *get_current();
+    static void set_current(IoLoop *loop);
+
+    IoLoopStats get_stats() const
+    {
+        IoLoopStats stats;
+        stats.connections_accepted = m_connections_accepted.load(std::memory_order_relaxed);
+        stats.requests_processed = m_requests_processed.load(std::memory_order_relaxed);
+        stats.bytes_received = m_bytes_received.load(std::memory_order_relaxed);
+        stats.bytes_sent = m_bytes_sent.load(std::memory_order_relaxed);
+        return stats;
+    }
+};
+
+#endif // IO_LOOP_HPP
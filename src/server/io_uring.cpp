@@ -0,0 +1,333 @@
+#include "server/io_uring.hpp"
+
+#ifdef HAS_IO_URING
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static int io_uring_setup(unsigned entries, io_uring_params *params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+static int io_uring_register(int ring_fd, unsigned opcode, void *arg, unsigned nr_args)
+{
+    return static_cast<int>(syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args));
+}
+
+static unsigned load_acquire(unsigned *value)
+{
+    return std::atomic_ref<unsigned>(*value).load(std::memory_order_acquire);
+}
+
+static void store_release(unsigned *value, unsigned new_value)
+{
+    std::atomic_ref<unsigned>(*value).store(new_value, std::memory_order_release);
+}
+
+IoUring::IoUring(unsigned entries)
+    : m_ring_fd(-1),
+      m_sq_entries(0),
+      m_sq_ring(MAP_FAILED),
+      m_sq_ring_size(0),
+      m_cq_ring(MAP_FAILED),
+      m_cq_ring_size(0),
+      m_sqes(static_cast<io_uring_sqe *>(MAP_FAILED)),
+      m_sqes_size(0),
+      m_sqe_tail(0),
+      m_sqe_submitted(0)
+{
+    io_uring_params params{};
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN;
+    params.cq_entries = entries * 4;
+
+    m_ring_fd = io_uring_setup(entries, &params);
+
+    if (m_ring_fd < 0 && errno == EINVAL)
+    {
+        params = io_uring_params{};
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = entries * 4;
+        m_ring_fd = io_uring_setup(entries, &params);
+    }
+
+    if (m_ring_fd < 0)
+        throw std::runtime_error(std::string("io_uring_setup failed: ") + strerror(errno));
+
+    m_sq_entries = params.sq_entries;
+    m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        m_sq_ring_size = m_cq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+
+    m_sq_ring = mmap(nullptr, m_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_SQ_RING);
+
+    if (m_sq_ring == MAP_FAILED)
+    {
+        close(m_ring_fd);
+        throw std::runtime_error(std::string("Failed to map submission ring: ") + strerror(errno));
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        m_cq_ring = m_sq_ring;
+    else
+        m_cq_ring = mmap(nullptr, m_cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_CQ_RING);
+
+    m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    m_sqes = static_cast<io_uring_sqe *>(mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_SQES));
+
+    if (m_cq_ring == MAP_FAILED || m_sqes == MAP_FAILED)
+    {
+        int error = errno;
+        unmap_rings();
+        throw std::runtime_error(std::string("Failed to map completion ring: ") + strerror(error));
+    }
+
+    char *sq = static_cast<char *>(m_sq_ring);
+    m_sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    m_sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    m_sq_mask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    m_sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+
+    char *cq = static_cast<char *>(m_cq_ring);
+    m_cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    m_cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    m_cq_mask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    m_cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    m_sqe_tail = m_sqe_submitted = *m_sq_tail;
+}
+
+IoUring::~IoUring()
+{
+    unmap_rings();
+}
+
+void IoUring::unmap_rings()
+{
+    if (m_sqes != MAP_FAILED)
+        munmap(m_sqes, m_sqes_size);
+    if (m_cq_ring != MAP_FAILED && m_cq_ring != m_sq_ring)
+        munmap(m_cq_ring, m_cq_ring_size);
+    if (m_sq_ring != MAP_FAILED)
+        munmap(m_sq_ring, m_sq_ring_size);
+    if (m_ring_fd >= 0)
+        close(m_ring_fd);
+
+    m_sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+    m_cq_ring = m_sq_ring = MAP_FAILED;
+    m_ring_fd = -1;
+}
+
+int IoUring::get_fd() const
+{
+    return m_ring_fd;
+}
+
+io_uring_sqe *IoUring::get_sqe()
+{
+    if (m_sqe_tail - load_acquire(m_sq_head) >= m_sq_entries)
+    {
+        if (submit_and_wait(0) < 0 || m_sqe_tail - load_acquire(m_sq_head) >= m_sq_entries)
+            return nullptr;
+    }
+
+    unsigned index = m_sqe_tail & m_sq_mask;
+    io_uring_sqe *sqe = &m_sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+
+    m_sq_array[index] = index;
+    ++m_sqe_tail;
+
+    return sqe;
+}
+
+int IoUring::submit_and_wait(unsigned wait_count)
+{
+    store_release(m_sq_tail, m_sqe_tail);
+
+    unsigned to_submit = m_sqe_tail - m_sqe_submitted;
+    unsigned flags = wait_count > 0 ? IORING_ENTER_GETEVENTS : 0;
+
+    if (to_submit == 0 && wait_count == 0)
+        return 0;
+
+    int result;
+    do
+    {
+        result = io_uring_enter(m_ring_fd, to_submit, wait_count, flags);
+    } while (result < 0 && errno == EINTR && wait_count == 0);
+
+    if (result < 0)
+        return errno == EINTR || errno == EBUSY || errno == EAGAIN ? 0 : -errno;
+
+    m_sqe_submitted += result;
+    return result;
+}
+
+unsigned IoUring::for_each_cqe(const std::function<void(const io_uring_cqe &)> &callback)
+{
+    unsigned head = *m_cq_head;
+    unsigned tail = load_acquire(m_cq_tail);
+    unsigned count = 0;
+
+    while (head != tail)
+    {
+        callback(m_cqes[head & m_cq_mask]);
+        ++head;
+        ++count;
+
+        store_release(m_cq_head, head);
+
+        if (head == tail)
+            tail = load_acquire(m_cq_tail);
+    }
+
+    return count;
+}
+
+int IoUring::register_buffer_ring(io_uring_buf_ring *ring, unsigned entries, uint16_t group_id)
+{
+    io_uring_buf_reg registration{};
+    registration.ring_addr = reinterpret_cast<uint64_t>(ring);
+    registration.ring_entries = entries;
+    registration.bgid = group_id;
+
+    return io_uring_register(m_ring_fd, IORING_REGISTER_PBUF_RING, &registration, 1) < 0 ? -errno : 0;
+}
+
+int IoUring::unregister_buffer_ring(uint16_t group_id)
+{
+    io_uring_buf_reg registration{};
+    registration.bgid = group_id;
+
+    return io_uring_register(m_ring_fd, IORING_UNREGISTER_PBUF_RING, &registration, 1) < 0 ? -errno : 0;
+}
+
+ProvidedBuffers::ProvidedBuffers(IoUring &ring, uint16_t group_id, unsigned entries, size_t buffer_size, bool use_buffer_ring)
+    : m_ring(ring),
+      m_group_id(group_id),
+      m_entries(entries),
+      m_buffer_size(buffer_size),
+      m_buffers(new char[entries * buffer_size]),
+      m_buffer_ring(nullptr),
+      m_buffer_ring_size(entries * sizeof(io_uring_buf)),
+      m_tail(0)
+{
+    if (use_buffer_ring && setup_buffer_ring())
+        return;
+
+    provide(0, m_entries);
+    m_ring.submit_and_wait(0);
+}
+
+ProvidedBuffers::~ProvidedBuffers()
+{
+    if (m_buffer_ring)
+    {
+        m_ring.unregister_buffer_ring(m_group_id);
+        munmap(m_buffer_ring, m_buffer_ring_size);
+    }
+
+    delete[] m_buffers;
+}
+
+bool ProvidedBuffers::setup_buffer_ring()
+{
+    void *memory = mmap(nullptr, m_buffer_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (memory == MAP_FAILED)
+        return false;
+
+    m_buffer_ring = static_cast<io_uring_buf_ring *>(memory);
+
+    if (m_ring.register_buffer_ring(m_buffer_ring, m_entries, m_group_id) < 0)
+    {
+        munmap(m_buffer_ring, m_buffer_ring_size);
+        m_buffer_ring = nullptr;
+        return false;
+    }
+
+    for (unsigned i = 0; i < m_entries; ++i)
+        recycle(static_cast<uint16_t>(i));
+
+    return true;
+}
+
+void ProvidedBuffers::provide(uint16_t buffer_id, unsigned count)
+{
+    io_uring_sqe *sqe = m_ring.get_sqe();
+    if (!sqe)
+    {
+        m_unprovided.emplace_back(buffer_id, count);
+        return;
+    }
+
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = static_cast<int32_t>(count);
+    sqe->addr = reinterpret_cast<uint64_t>(m_buffers + buffer_id * m_buffer_size);
+    sqe->len = static_cast<uint32_t>(m_buffer_size);
+    sqe->off = buffer_id;
+    sqe->buf_group = m_group_id;
+    sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+    sqe->user_data = 0;
+}
+
+uint16_t ProvidedBuffers::get_group_id() const
+{
+    return m_group_id;
+}
+
+bool ProvidedBuffers::uses_buffer_ring() const
+{
+    return m_buffer_ring != nullptr;
+}
+
+const char *ProvidedBuffers::get_buffer(uint16_t buffer_id) const
+{
+    return m_buffers + buffer_id * m_buffer_size;
+}
+
+void ProvidedBuffers::recycle(uint16_t buffer_id)
+{
+    if (!m_buffer_ring)
+    {
+        provide(buffer_id, 1);
+        return;
+    }
+
+    // Not m_buffer_ring->bufs: the header declares it through an empty struct,
+    // which has a size in C++ and moves the array 8 bytes off the ring start.
+    io_uring_buf &buffer = reinterpret_cast<io_uring_buf *>(m_buffer_ring)[m_tail & (m_entries - 1)];
+    buffer.addr = reinterpret_cast<uint64_t>(m_buffers + buffer_id * m_buffer_size);
+    buffer.len = static_cast<uint32_t>(m_buffer_size);
+    buffer.bid = buffer_id;
+
+    ++m_tail;
+    std::atomic_ref<uint16_t>(m_buffer_ring->tail).store(m_tail, std::memory_order_release);
+}
+
+void ProvidedBuffers::provide_pending()
+{
+    // provide() queues whatever still finds no SQE again.
+    std::vector<std::pair<uint16_t, unsigned>> pending = std::move(m_unprovided);
+    m_unprovided.clear();
+
+    for (auto [buffer_id, count] : pending)
+        provide(buffer_id, count);
+}
+
+#endif // HAS_IO_URING
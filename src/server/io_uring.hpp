@@ -0,0 +1,103 @@
+#ifndef IO_URING_HPP
+#define IO_URING_HPP
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+
+// Older headers leave the backend out. Registered buffer rings (Linux 5.19)
+// are an enumerator the preprocessor cannot test, but multishot receive came
+// after them, in Linux 6.0.
+#if defined(IORING_RECV_MULTISHOT) && defined(IORING_ACCEPT_MULTISHOT) && defined(IORING_SETUP_COOP_TASKRUN)
+#define HAS_IO_URING 1
+#endif
+#endif
+
+#ifdef HAS_IO_URING
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+class IoUring
+{
+private:
+    int m_ring_fd;
+    unsigned m_sq_entries;
+
+    void *m_sq_ring;
+    size_t m_sq_ring_size;
+    void *m_cq_ring;
+    size_t m_cq_ring_size;
+    io_uring_sqe *m_sqes;
+    size_t m_sqes_size;
+
+    unsigned *m_sq_head;
+    unsigned *m_sq_tail;
+    unsigned m_sq_mask;
+    unsigned *m_sq_array;
+    unsigned m_sqe_tail;
+    unsigned m_sqe_submitted;
+
+    unsigned *m_cq_head;
+    unsigned *m_cq_tail;
+    unsigned m_cq_mask;
+    io_uring_cqe *m_cqes;
+
+    void unmap_rings();
+
+public:
+    explicit IoUring(unsigned entries);
+
+    IoUring(const IoUring &) = delete;
+    IoUring &operator=(const IoUring &) = delete;
+
+    ~IoUring();
+
+    int get_fd() const;
+
+    io_uring_sqe *get_sqe();
+    int submit_and_wait(unsigned wait_count);
+    unsigned for_each_cqe(const std::function<void(const io_uring_cqe &)> &callback);
+
+    int register_buffer_ring(io_uring_buf_ring *ring, unsigned entries, uint16_t group_id);
+    int unregister_buffer_ring(uint16_t group_id);
+};
+
+class ProvidedBuffers
+{
+private:
+    IoUring &m_ring;
+    uint16_t m_group_id;
+    unsigned m_entries;
+    size_t m_buffer_size;
+    char *m_buffers;
+    io_uring_buf_ring *m_buffer_ring;
+    size_t m_buffer_ring_size;
+    uint16_t m_tail;
+    // Buffer ranges returned while the submission queue was full.
+    std::vector<std::pair<uint16_t, unsigned>> m_unprovided;
+
+    bool setup_buffer_ring();
+    void provide(uint16_t buffer_id, unsigned count);
+
+public:
+    ProvidedBuffers(IoUring &ring, uint16_t group_id, unsigned entries, size_t buffer_size, bool use_buffer_ring);
+
+    ProvidedBuffers(const ProvidedBuffers &) = delete;
+    ProvidedBuffers &operator=(const ProvidedBuffers &) = delete;
+
+    ~ProvidedBuffers();
+
+    uint16_t get_group_id() const;
+    bool uses_buffer_ring() const;
+    const char *get_buffer(uint16_t buffer_id) const;
+    void recycle(uint16_t buffer_id);
+    // Hands back buffers that found no free SQE; call once the ring was submitted.
+    void provide_pending();
+};
+
+#endif
+
+#endif // IO_URING_HPP
@@ -0,0 +1,1047 @@
+#include "server/io_uring_loop.hpp"
+
+#ifdef HAS_IO_URING
+
+#include "server/httpserver.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static HttpResponse make_bad_request_response()
+{
+    HttpResponse response;
+    response.set_code(HttpCode::BadRequest);
+    response.add_header("Content-Type", "text/html");
+    response.set_body("<html><body><h1>400 Bad Request</h1></body></html>");
+    return response;
+}
+
+IoUringLoop::IoUringLoop(HttpServer &server, socket_t listen_fd, bool use_buffer_ring, bool inline_handlers)
+    : m_server(server),
+      m_listen_fd(listen_fd),
+      m_inline_handlers(inline_handlers),
+      m_ring(ring_entries),
+      m_buffers(m_ring, buffer_group_id, buffer_count, buffer_size, use_buffer_ring),
+      m_wake_fd(eventfd(0, EFD_CLOEXEC)),
+      m_wake_value(0),
+      m_next_id(1),
+      m_timers(timer_tick),
+      m_buffer_pool(server.get_config().huge_page_buffers, server.get_config().topology.numa_local_buffers)
+{
+    if (!m_wake_fd.is_valid())
+        throw std::runtime_error(std::string("Failed to create wake descriptor: ") + strerror(errno));
+
+    // Submitted here rather than in run(), so the accept is in the kernel by
+    // the time the server reports it is running.
+    arm_accept();
+    arm_wake();
+    m_ring.submit_and_wait(0);
+}
+
+uint64_t IoUringLoop::encode(Operation operation, uint64_t id)
+{
+    return (static_cast<uint64_t>(operation) << 56) | id;
+}
+
+io_uring_sqe *IoUringLoop::next_sqe()
+{
+    io_uring_sqe *sqe = m_ring.get_sqe();
+
+    if (!sqe)
+        m_server.m_logger.error() << "io_uring submission queue is full";
+
+    return sqe;
+}
+
+void IoUringLoop::run()
+{
+    set_current(this);
+
+    while (!m_stopping)
+    {
+        m_buffers.provide_pending();
+        arm_timer();
+        int result = m_ring.submit_and_wait(1);
+
+        if (result < 0)
+        {
+            m_server.m_logger.error() << "io_uring_enter failed: " << strerror(-result);
+            break;
+        }
+
+        m_ring.for_each_cqe([this](const io_uring_cqe &cqe)
+                            { handle_completion(cqe); });
+
+        m_timers.advance(std::chrono::steady_clock::now(), [this](TimerWheel::Timer &timer)
+                         { expire_timer(timer.get_owner()); });
+
+        if (m_accepted_unlogged > 0)
+        {
+            m_server.log_connected(m_accepted_unlogged);
+            m_accepted_unlogged = 0;
+        }
+    }
+
+    std::vector<uint64_t> ids;
+    for (const auto &[id, entry] : m_connections)
+        ids.push_back(id);
+
+    for (uint64_t id : ids)
+        close_connection(id);
+
+    while ((!m_connections.empty() || m_reads_in_flight > 0) && m_ring.submit_and_wait(1) >= 0)
+    {
+        m_ring.for_each_cqe([this](const io_uring_cqe &cqe)
+                            { handle_completion(cqe); });
+    }
+
+    set_current(nullptr);
+}
+
+void IoUringLoop::stop()
+{
+    m_stopping = true;
+
+    uint64_t value = 1;
+    [[maybe_unused]] ssize_t written = write(m_wake_fd.get(), &value, sizeof(value));
+}
+
+void IoUringLoop::post(Task callback)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_pending_mutex);
+        m_pending.push_back(std::move(callback));
+    }
+
+    uint64_t value = 1;
+    [[maybe_unused]] ssize_t written = write(m_wake_fd.get(), &value, sizeof(value));
+}
+
+void IoUringLoop::arm_accept()
+{
+    io_uring_sqe *sqe = next_sqe();
+    if (!sqe)
+        return;
+
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = m_listen_fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = encode(Operation::Accept, 0);
+}
+
+// Takes one connection off the listen queue with the reserved descriptor
+// released, so it can be closed; accepting resumes once it completes.
+void IoUringLoop::arm_shed()
+{
+    io_uring_sqe *sqe = next_sqe();
+    if (!sqe)
+    {
+        m_accept_reserve.restore();
+        arm_accept();
+        return;
+    }
+
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = m_listen_fd;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = encode(Operation::Shed, 0);
+}
+
+void IoUringLoop::arm_wake()
+{
+    io_uring_sqe *sqe = next_sqe();
+    if (!sqe)
+        return;
+
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = m_wake_fd.get();
+    sqe->addr = reinterpret_cast<uint64_t>(&m_wake_value);
+    sqe->len = sizeof(m_wake_value);
+    sqe->user_data = encode(Operation::Wake, 0);
+}
+
+void IoUringLoop::drain()
+{
+    post([this]
+         { begin_drain(); });
+}
+
+void IoUringLoop::arm_timer()
+{
+    auto now = std::chrono::steady_clock::now();
+    int timeout = m_timers.get_next_timeout_ms(now);
+    if (timeout < 0)
+        return;
+
+    auto deadline = now + std::chrono::milliseconds(timeout);
+    if (m_timer_pending && m_timer_deadline <= deadline)
+        return;
+
+    // An armed timeout that is later than the new deadline is replaced; its
+    // cancellation completes with the old generation and is ignored.
+    if (m_timer_pending)
+    {
+        io_uring_sqe *remove = next_sqe();
+        if (!remove)
+            return;
+
+        remove->opcode = IORING_OP_TIMEOUT_REMOVE;
+        remove->fd = -1;
+        remove->addr = encode(Operation::Timer, m_timer_generation);
+        remove->user_data = encode(Operation::None, 0);
+    }
+
+    io_uring_sqe *sqe = next_sqe();
+    if (!sqe)
+        return;
+
+    // The kernel copies the timespec when the request is prepared.
+    m_timer_timeout.tv_sec = timeout / 1000;
+    m_timer_timeout.tv_nsec = static_cast<long long>(timeout % 1000) * 1000000;
+
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->fd = -1;
+    sqe->addr = reinterpret_cast<uint64_t>(&m_timer_timeout);
+    sqe->len = 1;
+    sqe->user_data = encode(Operation::Timer, ++m_timer_generation);
+
+    m_timer_pending = true;
+    m_timer_deadline = deadline;
+}
+
+void IoUringLoop::arm_receive(uint64_t id, RingConnection &entry)
+{
+    io_uring_sqe *sqe = next_sqe();
+    if (!sqe)
+    {
+        close_connection(id);
+        return;
+    }
+
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = entry.connection->get_fd();
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = m_buffers.get_group_id();
+    sqe->user_data = encode(Operation::Receive, id);
+
+    ++entry.pending_operations;
+    entry.receiving = true;
+    entry.receive_cancelled = false;
+}
+
+void IoUringLoop::submit_output(uint64_t id, RingConnection &entry)
+{
+    Connection &connection = *entry.connection;
+
+    io_uring_sqe *sqe = next_sqe();
+    if (!sqe)
+    {
+        close_connection(id);
+        return;
+    }
+
+    // The message and its vectors live in the entry until the send completes;
+    // a partial send is continued from on_send.
+    entry.send_message = {};
+    entry.send_message.msg_iov = entry.send_vectors.data();
+    entry.send_message.msg_iovlen = connection.get_output_iovecs(entry.send_vectors.data(), entry.send_vectors.size());
+
+    // Headers ahead of a file body are held back to share segments with it.
+    int flags = MSG_NOSIGNAL | (connection.has_pending_file_output() ? MSG_MORE : 0);
+
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = connection.get_fd();
+    sqe->addr = reinterpret_cast<uint64_t>(&entry.send_message);
+    sqe->len = 1;
+    sqe->msg_flags = flags;
+    sqe->user_data = encode(Operation::Send, id);
+
+    ++entry.pending_operations;
+    ++entry.pending_sends;
+}
+
+void IoUringLoop::submit_file_output(uint64_t id, RingConnection &entry)
+{
+    Connection &connection = *entry.connection;
+
+    if (!entry.pipe_read.is_valid())
+    {
+        int fds[2];
+        if (pipe2(fds, O_CLOEXEC) != 0)
+        {
+            m_server.m_logger.error() << "Failed to create splice pipe: " << strerror(errno);
+            close_connection(id);
+            return;
+        }
+
+        entry.pipe_read.reset(fds[0]);
+        entry.pipe_write.reset(fds[1]);
+
+        // A larger pipe means fewer splice round trips; keep the default if the limit forbids it.
+        fcntl(fds[1], F_SETPIPE_SZ, splice_pipe_size);
+        int pipe_size = fcntl(fds[1], F_GETPIPE_SZ);
+        entry.pipe_size = pipe_size > 0 ? pipe_size : 4096;
+    }
+
+    // Refill the pipe from the file only once it is empty, linked to the
+    // splice that moves its contents on to the socket.
+    size_t length = entry.piped;
+
+    if (entry.piped == 0)
+    {
+        io_uring_sqe *sqe = next_sqe();
+        if (!sqe)
+        {
+            close_connection(id);
+            return;
+        }
+
+        length = std::min(connection.get_pending_file_size(), entry.pipe_size);
+
+        sqe->opcode = IORING_OP_SPLICE;
+        sqe->fd = entry.pipe_write.get();
+        sqe->off = static_cast<uint64_t>(-1);
+        sqe->splice_fd_in = connection.get_body_file()->get_fd();
+        sqe->splice_off_in = connection.get_file_offset();
+        sqe->len = static_cast<uint32_t>(length);
+        sqe->splice_flags = SPLICE_F_MOVE;
+        sqe->flags = IOSQE_IO_LINK;
+        sqe->user_data = encode(Operation::SpliceIn, id);
+
+        ++entry.pending_operations;
+        ++entry.pending_sends;
+    }
+
+    io_uring_sqe *sqe = next_sqe();
+    if (!sqe)
+    {
+        close_connection(id);
+        return;
+    }
+
+    sqe->opcode = IORING_OP_SPLICE;
+    sqe->fd = connection.get_fd();
+    sqe->off = static_cast<uint64_t>(-1);
+    sqe->splice_fd_in = entry.pipe_read.get();
+    sqe->splice_off_in = static_cast<uint64_t>(-1);
+    sqe->len = static_cast<uint32_t>(length);
+    sqe->splice_flags = SPLICE_F_MOVE;
+    sqe->user_data = encode(Operation::SpliceOut, id);
+
+    ++entry.pending_operations;
+    ++entry.pending_sends;
+}
+
+void IoUringLoop::handle_completion(const io_uring_cqe &cqe)
+{
+    auto operation = static_cast<Operation>(cqe.user_data >> 56);
+    uint64_t id = cqe.user_data & ((uint64_t(1) << 56) - 1);
+
+    switch (operation)
+    {
+    case Operation::None:
+        break;
+    case Operation::Accept:
+        on_accept(cqe);
+        break;
+    case Operation::Shed:
+        on_shed(cqe);
+        break;
+    case Operation::Receive:
+        on_receive(id, cqe);
+        update_timer(id);
+        break;
+    case Operation::Send:
+        on_send(id, cqe);
+        update_timer(id);
+        break;
+    case Operation::SpliceIn:
+    case Operation::SpliceOut:
+        on_splice(id, operation, cqe);
+        update_timer(id);
+        break;
+    case Operation::Wake:
+        on_wake(cqe);
+        break;
+    case Operation::Timer:
+        on_timer(cqe);
+        break;
+    case Operation::AsyncPoll:
+    case Operation::AsyncRead:
+        on_operation(id, operation, cqe);
+        break;
+    }
+}
+
+void IoUringLoop::on_accept(const io_uring_cqe &cqe)
+{
+    bool shedding = false;
+
+    if (!(cqe.flags & IORING_CQE_F_MORE) && !m_stopping && !m_draining)
+    {
+        // Out of descriptors the multishot accept ends while the connection
+        // stays queued; re-arming it directly would fail again immediately.
+        shedding = (cqe.res == -EMFILE || cqe.res == -ENFILE) && m_accept_reserve.release();
+        if (shedding)
+            arm_shed();
+        else
+            arm_accept();
+    }
+
+    if (cqe.res < 0)
+    {
+        if (cqe.res != -ECANCELED && !m_stopping && !shedding)
+            m_server.m_logger.error() << "Failed to accept connection: " << strerror(-cqe.res);
+        return;
+    }
+
+    if (m_stopping)
+    {
+        close(cqe.res);
+        return;
+    }
+
+    add_connection(cqe.res);
+}
+
+void IoUringLoop::on_shed(const io_uring_cqe &cqe)
+{
+    // The shed accept waits for a connection, so descriptors may have been
+    // freed by the time it completes; only close it if they are still short.
+    if (cqe.res >= 0 && !m_stopping && m_accept_reserve.restore())
+    {
+        add_connection(cqe.res);
+    }
+    else if (cqe.res >= 0)
+    {
+        close(cqe.res);
+        if (!m_stopping)
+            m_server.log_shed_connection();
+    }
+
+    m_accept_reserve.restore();
+
+    if (!m_stopping && !m_draining)
+        arm_accept();
+}
+
+void IoUringLoop::add_connection(socket_t client_fd)
+{
+    uint64_t id = m_next_id++;
+    RingConnection &entry = m_connections[id];
+    const ServerConfig &config = m_server.get_config();
+    entry.connection = std::make_unique<Connection>(id, SocketWrapper(client_fd), m_buffer_pool,
+                                                    config.max_request_header_size, config.max_request_body_size,
+                                                    config.max_streamed_body_size, config.output_high_water_mark);
+    entry.connection->set_router(&m_server.get_router());
+    m_server.capture_peer(*entry.connection);
+    count_accepted();
+    ++m_accepted_unlogged;
+
+    arm_receive(id, entry);
+    update_timer(id);
+}
+
+void IoUringLoop::on_receive(uint64_t id, const io_uring_cqe &cqe)
+{
+    auto it = m_connections.find(id);
+    if (it == m_connections.end())
+        return;
+
+    RingConnection &entry = it->second;
+    Connection &connection = *entry.connection;
+    bool rearm = !(cqe.flags & IORING_CQE_F_MORE);
+
+    if (rearm)
+    {
+        --entry.pending_operations;
+        entry.receiving = false;
+    }
+
+    if (cqe.flags & IORING_CQE_F_BUFFER)
+    {
+        auto buffer_id = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+
+        if (cqe.res > 0 && !entry.closing)
+        {
+            connection.append_input(m_buffers.get_buffer(buffer_id), cqe.res);
+            connection.touch();
+            count_received(cqe.res);
+        }
+
+        m_buffers.recycle(buffer_id);
+    }
+
+    if (entry.closing)
+    {
+        release_if_idle(id);
+        return;
+    }
+
+    if (cqe.res == 0)
+    {
+        connection.set_peer_closed();
+        rearm = false;
+    }
+    else if (cqe.res < 0 && cqe.res != -ENOBUFS && cqe.res != -ECANCELED)
+    {
+        m_server.m_logger.error() << "Failed to receive request: " << strerror(-cqe.res);
+        close_connection(id);
+        return;
+    }
+
+    if (connection.get_state() == ConnectionState::Reading)
+        process_input(id, entry);
+
+    // Processing may have closed and released the connection.
+    it = m_connections.find(id);
+    if (it == m_connections.end() || it->second.closing)
+        return;
+
+    RingConnection &current = it->second;
+
+    if (current.connection->is_input_full())
+    {
+        m_server.m_logger.error() << "Closing connection that sent more input than it may buffer";
+        close_connection(id);
+        return;
+    }
+
+    // Input is only received while the connection waits for a request;
+    // finish_response arms the receive again.
+    if (current.connection->get_state() != ConnectionState::Reading)
+    {
+        if (current.receiving && !current.receive_cancelled)
+        {
+            cancel(Operation::Receive, id);
+            current.receive_cancelled = true;
+        }
+        return;
+    }
+
+    if (rearm && !current.connection->is_peer_closed())
+        arm_receive(id, current);
+}
+
+void IoUringLoop::on_send(uint64_t id, const io_uring_cqe &cqe)
+{
+    auto it = m_connections.find(id);
+    if (it == m_connections.end())
+        return;
+
+    RingConnection &entry = it->second;
+    Connection &connection = *entry.connection;
+
+    --entry.pending_operations;
+    --entry.pending_sends;
+
+    if (cqe.res > 0 && !entry.closing)
+    {
+        connection.consume_output(cqe.res);
+        count_sent(cqe.res);
+    }
+
+    if (entry.closing)
+    {
+        release_if_idle(id);
+        return;
+    }
+
+    if (cqe.res < 0 && cqe.res != -ECANCELED)
+    {
+        m_server.m_logger.error() << "Failed to send response: " << strerror(-cqe.res);
+        close_connection(id);
+        return;
+    }
+
+    if (entry.pending_sends > 0)
+        return;
+
+    continue_output(id, entry);
+}
+
+void IoUringLoop::on_splice(uint64_t id, Operation operation, const io_uring_cqe &cqe)
+{
+    auto it = m_connections.find(id);
+    if (it == m_connections.end())
+        return;
+
+    RingConnection &entry = it->second;
+    Connection &connection = *entry.connection;
+
+    --entry.pending_operations;
+    --entry.pending_sends;
+
+    if (cqe.res > 0 && !entry.closing)
+    {
+        if (operation == Operation::SpliceIn)
+        {
+            entry.piped += cqe.res;
+        }
+        else
+        {
+            entry.piped -= cqe.res;
+            connection.consume_file_output(cqe.res);
+            count_sent(cqe.res);
+        }
+    }
+
+    if (entry.closing)
+    {
+        release_if_idle(id);
+        return;
+    }
+
+    // A short refill cancels the linked splice to the socket; what did reach
+    // the pipe is sent on the next round.
+    if (cqe.res < 0 && cqe.res != -ECANCELED)
+    {
+        m_server.m_logger.error() << "Failed to send response file: " << strerror(-cqe.res);
+        close_connection(id);
+        return;
+    }
+
+    if (cqe.res == 0 && operation == Operation::SpliceIn)
+    {
+        m_server.m_logger.error() << "Failed to send response file: file is shorter than its size";
+        close_connection(id);
+        return;
+    }
+
+    if (entry.pending_sends > 0)
+        return;
+
+    continue_output(id, entry);
+}
+
+void IoUringLoop::on_wake(const io_uring_cqe &)
+{
+    if (!m_stopping)
+        arm_wake();
+
+    std::vector<Task> pending;
+    {
+        std::lock_guard<std::mutex> lock(m_pending_mutex);
+        pending.swap(m_pending);
+    }
+
+    for (auto &callback : pending)
+        callback();
+}
+
+void IoUringLoop::on_timer(const io_uring_cqe &cqe)
+{
+    uint64_t generation = cqe.user_data & ((uint64_t(1) << 56) - 1);
+
+    if (generation == m_timer_generation)
+        m_timer_pending = false;
+}
+
+void IoUringLoop::process_input(uint64_t id, RingConnection &entry)
+{
+    Connection &connection = *entry.connection;
+    std::vector<HttpRequest> requests;
+
+    try
+    {
+        if (connection.extract_requests(requests) > 0)
+        {
+            dispatch(id, entry, std::move(requests));
+            return;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        m_server.m_logger.error() << "Failed to parse HTTP request: " << e.what();
+        HttpResponse response = make_bad_request_response();
+        m_server.finalize_response(response, false);
+        connection.set_keep_alive(false);
+        connection.queue_response(std::move(response));
+        connection.set_state(ConnectionState::Writing);
+        submit_output(id, entry);
+        return;
+    }
+
+    if (connection.is_peer_closed())
+    {
+        m_server.m_logger.debug() << "Client disconnected";
+        close_connection(id);
+    }
+}
+
+void IoUringLoop::dispatch(uint64_t id, RingConnection &entry, std::vector<HttpRequest> requests)
+{
+    Connection &connection = *entry.connection;
+    connection.set_state(ConnectionState::Processing);
+
+    size_t requests_served = connection.get_requests_served();
+    RequestOrigin origin{connection.get_peer(), std::chrono::steady_clock::now()};
+    connection.count_requests(requests.size());
+
+    std::optional<ExecutionPolicy> policy = m_server.get_batch_policy(requests, m_inline_handlers);
+    if (!policy)
+    {
+        dispatch_async(id, std::move(requests), origin, requests_served);
+        return;
+    }
+
+    if (*policy == ExecutionPolicy::Inline)
+    {
+        std::vector<HttpResponse> responses;
+        bool keep_alive = m_server.process_requests(requests, origin, requests_served, true, responses);
+        complete(id, responses, keep_alive);
+        return;
+    }
+
+    m_server.enqueue_task([this, id, origin, requests_served, requests = std::move(requests)]()
+                          {
+                              std::vector<HttpResponse> responses;
+                              bool keep_alive = m_server.process_requests(requests, origin, requests_served, true, responses);
+                              post([this, id, keep_alive, responses = std::move(responses)]() mutable
+                                   { complete(id, responses, keep_alive); }); },
+                          [this, id]()
+                          {
+                              std::vector<HttpResponse> responses = {m_server.get_overload_response()};
+                              post([this, id, responses = std::move(responses)]() mutable
+                                   { complete(id, responses, false); }); },
+                          *policy);
+}
+
+void IoUringLoop::dispatch_async(uint64_t id, std::vector<HttpRequest> requests, RequestOrigin origin,
+                                 size_t requests_served)
+{
+    AsyncBatch &batch = m_async_batches[id];
+
+    batch.coroutine = m_server.process_requests_async(std::move(requests), origin, requests_served, m_inline_handlers,
+                                                      batch.responses);
+    batch.coroutine.start([this, id]
+                          { complete_async(id); });
+}
+
+// Runs when a batch's coroutine returns, from within its final suspension.
+void IoUringLoop::complete_async(uint64_t id)
+{
+    auto it = m_async_batches.find(id);
+    if (it == m_async_batches.end())
+        return;
+
+    AsyncBatch batch = std::move(it->second);
+    m_async_batches.erase(it);
+
+    bool keep_alive = false;
+    try
+    {
+        keep_alive = batch.coroutine.get_result();
+    }
+    catch (const std::exception &e)
+    {
+        m_server.m_logger.error() << "Failed to process requests: " << e.what();
+    }
+
+    complete(id, batch.responses, keep_alive);
+}
+
+void IoUringLoop::start_operation(AsyncOperation &operation)
+{
+    uint64_t id = m_next_id++;
+    PendingOperation &pending = m_operations.try_emplace(id, &operation, id).first->second;
+
+    if (operation.kind != AsyncOperation::Kind::Sleep)
+    {
+        io_uring_sqe *sqe = next_sqe();
+        if (!sqe)
+        {
+            post([this, id]
+                 { finish_operation(id, -EBUSY); });
+            return;
+        }
+
+        sqe->fd = operation.fd;
+
+        if (operation.kind == AsyncOperation::Kind::Poll)
+        {
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->poll32_events = static_cast<uint16_t>(operation.events);
+            sqe->user_data = encode(Operation::AsyncPoll, id);
+        }
+        else
+        {
+            sqe->opcode = IORING_OP_READ;
+            sqe->addr = reinterpret_cast<uint64_t>(operation.buffer);
+            sqe->len = static_cast<uint32_t>(operation.length);
+            sqe->off = operation.offset;
+            sqe->user_data = encode(Operation::AsyncRead, id);
+            ++m_reads_in_flight;
+            return;
+        }
+    }
+
+    if (operation.deadline != AsyncOperation::clock::time_point::max())
+        m_timers.schedule(pending.timer, operation.deadline);
+}
+
+void IoUringLoop::on_operation(uint64_t id, Operation operation, const io_uring_cqe &cqe)
+{
+    if (operation == Operation::AsyncRead)
+        --m_reads_in_flight;
+
+    finish_operation(id, cqe.res);
+}
+
+void IoUringLoop::finish_operation(uint64_t id, int64_t result)
+{
+    auto it = m_operations.find(id);
+    if (it == m_operations.end())
+        return;
+
+    AsyncOperation &operation = *it->second.operation;
+    m_operations.erase(it);
+
+    operation.result = result;
+    operation.handle.resume();
+}
+
+void IoUringLoop::complete(uint64_t id, std::vector<HttpResponse> &responses, bool keep_alive)
+{
+    auto it = m_connections.find(id);
+    if (it == m_connections.end() || it->second.closing)
+        return;
+
+    RingConnection &entry = it->second;
+    entry.connection->set_keep_alive(keep_alive);
+
+    for (auto &response : responses)
+        entry.connection->queue_response(std::move(response));
+
+    count_requests(responses.size());
+    entry.connection->set_state(ConnectionState::Writing);
+    submit_output(id, entry);
+    update_timer(id);
+}
+
+void IoUringLoop::continue_output(uint64_t id, RingConnection &entry)
+{
+    Connection &connection = *entry.connection;
+    size_t high_water_mark = m_server.get_config().output_high_water_mark;
+    std::shared_ptr<ResponseStream> stream = connection.get_body_stream();
+
+    // A streamed body is produced ahead of the socket, while earlier output is
+    // still being sent, until the pending output reaches the high-water mark.
+    while (stream && !connection.is_producing_body() && connection.get_pending_output_size() < high_water_mark)
+    {
+        if (!m_inline_handlers)
+        {
+            produce_body(id, entry, std::move(stream));
+            break;
+        }
+
+        std::string output;
+        if (!m_server.produce_body(*stream, output))
+        {
+            close_connection(id);
+            return;
+        }
+
+        connection.queue_body_output(std::move(output));
+        stream = connection.get_body_stream();
+    }
+
+    // Output queued behind in-flight sends goes out when they complete.
+    if (entry.pending_sends > 0)
+        return;
+
+    if (connection.has_pending_output() || connection.has_pending_file_output())
+        m_server.set_corked(connection, true);
+
+    if (connection.has_pending_output())
+        submit_output(id, entry);
+    else if (connection.has_pending_file_output())
+        submit_file_output(id, entry);
+    else if (!connection.get_body_stream())
+        finish_response(id, entry);
+}
+
+void IoUringLoop::produce_body(uint64_t id, RingConnection &entry, std::shared_ptr<ResponseStream> stream)
+{
+    entry.connection->set_producing_body(true);
+
+    m_server.enqueue_task([this, id, stream = std::move(stream)]()
+                          {
+                              std::string output;
+                              bool produced = m_server.produce_body(*stream, output);
+                              post([this, id, produced, output = std::move(output)]() mutable
+                                   { write_body(id, std::move(output), produced); }); });
+}
+
+void IoUringLoop::write_body(uint64_t id, std::string output, bool produced)
+{
+    auto it = m_connections.find(id);
+    if (it == m_connections.end() || it->second.closing)
+        return;
+
+    if (!produced)
+    {
+        close_connection(id);
+        return;
+    }
+
+    RingConnection &entry = it->second;
+    entry.connection->set_producing_body(false);
+    entry.connection->queue_body_output(std::move(output));
+    continue_output(id, entry);
+    update_timer(id);
+}
+
+void IoUringLoop::finish_response(uint64_t id, RingConnection &entry)
+{
+    Connection &connection = *entry.connection;
+    m_server.set_corked(connection, false);
+
+    if (!connection.is_keep_alive() || connection.is_peer_closed() || m_stopping)
+    {
+        close_connection(id);
+        return;
+    }
+
+    connection.set_state(ConnectionState::Reading);
+    connection.touch();
+
+    // Pipelined requests already received are still answered while draining.
+    if (m_draining && connection.is_idle_keep_alive())
+    {
+        close_connection(id);
+        return;
+    }
+
+    process_input(id, entry);
+
+    // Processing may have closed and released the connection.
+    auto it = m_connections.find(id);
+    if (it == m_connections.end() || it->second.closing)
+        return;
+
+    if (it->second.connection->get_state() == ConnectionState::Reading && !it->second.receiving)
+        arm_receive(id, it->second);
+}
+
+void IoUringLoop::close_connection(uint64_t id)
+{
+    auto it = m_connections.find(id);
+    if (it == m_connections.end())
+        return;
+
+    RingConnection &entry = it->second;
+
+    if (!entry.closing)
+    {
+        entry.closing = true;
+        entry.connection->get_timer().cancel();
+        entry.connection->set_state(ConnectionState::Closed);
+        shutdown(entry.connection->get_fd(), SHUT_RDWR);
+    }
+
+    release_if_idle(id);
+}
+
+// Called after every completion on a connection, so the timer always tracks
+// the deadline of the phase the connection is in.
+void IoUringLoop::update_timer(uint64_t id)
+{
+    auto it = m_connections.find(id);
+    if (it == m_connections.end() || it->second.closing)
+        return;
+
+    Connection &connection = *it->second.connection;
+    m_timers.schedule(connection.get_timer(), m_server.get_deadline(connection));
+}
+
+void IoUringLoop::expire_timer(uint64_t id)
+{
+    // A poll that timed out is removed; its completion then finds nothing.
+    auto operation = m_operations.find(id);
+    if (operation != m_operations.end())
+    {
+        io_uring_sqe *sqe = operation->second.operation->kind == AsyncOperation::Kind::Poll ? next_sqe() : nullptr;
+        if (sqe)
+        {
+            sqe->opcode = IORING_OP_POLL_REMOVE;
+            sqe->fd = -1;
+            sqe->addr = encode(Operation::AsyncPoll, id);
+            sqe->user_data = encode(Operation::None, 0);
+        }
+
+        finish_operation(id, 0);
+        return;
+    }
+
+    auto it = m_connections.find(id);
+    if (it == m_connections.end() || it->second.closing)
+        return;
+
+    RingConnection &entry = it->second;
+
+    // A request still arriving is answered with 408 before closing.
+    if (!m_server.queue_timeout_response(*entry.connection))
+    {
+        close_connection(id);
+        return;
+    }
+
+    continue_output(id, entry);
+    update_timer(id);
+}
+
+// Runs on the loop's thread. Accepts are cancelled rather than the listener
+// shut down, since a successor may be accepting on it.
+void IoUringLoop::begin_drain()
+{
+    if (m_draining)
+        return;
+
+    m_draining = true;
+    cancel(Operation::Accept);
+    cancel(Operation::Shed);
+
+    std::vector<uint64_t> idle;
+    for (const auto &[id, entry] : m_connections)
+    {
+        if (!entry.closing && entry.connection->is_idle_keep_alive())
+            idle.push_back(id);
+    }
+
+    for (uint64_t id : idle)
+        close_connection(id);
+
+    if (m_connections.empty())
+        m_stopping = true;
+}
+
+void IoUringLoop::cancel(Operation operation, uint64_t id)
+{
+    io_uring_sqe *sqe = next_sqe();
+    if (!sqe)
+        return;
+
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = encode(operation, id);
+    sqe->user_data = encode(Operation::None, 0);
+}
+
+void IoUringLoop::release_if_idle(uint64_t id)
+{
+    auto it = m_connections.find(id);
+    if (it != m_connections.end() && it->second.pending_operations == 0)
+        m_connections.erase(it);
+
+    if (m_draining && m_connections.empty())
+        m_stopping = true;
+}
+
+#endif // HAS_IO_URING
@@ -0,0 +1,181 @@
+#ifndef IO_URING_LOOP_HPP
+#define IO_URING_LOOP_HPP
+
+#include "io_uring.hpp"
+
+#ifdef HAS_IO_URING
+
+#include "http/httprequest.hpp"
+#include "http/httpresponse.hpp"
+#include "accept_reserve.hpp"
+#include "async.hpp"
+#include "async_io.hpp"
+#include "buffer_pool.hpp"
+#include "connection.hpp"
+#include "io_loop.hpp"
+#include "socket_wrapper.hpp"
+#include "timer_wheel.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+class HttpServer;
+
+class IoUringLoop : public IoLoop
+{
+private:
+    enum class Operation : uint8_t
+    {
+        None,
+        Accept,
+        Shed,
+        Receive,
+        Send,
+        SpliceIn,
+        SpliceOut,
+        Wake,
+        Timer,
+        AsyncPoll,
+        AsyncRead,
+    };
+
+    // An operation awaited by a coroutine on this loop; the timer carries its deadline.
+    struct PendingOperation
+    {
+        AsyncOperation *operation;
+        TimerWheel::Timer timer;
+
+        PendingOperation(AsyncOperation *o, uint64_t id)
+            : operation(o), timer(id) {}
+    };
+
+    // Requests with async routes, answered by a coroutine on this thread.
+    struct AsyncBatch
+    {
+        std::vector<HttpResponse> responses;
+        Async<bool> coroutine;
+    };
+
+    struct RingConnection
+    {
+        std::unique_ptr<Connection> connection;
+        unsigned pending_operations = 0;
+        unsigned pending_sends = 0;
+        bool closing = false;
+        // A multishot receive is armed; it is cancelled while a request is
+        // processed, so later input stays in the socket.
+        bool receiving = false;
+        bool receive_cancelled = false;
+
+        std::array<iovec, Connection::max_output_vectors> send_vectors;
+        msghdr send_message{};
+
+        // File bodies are spliced through this pipe; piped counts the bytes
+        // in it that have not reached the socket yet.
+        SocketWrapper pipe_read;
+        SocketWrapper pipe_write;
+        size_t pipe_size = 0;
+        size_t piped = 0;
+    };
+
+    static constexpr unsigned ring_entries = 1024;
+    static constexpr unsigned buffer_count = 512;
+    static constexpr size_t buffer_size = 4096;
+    static constexpr int splice_pipe_size = 256 * 1024;
+    static constexpr uint16_t buffer_group_id = 0;
+    static constexpr std::chrono::milliseconds timer_tick{10};
+
+    HttpServer &m_server;
+    socket_t m_listen_fd;
+    bool m_inline_handlers;
+    IoUring m_ring;
+    ProvidedBuffers m_buffers;
+    SocketWrapper m_wake_fd;
+    uint64_t m_wake_value;
+    uint64_t m_next_id;
+    AcceptReserve m_accept_reserve;
+    size_t m_accepted_unlogged = 0;
+
+    // One IORING_OP_TIMEOUT is kept armed for the wheel's earliest deadline;
+    // the generation tells a current expiry from one that was replaced.
+    TimerWheel m_timers;
+    __kernel_timespec m_timer_timeout{};
+    std::chrono::steady_clock::time_point m_timer_deadline;
+    uint64_t m_timer_generation = 0;
+    bool m_timer_pending = false;
+    BufferPool m_buffer_pool;
+    std::unordered_map<uint64_t, RingConnection> m_connections;
+    std::unordered_map<uint64_t, PendingOperation> m_operations;
+    std::unordered_map<uint64_t, AsyncBatch> m_async_batches;
+    // Reads the kernel may still be writing into a coroutine frame.
+    size_t m_reads_in_flight = 0;
+
+    std::mutex m_pending_mutex;
+    std::vector<Task> m_pending;
+    std::atomic<bool> m_stopping{false};
+    bool m_draining = false;
+
+    static uint64_t encode(Operation operation, uint64_t id);
+
+    io_uring_sqe *next_sqe();
+    void arm_accept();
+    void arm_shed();
+    void arm_wake();
+    void arm_timer();
+    void arm_receive(uint64_t id, RingConnection &entry);
+    void submit_output(uint64_t id, RingConnection &entry);
+    void submit_file_output(uint64_t id, RingConnection &entry);
+
+    void handle_completion(const io_uring_cqe &cqe);
+    void on_accept(const io_uring_cqe &cqe);
+    void on_shed(const io_uring_cqe &cqe);
+    void add_connection(socket_t client_fd);
+    void on_receive(uint64_t id, const io_uring_cqe &cqe);
+    void on_send(uint64_t id, const io_uring_cqe &cqe);
+    void on_splice(uint64_t id, Operation operation, const io_uring_cqe &cqe);
+    void on_wake(const io_uring_cqe &cqe);
+    void on_timer(const io_uring_cqe &cqe);
+
+    void process_input(uint64_t id, RingConnection &entry);
+    void dispatch(uint64_t id, RingConnection &entry, std::vector<HttpRequest> requests);
+    void dispatch_async(uint64_t id, std::vector<HttpRequest> requests, RequestOrigin origin, size_t requests_served);
+    void complete(uint64_t id, std::vector<HttpResponse> &responses, bool keep_alive);
+    void complete_async(uint64_t id);
+    void on_operation(uint64_t id, Operation operation, const io_uring_cqe &cqe);
+    void finish_operation(uint64_t id, int64_t result);
+    void continue_output(uint64_t id, RingConnection &entry);
+    void produce_body(uint64_t id, RingConnection &entry, std::shared_ptr<ResponseStream> stream);
+    void write_body(uint64_t id, std::string output, bool produced);
+    void finish_response(uint64_t id, RingConnection &entry);
+    void close_connection(uint64_t id);
+    void update_timer(uint64_t id);
+    void expire_timer(uint64_t id);
+    void begin_drain();
+    void cancel(Operation operation, uint64_t id = 0);
+    void release_if_idle(uint64_t id);
+
+public:
+    IoUringLoop(HttpServer &server, socket_t listen_fd, bool use_buffer_ring, bool inline_handlers = false);
+
+    IoUringLoop(const IoUringLoop &) = delete;
+    IoUringLoop &operator=(const IoUringLoop &) = delete;
+
+    ~IoUringLoop() override = default;
+
+    void run() override;
+    void stop() override;
+    void drain() override;
+    void post(Task callback) override;
+    void start_operation(AsyncOperation &operation) override;
+};
+
+#endif // HAS_IO_URING
+
+#endif // IO_URING_LOOP_HPP
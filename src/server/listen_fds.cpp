@@ -0,0 +1,141 @@
+#include "server/listen_fds.hpp"
+
+#ifndef _WIN32
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+static const char *const listen_variables[] = {"LISTEN_PID=", "LISTEN_FDS=", "LISTEN_FDNAMES="};
+
+std::vector<SocketWrapper> take_listen_fds()
+{
+    std::vector<SocketWrapper> sockets;
+    const char *pid = getenv("LISTEN_PID");
+    const char *count = getenv("LISTEN_FDS");
+
+    if (pid && count && strtoll(pid, nullptr, 10) == getpid())
+    {
+        long long last = listen_fds_start + strtoll(count, nullptr, 10);
+
+        for (int fd = listen_fds_start; fd < last; ++fd)
+        {
+            struct stat status{};
+            if (fstat(fd, &status) != 0 || !S_ISSOCK(status.st_mode))
+                continue;
+
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+            sockets.emplace_back(fd);
+        }
+    }
+
+    unsetenv("LISTEN_PID");
+    unsetenv("LISTEN_FDS");
+    unsetenv("LISTEN_FDNAMES");
+    return sockets;
+}
+
+pid_t spawn_with_listen_fds(const std::string &path, char *const argv[], const std::vector<socket_t> &listeners)
+{
+    int first_free = listen_fds_start + static_cast<int>(listeners.size());
+
+    // Copies above the target range, so moving them into place in the child
+    // cannot overwrite one that has not been moved yet.
+    std::vector<SocketWrapper> copies;
+    for (socket_t listener : listeners)
+    {
+        copies.emplace_back(fcntl(listener, F_DUPFD_CLOEXEC, first_free));
+        if (!copies.back().is_valid())
+            return -1;
+    }
+
+    // The child reports a failed exec through this pipe; a successful exec closes it.
+    int status_pipe[2];
+    if (pipe2(status_pipe, O_CLOEXEC) != 0)
+        return -1;
+
+    SocketWrapper status_read(status_pipe[0]);
+    SocketWrapper status_write(fcntl(status_pipe[1], F_DUPFD_CLOEXEC, first_free));
+    close(status_pipe[1]);
+
+    if (!status_write.is_valid())
+        return -1;
+
+    // Everything the child needs is prepared here; between fork and exec it may
+    // only make async-signal-safe calls.
+    std::vector<char *> environment;
+    for (char **variable = environ; *variable; ++variable)
+    {
+        bool inherited = true;
+        for (const char *prefix : listen_variables)
+            inherited = inherited && strncmp(*variable, prefix, strlen(prefix)) != 0;
+
+        if (inherited)
+            environment.push_back(*variable);
+    }
+
+    std::string fds_variable = "LISTEN_FDS=" + std::to_string(listeners.size());
+    char pid_variable[32] = "LISTEN_PID=";
+    environment.push_back(fds_variable.data());
+    environment.push_back(pid_variable);
+    environment.push_back(nullptr);
+
+    sigset_t no_signals;
+    sigemptyset(&no_signals);
+
+    pid_t pid = fork();
+    if (pid < 0)
+        return -1;
+
+    if (pid == 0)
+    {
+        char digits[16];
+        size_t length = 0;
+        for (pid_t value = getpid(); value > 0; value /= 10)
+            digits[length++] = static_cast<char>('0' + value % 10);
+
+        char *end = pid_variable + strlen("LISTEN_PID=");
+        while (length > 0)
+            *end++ = digits[--length];
+        *end = '\0';
+
+        // dup2 clears close-on-exec on the target, so only the listeners survive exec.
+        for (size_t i = 0; i < copies.size(); ++i)
+            dup2(copies[i].get(), listen_fds_start + static_cast<int>(i));
+
+        // The parent may block signals for a signal thread; the successor starts with none blocked.
+        sigprocmask(SIG_SETMASK, &no_signals, nullptr);
+
+        execve(path.c_str(), argv, environment.data());
+
+        int error = errno;
+        [[maybe_unused]] ssize_t written = write(status_write.get(), &error, sizeof(error));
+        _exit(127);
+    }
+
+    status_write.reset();
+
+    int error = 0;
+    ssize_t bytes_read;
+    while ((bytes_read = read(status_read.get(), &error, sizeof(error))) < 0 && errno == EINTR)
+    {
+    }
+
+    if (bytes_read == sizeof(error))
+    {
+        waitpid(pid, nullptr, 0);
+        errno = error;
+        return -1;
+    }
+
+    return pid;
+}
+
+#endif
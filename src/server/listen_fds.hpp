@@ -0,0 +1,27 @@
+#ifndef LISTEN_FDS_HPP
+#define LISTEN_FDS_HPP
+
+#ifndef _WIN32
+
+#include "socket_wrapper.hpp"
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+// Listening sockets passed between processes the way systemd socket activation
+// does: the process finds LISTEN_FDS sockets from descriptor 3 on, provided
+// LISTEN_PID names it. A server restarting in place hands its listeners to its
+// successor this way, so connections keep queueing while the old one drains.
+constexpr int listen_fds_start = 3;
+
+// Takes the sockets passed to this process and unsets the variables, so they
+// are not passed on again; empty when none were passed.
+std::vector<SocketWrapper> take_listen_fds();
+
+// Starts path with argv and the listeners as descriptors 3 onwards. Returns the
+// child's pid once it has exec'd, or -1 with errno set if it could not start.
+pid_t spawn_with_listen_fds(const std::string &path, char *const argv[], const std::vector<socket_t> &listeners);
+
+#endif
+
+#endif // LISTEN_FDS_HPP
@@ -0,0 +1,323 @@
+#include "server/logger.hpp"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+
+static std::atomic<uint64_t> next_logger_id{1};
+
+Logger::Line::Line(Ring *ring, Slot *slot, uint64_t suppressed)
+    : m_ring(ring), m_slot(slot), m_suppressed(suppressed)
+{
+    m_ring->writing = true;
+}
+
+Logger::Line::Line(Line &&other) noexcept
+    : m_ring(other.m_ring), m_slot(std::exchange(other.m_slot, nullptr)),
+      m_length(other.m_length), m_suppressed(other.m_suppressed)
+{
+}
+
+Logger::Line::~Line()
+{
+    if (!m_slot)
+        return;
+
+    if (m_suppressed > 0)
+        *this << " (" << m_suppressed << " similar lines suppressed)";
+
+    m_slot->length = static_cast<uint16_t>(m_length);
+    m_ring->writing = false;
+    m_ring->tail.store(m_ring->tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void Logger::Line::append(const char *text, size_t length)
+{
+    size_t room = line_size - m_length;
+    if (length <= room)
+    {
+        std::memcpy(m_slot->text + m_length, text, length);
+        m_length += length;
+        return;
+    }
+
+    // Marks the cut, unless the line was cut already.
+    if (room == 0)
+        return;
+    std::memcpy(m_slot->text + m_length, text, room);
+    std::memcpy(m_slot->text + line_size - 3, "...", 3);
+    m_length = line_size;
+}
+
+Logger::Logger(const LogPolicy &policy, FILE *output, FILE *errors)
+    : m_id(next_logger_id.fetch_add(1, std::memory_order_relaxed)),
+      m_policy(policy), m_level(policy.level), m_ring_lines(policy.ring_lines),
+      m_repeat(make_repeat_policy(policy)), m_output(output), m_errors(errors)
+{
+    m_writer = std::thread([this]
+                           { run_writer(); });
+}
+
+Logger::~Logger()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_writer_mutex);
+        m_stopping = true;
+    }
+    m_writer_condition.notify_one();
+    m_writer.join();
+
+    flush();
+}
+
+void Logger::configure(const LogPolicy &policy)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_writer_mutex);
+        m_policy = policy;
+    }
+    m_level.store(policy.level, std::memory_order_relaxed);
+    m_ring_lines.store(policy.ring_lines, std::memory_order_relaxed);
+    m_repeat.store(make_repeat_policy(policy), std::memory_order_relaxed);
+    m_writer_condition.notify_one();
+}
+
+Logger::RepeatPolicy Logger::make_repeat_policy(const LogPolicy &policy)
+{
+    constexpr uint64_t limit = std::numeric_limits<uint32_t>::max();
+    return RepeatPolicy{static_cast<uint32_t>(std::min<uint64_t>(policy.repeat_burst, limit)),
+                        static_cast<uint32_t>(std::clamp<int64_t>(policy.repeat_interval.count(), 0, limit))};
+}
+
+Logger::Line Logger::debug(const std::source_location &site)
+{
+    return make_line(LogLevel::Debug, site);
+}
+
+Logger::Line Logger::info(const std::source_location &site)
+{
+    return make_line(LogLevel::Info, site);
+}
+
+Logger::Line Logger::warning(const std::source_location &site)
+{
+    return make_line(LogLevel::Warning, site);
+}
+
+Logger::Line Logger::error(const std::source_location &site)
+{
+    return make_line(LogLevel::Error, site);
+}
+
+bool Logger::is_enabled(LogLevel level) const
+{
+    return level >= m_level.load(std::memory_order_relaxed) && level != LogLevel::Off;
+}
+
+Logger::Ring *Logger::get_ring()
+{
+    // A thread's rings by logger id; the last one used is looked up first.
+    struct ThreadRings
+    {
+        std::unordered_map<uint64_t, std::shared_ptr<Ring>> rings;
+        uint64_t last_logger = 0;
+        Ring *last_ring = nullptr;
+
+        ~ThreadRings()
+        {
+            for (auto &[logger, ring] : rings)
+                ring->retired.store(true, std::memory_order_release);
+        }
+    };
+    static thread_local ThreadRings thread_rings;
+
+    if (thread_rings.last_logger == m_id)
+        return thread_rings.last_ring;
+
+    auto found = thread_rings.rings.find(m_id);
+    if (found == thread_rings.rings.end())
+    {
+        // Rings of loggers that were destroyed are only held here now.
+        std::erase_if(thread_rings.rings, [](const auto &entry)
+                      { return entry.second.use_count() == 1; });
+
+        auto ring = std::make_shared<Ring>(std::max<size_t>(1, m_ring_lines.load(std::memory_order_relaxed)));
+        {
+            std::lock_guard<std::mutex> lock(m_rings_mutex);
+            m_rings.push_back(ring);
+        }
+        found = thread_rings.rings.emplace(m_id, std::move(ring)).first;
+    }
+
+    thread_rings.last_logger = m_id;
+    thread_rings.last_ring = found->second.get();
+    return thread_rings.last_ring;
+}
+
+Logger::Line Logger::make_line(LogLevel level, const std::source_location &site)
+{
+    if (!is_enabled(level))
+        return Line();
+
+    Ring *ring = get_ring();
+
+    // A line logged while this thread is still filling another one.
+    if (ring->writing)
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return Line();
+    }
+
+    uint64_t suppressed = 0;
+    if (level >= LogLevel::Warning && is_repeated(*ring, site, suppressed))
+    {
+        m_suppressed.fetch_add(1, std::memory_order_relaxed);
+        return Line();
+    }
+
+    uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+    if (tail - ring->head.load(std::memory_order_acquire) >= ring->capacity)
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return Line();
+    }
+
+    Slot &slot = ring->slots[tail % ring->capacity];
+    slot.level = level;
+    return Line(ring, &slot, suppressed);
+}
+
+bool Logger::is_repeated(Ring &ring, const std::source_location &site, uint64_t &suppressed)
+{
+    RepeatPolicy policy = m_repeat.load(std::memory_order_relaxed);
+    if (policy.burst == 0)
+        return false;
+
+    size_t hash = reinterpret_cast<uintptr_t>(site.file_name()) ^ (site.line() * 2654435761u);
+    RepeatSite &entry = ring.sites[hash % ring.sites.size()];
+    clock::time_point now = clock::now();
+
+    if (entry.file != site.file_name() || entry.line != site.line())
+    {
+        entry = RepeatSite{site.file_name(), site.line(), now, 0, 0};
+    }
+    else if (now - entry.window_start >= std::chrono::milliseconds(policy.interval_ms))
+    {
+        suppressed = entry.suppressed;
+        entry.window_start = now;
+        entry.count = 0;
+        entry.suppressed = 0;
+    }
+
+    if (entry.count >= policy.burst)
+    {
+        ++entry.suppressed;
+        return true;
+    }
+
+    ++entry.count;
+    return false;
+}
+
+size_t Logger::drain()
+{
+    std::vector<Ring *> rings;
+    {
+        std::lock_guard<std::mutex> lock(m_rings_mutex);
+        rings.reserve(m_rings.size());
+        for (const auto &ring : m_rings)
+            rings.push_back(ring.get());
+    }
+
+    size_t lines = 0;
+    bool any_retired = false;
+    for (Ring *ring : rings)
+    {
+        // Read ahead of the tail, so a retired ring's last lines are seen.
+        bool retired = ring->retired.load(std::memory_order_acquire);
+        uint64_t head = ring->head.load(std::memory_order_relaxed);
+        uint64_t tail = ring->tail.load(std::memory_order_acquire);
+        lines += tail - head;
+
+        for (; head != tail; ++head)
+        {
+            const Slot &slot = ring->slots[head % ring->capacity];
+            std::string &batch = slot.level >= LogLevel::Warning ? m_error_batch : m_output_batch;
+            batch.append(slot.text, slot.length);
+            batch += '\n';
+        }
+
+        ring->head.store(head, std::memory_order_release);
+        any_retired |= retired;
+    }
+
+    if (any_retired)
+    {
+        std::lock_guard<std::mutex> lock(m_rings_mutex);
+        std::erase_if(m_rings, [](const std::shared_ptr<Ring> &ring)
+                      { return ring->retired.load(std::memory_order_acquire) &&
+                               ring->head.load(std::memory_order_relaxed) == ring->tail.load(std::memory_order_acquire); });
+    }
+
+    uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+    if (dropped != m_reported_drops)
+    {
+        m_error_batch += "Dropped " + std::to_string(dropped - m_reported_drops) + " log line(s)\n";
+        m_reported_drops = dropped;
+    }
+
+    for (auto [batch, stream] : {std::pair{&m_output_batch, m_output}, std::pair{&m_error_batch, m_errors}})
+    {
+        if (batch->empty())
+            continue;
+        std::fwrite(batch->data(), 1, batch->size(), stream);
+        std::fflush(stream);
+        batch->clear();
+    }
+
+    return lines;
+}
+
+void Logger::run_writer()
+{
+    std::unique_lock<std::mutex> lock(m_writer_mutex);
+    size_t written = 0;
+
+    // Passes follow each other while they find lines, so a burst is written
+    // as fast as it comes rather than one ring's worth per interval.
+    while (!m_stopping)
+    {
+        if (written == 0)
+            m_writer_condition.wait_for(lock, m_policy.flush_interval);
+
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> drain_lock(m_drain_mutex);
+            written = drain();
+        }
+        lock.lock();
+    }
+}
+
+void Logger::flush()
+{
+    std::lock_guard<std::mutex> lock(m_drain_mutex);
+    drain();
+}
+
+uint64_t Logger::get_dropped_count() const
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+uint64_t Logger::get_suppressed_count() const
+{
+    return m_suppressed.load(std::memory_order_relaxed);
+}
+
+size_t Logger::get_ring_count()
+{
+    std::lock_guard<std::mutex> lock(m_rings_mutex);
+    return m_rings.size();
+}
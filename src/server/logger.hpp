@@ -0,0 +1,195 @@
+#ifndef LOGGER_HPP
+#define LOGGER_HPP
+
+#include "server_config.hpp"
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <source_location>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Log output that never makes a request thread wait. Each thread formats its
+// lines in place in a single-producer ring of its own, and a writer thread
+// empties the rings and writes what it found with one call per stream, pausing
+// for the flush interval once they are empty. Debug and Info lines go to the
+// output stream, warnings and errors to the error stream. Lines of one thread
+// keep their order, lines of different threads may not. A line that finds its
+// ring full is dropped and counted.
+class Logger
+{
+public:
+    // A queued line's text, which is truncated beyond this.
+    static constexpr size_t line_size = 248;
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    struct Slot
+    {
+        LogLevel level;
+        uint16_t length;
+        char text[line_size];
+    };
+
+    // Where a thread last logged a warning or error from, for rate limiting.
+    struct RepeatSite
+    {
+        const char *file = nullptr;
+        uint32_t line = 0;
+        clock::time_point window_start;
+        size_t count = 0;
+        uint64_t suppressed = 0;
+    };
+
+    // Shared by the logger and its producing thread, so either may go first.
+    // The thread retires it on exit; the writer frees it once it is empty.
+    struct Ring
+    {
+        std::unique_ptr<Slot[]> slots;
+        size_t capacity;
+        alignas(64) std::atomic<uint64_t> head{0};
+        alignas(64) std::atomic<uint64_t> tail{0};
+        std::atomic<bool> retired{false};
+        // Producer side only.
+        bool writing = false;
+        std::array<RepeatSite, 32> sites;
+
+        explicit Ring(size_t lines)
+            : slots(std::make_unique<Slot[]>(lines)), capacity(lines) {}
+    };
+
+    // Rate limiting settings, packed to be read in one load while configure()
+    // may replace them.
+    struct RepeatPolicy
+    {
+        uint32_t burst;
+        uint32_t interval_ms;
+    };
+
+public:
+    // Fills a reserved slot through operator<< and queues it when destroyed.
+    // A line that was filtered, rate limited or dropped has no slot and
+    // ignores what it is given.
+    class Line
+    {
+    private:
+        Ring *m_ring = nullptr;
+        Slot *m_slot = nullptr;
+        size_t m_length = 0;
+        uint64_t m_suppressed = 0;
+
+        void append(const char *text, size_t length);
+
+    public:
+        Line() = default;
+        Line(Ring *ring, Slot *slot, uint64_t suppressed);
+
+        Line(Line &&other) noexcept;
+        Line(const Line &) = delete;
+        Line &operator=(const Line &) = delete;
+        Line &operator=(Line &&) = delete;
+
+        ~Line();
+
+        Line &operator<<(std::string_view text)
+        {
+            if (m_slot)
+                append(text.data(), text.size());
+            return *this;
+        }
+
+        Line &operator<<(char c)
+        {
+            if (m_slot)
+                append(&c, 1);
+            return *this;
+        }
+
+        template <typename T>
+            requires(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+        Line &operator<<(T value)
+        {
+            if (m_slot)
+            {
+                char buffer[32];
+                auto [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+                if (error == std::errc())
+                    append(buffer, end - buffer);
+            }
+            return *this;
+        }
+    };
+
+private:
+    const uint64_t m_id;
+    LogPolicy m_policy;
+    std::atomic<LogLevel> m_level;
+    std::atomic<size_t> m_ring_lines;
+    std::atomic<RepeatPolicy> m_repeat;
+    FILE *m_output;
+    FILE *m_errors;
+
+    std::mutex m_rings_mutex;
+    std::vector<std::shared_ptr<Ring>> m_rings;
+
+    std::atomic<uint64_t> m_dropped{0};
+    std::atomic<uint64_t> m_suppressed{0};
+    uint64_t m_reported_drops = 0;
+
+    // Held by whoever empties the rings: the writer thread, or flush().
+    std::mutex m_drain_mutex;
+    std::string m_output_batch;
+    std::string m_error_batch;
+
+    std::mutex m_writer_mutex;
+    std::condition_variable m_writer_condition;
+    bool m_stopping = false;
+    std::thread m_writer;
+
+    static RepeatPolicy make_repeat_policy(const LogPolicy &policy);
+    Ring *get_ring();
+    Line make_line(LogLevel level, const std::source_location &site);
+    bool is_repeated(Ring &ring, const std::source_location &site, uint64_t &suppressed);
+    // Returns the number of lines written.
+    size_t drain();
+    void run_writer();
+
+public:
+    explicit Logger(const LogPolicy &policy = LogPolicy(), FILE *output = stdout, FILE *errors = stderr);
+
+    Logger(const Logger &) = delete;
+    Logger &operator=(const Logger &) = delete;
+
+    // Stops the writer thread once it wrote every queued line.
+    ~Logger();
+
+    // Safe while other threads log. The ring size applies to rings created
+    // afterwards, everything else at once.
+    void configure(const LogPolicy &policy);
+
+    Line debug(const std::source_location &site = std::source_location::current());
+    Line info(const std::source_location &site = std::source_location::current());
+    Line warning(const std::source_location &site = std::source_location::current());
+    Line error(const std::source_location &site = std::source_location::current());
+
+    bool is_enabled(LogLevel level) const;
+    // Writes every line queued before the call.
+    void flush();
+
+    uint64_t get_dropped_count() const;
+    uint64_t get_suppressed_count() const;
+    // Rings of threads that logged, less those of exited threads already written.
+    size_t get_ring_count();
+};
+
+#endif // LOGGER_HPP
@@ -0,0 +1,134 @@
+#ifndef MPMC_QUEUE_HPP
+#define MPMC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// Bounded multi-producer multi-consumer ring after Dmitry Vyukov's design.
+// Each cell carries a sequence number telling whose turn it is: a producer may
+// fill it when the sequence equals its position, a consumer may empty it when
+// the sequence is one past. Both claim a position with a single CAS on their
+// own index, so neither side takes a lock and they do not share a cache line.
+template <typename T>
+class MpmcQueue
+{
+private:
+    static constexpr size_t cache_line = 64;
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    size_t m_mask;
+    alignas(cache_line) std::atomic<size_t> m_enqueue_position;
+    alignas(cache_line) std::atomic<size_t> m_dequeue_position;
+
+    static size_t round_up_capacity(size_t capacity)
+    {
+        size_t rounded = 2;
+        while (rounded < capacity)
+            rounded *= 2;
+        return rounded;
+    }
+
+public:
+    // The capacity is rounded up to a power of two of at least 2.
+    explicit MpmcQueue(size_t capacity)
+        : m_cells(new Cell[round_up_capacity(capacity)]),
+          m_mask(round_up_capacity(capacity) - 1),
+          m_enqueue_position(0),
+          m_dequeue_position(0)
+    {
+        for (size_t i = 0; i <= m_mask; ++i)
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    MpmcQueue(const MpmcQueue &) = delete;
+    MpmcQueue &operator=(const MpmcQueue &) = delete;
+
+    // Moves from value only when there was room.
+    bool try_push(T &value)
+    {
+        size_t position = m_enqueue_position.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            Cell &cell = m_cells[position & m_mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+
+            if (difference == 0)
+            {
+                if (m_enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    cell.value = std::move(value);
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = m_enqueue_position.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool try_pop(T &value)
+    {
+        size_t position = m_dequeue_position.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            Cell &cell = m_cells[position & m_mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+
+            if (difference == 0)
+            {
+                if (m_dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    value = std::move(cell.value);
+                    cell.sequence.store(position + m_mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = m_dequeue_position.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Exact only while no push or pop is in progress.
+    size_t size() const
+    {
+        size_t enqueued = m_enqueue_position.load(std::memory_order_acquire);
+        size_t dequeued = m_dequeue_position.load(std::memory_order_acquire);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    size_t capacity() const
+    {
+        return m_mask + 1;
+    }
+};
+
+#endif // MPMC_QUEUE_HPP
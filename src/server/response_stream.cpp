@@ -0,0 +1,38 @@
+#include "helpers.hpp"
+#include "server/response_stream.hpp"
+#include <cstdlib>
+
+ResponseStream::ResponseStream(BodyStream producer, BodyFraming framing, size_t content_length)
+    : m_producer(std::move(producer)),
+      m_writer(framing, content_length)
+{
+}
+
+BodyFraming ResponseStream::framing_of(const HttpResponse &response, size_t &content_length)
+{
+    content_length = 0;
+
+    if (iequals(response.get_header("Transfer-Encoding"), "chunked"))
+        return BodyFraming::Chunked;
+
+    if (response.has_header("Content-Length"))
+    {
+        content_length = std::strtoull(response.get_header("Content-Length").c_str(), nullptr, 10);
+        return BodyFraming::ContentLength;
+    }
+
+    return BodyFraming::Close;
+}
+
+std::string ResponseStream::produce()
+{
+    if (!m_writer.is_finished() && !m_producer(m_writer))
+        m_writer.finish();
+
+    return m_writer.take_output();
+}
+
+bool ResponseStream::is_finished() const
+{
+    return m_writer.is_finished();
+}
@@ -0,0 +1,31 @@
+#ifndef RESPONSE_STREAM_HPP
+#define RESPONSE_STREAM_HPP
+
+#include "http/bodywriter.hpp"
+#include "http/httpresponse.hpp"
+#include <string>
+
+// Body of a streaming response still being produced. A connection holds it
+// until the producer is done; the next piece is only produced once the
+// previous one has been handed to the socket.
+class ResponseStream
+{
+private:
+    BodyStream m_producer;
+    BodyWriter m_writer;
+
+public:
+    ResponseStream(BodyStream producer, BodyFraming framing, size_t content_length = 0);
+
+    ResponseStream(const ResponseStream &) = delete;
+    ResponseStream &operator=(const ResponseStream &) = delete;
+
+    static BodyFraming framing_of(const HttpResponse &response, size_t &content_length);
+
+    // Runs the producer once and returns the framed bytes it wrote. Throws if
+    // the producer throws or breaks the framing.
+    std::string produce();
+    bool is_finished() const;
+};
+
+#endif // RESPONSE_STREAM_HPP
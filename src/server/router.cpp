@@ -21,29 +21,63 @@ Router::Router()
     };
 }
 
-void Router::get(const std::string &path, RouteHandler handler)
+void Router::get(const std::string &path, RouteHandler handler, ExecutionPolicy policy)
+{
+    add_route(HttpMethod::GET, path, std::move(handler), policy);
+}
+
+void Router::post(const std::string &path, RouteHandler handler, ExecutionPolicy policy)
+{
+    add_route(HttpMethod::POST, path, std::move(handler), policy);
+}
+
+void Router::put(const std::string &path, RouteHandler handler, ExecutionPolicy policy)
+{
+    add_route(HttpMethod::PUT, path, std::move(handler), policy);
+}
+
+void Router::delete_(const std::string &path, RouteHandler handler, ExecutionPolicy policy)
+{
+    add_route(HttpMethod::DELETE, path, std::move(handler), policy);
+}
+
+void Router::get(const std::string &path, AsyncRouteHandler handler)
 {
     add_route(HttpMethod::GET, path, std::move(handler));
 }
 
-void Router::post(const std::string &path, RouteHandler handler)
+void Router::post(const std::string &path, AsyncRouteHandler handler)
 {
     add_route(HttpMethod::POST, path, std::move(handler));
 }
 
-void Router::put(const std::string &path, RouteHandler handler)
+void Router::put(const std::string &path, AsyncRouteHandler handler)
 {
     add_route(HttpMethod::PUT, path, std::move(handler));
 }
 
-void Router::delete_(const std::string &path, RouteHandler handler)
+void Router::delete_(const std::string &path, AsyncRouteHandler handler)
 {
     add_route(HttpMethod::DELETE, path, std::move(handler));
 }
 
-void Router::add_route(HttpMethod method, const std::string &path, RouteHandler handler)
+void Router::add_route(HttpMethod method, const std::string &path, RouteHandler handler, ExecutionPolicy policy)
+{
+    m_routes.emplace_back(method, path, std::move(handler), policy);
+    if (policy != ExecutionPolicy::Worker)
+        ++m_placed_routes;
+}
+
+void Router::add_route(HttpMethod method, const std::string &path, AsyncRouteHandler handler)
 {
     m_routes.emplace_back(method, path, std::move(handler));
+    ++m_async_routes;
+}
+
+void Router::add_streaming_route(HttpMethod method, const std::string &path, BodyHandler body_handler, RouteHandler handler)
+{
+    m_body_routes.emplace_back(method, path, std::move(body_handler));
+    add_route(method, path, std::move(handler));
 }
 
 void Router::set_not_found_handler(RouteHandler handler)
@@ -56,28 +90,31 @@ void Router::set_method_not_allowed_handler(RouteHandler handler)
     m_method_not_allowed_handler = std::move(handler);
 }
 
-HttpResponse Router::handle_request(const HttpRequest &request)
+const Route *Router::find_route(const HttpRequest &request) const
 {
     for (const auto &route : m_routes)
     {
         if (route.method == request.get_method() &&
             std::regex_match(request.get_uri(), route.pattern))
         {
-            try
-            {
-                return route.handler(request);
-            }
-            catch (const std::exception &e)
-            {
-                HttpResponse error_response;
-                error_response.set_code(HttpCode::InternalServerError);
-                error_response.add_header("Content-Type", "text/html");
-                error_response.set_body("<html><body><h1>500 - Internal Server Error</h1></body></html>");
-                return error_response;
-            }
+            return &route;
         }
     }
 
+    return nullptr;
+}
+
+HttpResponse Router::make_error_response()
+{
+    HttpResponse error_response;
+    error_response.set_code(HttpCode::InternalServerError);
+    error_response.add_header("Content-Type", "text/html");
+    error_response.set_body("<html><body><h1>500 - Internal Server Error</h1></body></html>");
+    return error_response;
+}
+
+HttpResponse Router::handle_unrouted(const HttpRequest &request)
+{
     bool path_exists = std::any_of(m_routes.begin(), m_routes.end(),
                                    [&request](const Route &route)
                                    {
@@ -90,4 +127,70 @@ HttpResponse Router::handle_request(const HttpRequest &request)
     }
 
     return m_not_found_handler(request);
+}
+
+HttpResponse Router::handle_request(const HttpRequest &request)
+{
+    const Route *route = find_route(request);
+    if (!route)
+        return handle_unrouted(request);
+
+    try
+    {
+        if (route->async_handler)
+            return sync_wait(route->async_handler(request));
+        return route->handler(request);
+    }
+    catch (const std::exception &e)
+    {
+        return make_error_response();
+    }
+}
+
+Async<HttpResponse> Router::handle_request_async(const HttpRequest &request)
+{
+    const Route *route = find_route(request);
+    if (!route || !route->async_handler)
+        co_return handle_request(request);
+
+    try
+    {
+        co_return co_await route->async_handler(request);
+    }
+    catch (const std::exception &e)
+    {
+        co_return make_error_response();
+    }
+}
+
+bool Router::is_async(const HttpRequest &request) const
+{
+    if (m_async_routes == 0)
+        return false;
+
+    const Route *route = find_route(request);
+    return route && route->async_handler;
+}
+
+ExecutionPolicy Router::get_execution_policy(const HttpRequest &request) const
+{
+    if (m_placed_routes == 0)
+        return ExecutionPolicy::Worker;
+
+    const Route *route = find_route(request);
+    return route && route->handler ? route->policy : ExecutionPolicy::Worker;
+}
+
+BodySink Router::open_body_sink(const HttpRequest &request) const
+{
+    for (const auto &route : m_body_routes)
+    {
+        if (route.method == request.get_method() &&
+            std::regex_match(request.get_uri(), route.pattern))
+        {
+            return route.handler(request);
+        }
+    }
+
+    return nullptr;
 }
\ No newline at end of file
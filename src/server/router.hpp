@@ -4,7 +4,9 @@
 #include "http/httpcode.hpp"
 #include "http/httpmethod.hpp"
 #include "http/httprequest.hpp"
+#include "http/httprequestparser.hpp"
 #include "http/httpresponse.hpp"
+#include "async.hpp"
 #include <map>
 #include <string>
 #include <regex>
@@ -12,13 +14,49 @@
 
 using RouteHandler = std::function<HttpResponse(const HttpRequest &)>;
 
+// A coroutine handler; it starts on the connection's I/O thread, so it must not
+// block, and suspends on the awaitables of async_io.hpp instead. The request
+// outlives the coroutine.
+using AsyncRouteHandler = std::function<Async<HttpResponse>(const HttpRequest &)>;
+
+// Called on the connection's I/O thread once the request headers are parsed; the
+// returned sink receives the body as it arrives, and the route handler then sees
+// a request without a body.
+using BodyHandler = std::function<BodySink(const HttpRequest &)>;
+
+// Where a route's synchronous handler runs on the epoll and io_uring backends.
+// Inline handlers run on the connection's I/O thread and must be cheap and
+// never block, like health checks or cached responses. Blocking handlers, that
+// wait on files, databases or other services, run on a pool of their own so
+// they cannot hold every worker.
+enum class ExecutionPolicy
+{
+    Inline,
+    Worker,
+    Blocking,
+};
+
 struct Route
 {
     HttpMethod method;
     std::regex pattern;
     RouteHandler handler;
+    AsyncRouteHandler async_handler;
+    ExecutionPolicy policy = ExecutionPolicy::Worker;
+
+    Route(HttpMethod m, const std::string &p, RouteHandler h, ExecutionPolicy e = ExecutionPolicy::Worker)
+        : method(m), pattern(p), handler(std::move(h)), policy(e) {}
+    Route(HttpMethod m, const std::string &p, AsyncRouteHandler h)
+        : method(m), pattern(p), async_handler(std::move(h)) {}
+};
 
-    Route(HttpMethod m, const std::string &p, RouteHandler h)
+struct BodyRoute
+{
+    HttpMethod method;
+    std::regex pattern;
+    BodyHandler handler;
+
+    BodyRoute(HttpMethod m, const std::string &p, BodyHandler h)
         : method(m), pattern(p), handler(std::move(h)) {}
 };
 
@@ -26,23 +64,45 @@ class Router
 {
 private:
     std::vector<Route> m_routes;
+    std::vector<BodyRoute> m_body_routes;
     RouteHandler m_not_found_handler;
     RouteHandler m_method_not_allowed_handler;
+    size_t m_async_routes = 0;
+    size_t m_placed_routes = 0;
+
+    const Route *find_route(const HttpRequest &request) const;
+    HttpResponse handle_unrouted(const HttpRequest &request);
+    static HttpResponse make_error_response();
 
 public:
     Router();
 
-    void get(const std::string &path, RouteHandler handler);
-    void post(const std::string &path, RouteHandler handler);
-    void put(const std::string &path, RouteHandler handler);
-    void delete_(const std::string &path, RouteHandler handler);
+    void get(const std::string &path, RouteHandler handler, ExecutionPolicy policy = ExecutionPolicy::Worker);
+    void post(const std::string &path, RouteHandler handler, ExecutionPolicy policy = ExecutionPolicy::Worker);
+    void put(const std::string &path, RouteHandler handler, ExecutionPolicy policy = ExecutionPolicy::Worker);
+    void delete_(const std::string &path, RouteHandler handler, ExecutionPolicy policy = ExecutionPolicy::Worker);
+
+    void get(const std::string &path, AsyncRouteHandler handler);
+    void post(const std::string &path, AsyncRouteHandler handler);
+    void put(const std::string &path, AsyncRouteHandler handler);
+    void delete_(const std::string &path, AsyncRouteHandler handler);
 
-    void add_route(HttpMethod method, const std::string &path, RouteHandler handler);
+    void add_route(HttpMethod method, const std::string &path, RouteHandler handler,
+                   ExecutionPolicy policy = ExecutionPolicy::Worker);
+    void add_route(HttpMethod method, const std::string &path, AsyncRouteHandler handler);
+    void add_streaming_route(HttpMethod method, const std::string &path, BodyHandler body_handler, RouteHandler handler);
 
     void set_not_found_handler(RouteHandler handler);
     void set_method_not_allowed_handler(RouteHandler handler);
 
+    // Runs an async handler to completion on the calling thread.
     HttpResponse handle_request(const HttpRequest &request);
+    // Runs a synchronous handler in place, before the first suspension.
+    Async<HttpResponse> handle_request_async(const HttpRequest &request);
+    bool is_async(const HttpRequest &request) const;
+    // Unrouted requests and async routes run on workers when not awaited.
+    ExecutionPolicy get_execution_policy(const HttpRequest &request) const;
+    BodySink open_body_sink(const HttpRequest &request) const;
 };
 
 #endif // ROUTER_HPP
\ No newline at end of file
@@ -0,0 +1,266 @@
+#ifndef SERVER_CONFIG_HPP
+#define SERVER_CONFIG_HPP
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class IoBackend
+{
+    Blocking,
+    Epoll,
+    IoUring,
+};
+
+inline IoBackend io_backend_from_string(const std::string &backend)
+{
+    if (backend == "blocking")
+        return IoBackend::Blocking;
+    if (backend == "epoll")
+        return IoBackend::Epoll;
+    if (backend == "io_uring")
+        return IoBackend::IoUring;
+    throw std::invalid_argument("Unknown I/O backend: " + backend);
+}
+
+inline std::string io_backend_to_string(IoBackend backend)
+{
+    switch (backend)
+    {
+    case IoBackend::Blocking:
+        return "blocking";
+    case IoBackend::Epoll:
+        return "epoll";
+    case IoBackend::IoUring:
+        return "io_uring";
+    default:
+        throw std::invalid_argument("Unknown IoBackend enum value");
+    }
+}
+
+enum class LogLevel
+{
+    Debug,
+    Info,
+    Warning,
+    Error,
+    Off,
+};
+
+inline LogLevel log_level_from_string(const std::string &level)
+{
+    if (level == "debug")
+        return LogLevel::Debug;
+    if (level == "info")
+        return LogLevel::Info;
+    if (level == "warning")
+        return LogLevel::Warning;
+    if (level == "error")
+        return LogLevel::Error;
+    if (level == "off")
+        return LogLevel::Off;
+    throw std::invalid_argument("Unknown log level: " + level);
+}
+
+inline std::string log_level_to_string(LogLevel level)
+{
+    switch (level)
+    {
+    case LogLevel::Debug:
+        return "debug";
+    case LogLevel::Info:
+        return "info";
+    case LogLevel::Warning:
+        return "warning";
+    case LogLevel::Error:
+        return "error";
+    case LogLevel::Off:
+        return "off";
+    default:
+        throw std::invalid_argument("Unknown LogLevel enum value");
+    }
+}
+
+// Log lines below the level are skipped; per-connection and per-request lines
+// are Debug. Each thread queues its lines in a ring of ring_lines entries that
+// a writer thread empties every flush_interval; lines logged while the ring is
+// full are dropped and counted. A thread writes at most repeat_burst warnings
+// or errors from one place per repeat_interval, and counts the rest.
+struct LogPolicy
+{
+    LogLevel level = LogLevel::Info;
+    size_t ring_lines = 1024;
+    std::chrono::milliseconds flush_interval{20};
+    size_t repeat_burst = 10;
+    std::chrono::milliseconds repeat_interval{1000};
+};
+
+// Binary per-request records, written when path is set. A file holds up to
+// max_file_size bytes of records and is then renamed to path.1, shifting older
+// ones up to path.<max_files>. sample_rates[c] is the fraction of responses of
+// status class c + 1 (1xx to 5xx) recorded. Records are queued for a writer
+// thread in a queue of queue_capacity; records that find it full are dropped
+// and counted.
+struct AccessLogPolicy
+{
+    std::string path;
+    size_t max_file_size = 64 * 1024 * 1024;
+    size_t max_files = 4;
+    std::array<double, 5> sample_rates{1.0, 1.0, 1.0, 1.0, 1.0};
+    size_t queue_capacity = 16384;
+    std::chrono::milliseconds flush_interval{20};
+};
+
+// How small writes are coalesced into segments on accepted connections
+enum class NagleStrategy
+{
+    Default, // Nagle's algorithm
+    NoDelay, // TCP_NODELAY: segments leave as soon as they are written
+    Cork,    // TCP_CORK held while a response is written and released once it is sent
+};
+
+// Options for the listening socket. Connection options are set on the listener,
+// which Linux accepted sockets inherit, or on each accepted socket elsewhere.
+// Options the platform lacks are ignored.
+struct SocketPolicy
+{
+    // Pending connections queued by listen(); the kernel caps it at net.core.somaxconn.
+    int backlog = 1024;
+    // TCP_DEFER_ACCEPT: seconds a connection is held back until its first data arrives; 0 disables.
+    int defer_accept_seconds = 0;
+    // TCP_FASTOPEN: Fast Open requests the listener queues before the handshake completes; 0 disables.
+    int fast_open_queue = 0;
+
+    NagleStrategy nagle = NagleStrategy::NoDelay;
+    // SO_SNDBUF/SO_RCVBUF in bytes; 0 keeps the kernel's autotuning.
+    int send_buffer_size = 0;
+    int receive_buffer_size = 0;
+    // SO_BUSY_POLL: microseconds a read busy-polls the device queue before sleeping; 0 disables.
+    int busy_poll_us = 0;
+};
+
+// CPU numbers, as listed by the kernel.
+using CpuSet = std::vector<int>;
+
+// Where the server's threads run. A thread given an empty CPU set is not pinned.
+struct ThreadTopology
+{
+    // Handler threads; 0 starts one per CPU the process may run on, or per
+    // CPU left to them when I/O threads are isolated.
+    size_t workers = 0;
+    // Worker i runs on worker_cpus[i % size]. Without explicit sets,
+    // pin_workers gives each worker a single CPU of its own, round-robin.
+    std::vector<CpuSet> worker_cpus;
+    bool pin_workers = false;
+
+    // I/O thread i runs on io_cpus[i % size]. isolate_io_threads keeps workers
+    // without explicit sets off the I/O threads' CPUs, and without explicit
+    // I/O sets pins each I/O thread to one of the first CPUs.
+    std::vector<CpuSet> io_cpus;
+    bool isolate_io_threads = false;
+
+    // Buffer pool slabs are bound to the NUMA node of the CPU the owning thread
+    // runs on when they are mapped, rather than following the first touch.
+    bool numa_local_buffers = false;
+};
+
+struct ServerConfig
+{
+#ifdef __linux__
+    IoBackend backend = IoBackend::Epoll;
+#else
+    IoBackend backend = IoBackend::Blocking;
+#endif
+    size_t io_threads = std::max<size_t>(1, std::thread::hardware_concurrency() / 4);
+
+    // Gives every I/O thread its own SO_REUSEPORT listener and runs handlers on
+    // that thread, so shards share neither an accept queue nor the worker pool.
+    bool reuse_port_shards = false;
+    // Pins shard i to CPU i and steers each connection to the shard on the CPU
+    // that received it; most effective with one shard per CPU.
+    bool shard_cpu_steering = false;
+
+    // Larger requests are rejected with 400. Bodies streamed to a BodySink are
+    // held to max_streamed_body_size instead, where 0 means unlimited.
+    size_t max_request_header_size = 64 * 1024;
+    size_t max_request_body_size = 1024 * 1024;
+    size_t max_streamed_body_size = 1024 * 1024 * 1024;
+
+    // Listens on this AF_UNIX stream socket instead of a TCP port, for a proxy on
+    // the same host. A leading '@' names a socket in Linux's abstract namespace,
+    // which has no file. Otherwise a socket file left by a server that died is
+    // replaced, the new one gets unix_socket_mode, and it is removed on exit.
+    // A Unix socket is never sharded.
+    std::string unix_socket_path;
+    int unix_socket_mode = 0660;
+
+    // Persistent connections are closed after this many requests or once idle for the timeout.
+    size_t max_keep_alive_requests = 100;
+    std::chrono::milliseconds keep_alive_timeout{5000};
+
+    // A request's headers must arrive within the header timeout of its first
+    // byte, and its body may pause between reads for at most the body timeout;
+    // both are answered with 408. A new connection has the header timeout to
+    // start its first request.
+    std::chrono::milliseconds request_header_timeout{10000};
+    std::chrono::milliseconds request_body_timeout{30000};
+
+    // Streamed bodies are produced ahead of the socket until this much output is
+    // pending. A connection whose pending output makes no progress for the stall
+    // timeout is dropped.
+    size_t output_high_water_mark = 256 * 1024;
+    std::chrono::milliseconds send_stall_timeout{30000};
+
+    // A draining server waits this long for started requests to finish before
+    // closing the connections that remain.
+    std::chrono::milliseconds drain_timeout{30000};
+
+    // Admission control for the worker pool. Once max_queue_depth tasks wait,
+    // new requests are answered with 503 and Retry-After without queueing, and
+    // a request that waited longer than max_queue_delay gets the same answer
+    // when a worker reaches it. Below those limits CoDel sheds requests once
+    // their queueing time has stayed above queue_target_delay for a whole
+    // queue_interval. A limit of 0 disables it.
+    size_t max_queue_depth = 1024;
+    std::chrono::milliseconds max_queue_delay{5000};
+    std::chrono::milliseconds queue_target_delay{100};
+    std::chrono::milliseconds queue_interval{1000};
+    int retry_after_seconds = 1;
+
+    // Threads for routes with ExecutionPolicy::Blocking. Once
+    // max_blocking_queue_depth of their requests wait, further ones are
+    // answered with 503. With no blocking workers those routes run on the
+    // worker pool, as every handler does on the blocking backend.
+    size_t blocking_workers = 4;
+    size_t max_blocking_queue_depth = 256;
+
+    // Connections taken off the listen queue per wakeup before they are handed
+    // on; the io_uring backend uses a multishot accept instead.
+    size_t accept_batch_size = 64;
+
+    SocketPolicy socket_policy;
+
+    // Connection I/O buffers come from per-thread pools of 2 MiB slabs; with
+    // this set the slabs are backed by huge pages, reserved ones if the system
+    // has them and transparent ones otherwise.
+    bool huge_page_buffers = false;
+
+    ThreadTopology topology;
+
+    LogPolicy logging;
+
+    AccessLogPolicy access_log;
+
+    // Receive buffers go to the kernel through a registered buffer ring (Linux
+    // 5.19+), falling back to IORING_OP_PROVIDE_BUFFERS where registering fails.
+    // Responses go out as one IORING_OP_SENDMSG of up to 64 segments rather than
+    // linked sends, since a short send ends a link chain and cancels the rest.
+    bool io_uring_buffer_ring = true;
+};
+
+#endif // SERVER_CONFIG_HPP
@@ -0,0 +1,130 @@
+#ifndef TASK_HPP
+#define TASK_HPP
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// A move-only void() callable stored inline, so building and queueing a task
+// does not allocate. Callables larger than the inline storage are kept on the
+// heap instead; the server's own tasks all fit, the largest being a request
+// batch with its connection id, origin and request count.
+class Task
+{
+public:
+    static constexpr size_t inline_size = 80;
+
+private:
+    struct Operations
+    {
+        void (*invoke)(void *storage);
+        void (*relocate)(void *from, void *to);
+        void (*destroy)(void *storage);
+    };
+
+    template <typename F>
+    static constexpr bool is_inline = sizeof(F) <= inline_size && alignof(F) <= alignof(std::max_align_t) &&
+                                      std::is_nothrow_move_constructible_v<F>;
+
+    template <typename F>
+    static F *target(void *storage)
+    {
+        if constexpr (is_inline<F>)
+            return std::launder(static_cast<F *>(storage));
+        else
+            return *static_cast<F **>(storage);
+    }
+
+    template <typename F>
+    static constexpr Operations operations_for = {
+        [](void *storage)
+        { (*target<F>(storage))(); },
+        [](void *from, void *to)
+        {
+            if constexpr (is_inline<F>)
+            {
+                ::new (to) F(std::move(*target<F>(from)));
+                target<F>(from)->~F();
+            }
+            else
+            {
+                ::new (to) F *(*static_cast<F **>(from));
+            }
+        },
+        [](void *storage)
+        {
+            if constexpr (is_inline<F>)
+                target<F>(storage)->~F();
+            else
+                delete target<F>(storage);
+        },
+    };
+
+    alignas(std::max_align_t) unsigned char m_storage[inline_size];
+    const Operations *m_operations = nullptr;
+
+public:
+    Task() = default;
+    Task(std::nullptr_t) {}
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task> &&
+                                                      !std::is_same_v<std::decay_t<F>, std::nullptr_t>>>
+    Task(F &&function)
+    {
+        using Function = std::decay_t<F>;
+
+        if constexpr (is_inline<Function>)
+            ::new (m_storage) Function(std::forward<F>(function));
+        else
+            ::new (m_storage) Function *(new Function(std::forward<F>(function)));
+
+        m_operations = &operations_for<Function>;
+    }
+
+    Task(Task &&other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    Task &operator=(Task &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+
+            if (other.m_operations)
+            {
+                other.m_operations->relocate(other.m_storage, m_storage);
+                m_operations = std::exchange(other.m_operations, nullptr);
+            }
+        }
+        return *this;
+    }
+
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    ~Task()
+    {
+        reset();
+    }
+
+    explicit operator bool() const
+    {
+        return m_operations != nullptr;
+    }
+
+    void operator()()
+    {
+        m_operations->invoke(m_storage);
+    }
+
+    void reset()
+    {
+        if (m_operations)
+            std::exchange(m_operations, nullptr)->destroy(m_storage);
+    }
+};
+
+#endif // TASK_HPP
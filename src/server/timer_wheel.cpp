@@ -0,0 +1,226 @@
+#include "server/timer_wheel.hpp"
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+TimerWheel::Timer::Timer(uint64_t owner)
+    : m_wheel(nullptr),
+      m_prev(nullptr),
+      m_next(nullptr),
+      m_expiry(0),
+      m_owner(owner)
+{
+}
+
+TimerWheel::Timer::~Timer()
+{
+    cancel();
+}
+
+uint64_t TimerWheel::Timer::get_owner() const
+{
+    return m_owner;
+}
+
+bool TimerWheel::Timer::is_scheduled() const
+{
+    return m_wheel != nullptr;
+}
+
+void TimerWheel::Timer::cancel()
+{
+    if (m_wheel)
+        m_wheel->unlink(*this);
+}
+
+// Removes the timer from its slot list; returns the slot head if the slot is now empty.
+TimerWheel::Timer *TimerWheel::Timer::detach()
+{
+    Timer *emptied = m_prev == m_next ? m_prev : nullptr;
+
+    m_prev->m_next = m_next;
+    m_next->m_prev = m_prev;
+    m_prev = m_next = nullptr;
+
+    return emptied;
+}
+
+TimerWheel::TimerWheel(clock::duration tick, clock::time_point now)
+    : m_tick(std::max(tick, clock::duration(1))),
+      m_start(now),
+      m_current(0),
+      m_scheduled(0),
+      m_occupied{}
+{
+    // Slot heads are the sentinels of circular lists.
+    for (auto &level : m_slots)
+    {
+        for (Timer &head : level)
+            head.m_prev = head.m_next = &head;
+    }
+}
+
+TimerWheel::~TimerWheel()
+{
+    for (auto &level : m_slots)
+    {
+        for (Timer &head : level)
+        {
+            while (head.m_next != &head)
+            {
+                Timer &timer = *head.m_next;
+                timer.detach();
+                timer.m_wheel = nullptr;
+            }
+            head.m_prev = head.m_next = nullptr;
+        }
+    }
+}
+
+uint64_t TimerWheel::tick_of(clock::time_point time) const
+{
+    if (time <= m_start)
+        return 0;
+    return static_cast<uint64_t>((time - m_start + m_tick - clock::duration(1)) / m_tick);
+}
+
+void TimerWheel::link(Timer &timer)
+{
+    uint64_t delta = timer.m_expiry - m_current;
+    unsigned level = 0;
+
+    while (level + 1 < levels && delta >= (uint64_t(1) << (slot_bits * (level + 1))))
+        ++level;
+
+    // Beyond the top level a timer waits in its furthest slot and is placed
+    // again when that slot cascades.
+    uint64_t expiry = std::min(timer.m_expiry, m_current + (uint64_t(1) << (slot_bits * levels)) - 1);
+    unsigned slot = (expiry >> (slot_bits * level)) & (slots_per_level - 1);
+
+    Timer &head = m_slots[level][slot];
+    timer.m_wheel = this;
+    timer.m_prev = head.m_prev;
+    timer.m_next = &head;
+    head.m_prev->m_next = &timer;
+    head.m_prev = &timer;
+
+    m_occupied[level] |= uint64_t(1) << slot;
+}
+
+void TimerWheel::unlink(Timer &timer)
+{
+    if (Timer *head = timer.detach())
+        clear_slot(*head);
+
+    timer.m_wheel = nullptr;
+    --m_scheduled;
+}
+
+void TimerWheel::clear_slot(const Timer &head)
+{
+    for (unsigned level = 0; level < levels; ++level)
+    {
+        const Timer *first = m_slots[level].data();
+        if (&head >= first && &head < first + slots_per_level)
+        {
+            m_occupied[level] &= ~(uint64_t(1) << (&head - first));
+            return;
+        }
+    }
+}
+
+void TimerWheel::cascade(unsigned level)
+{
+    unsigned slot = (m_current >> (slot_bits * level)) & (slots_per_level - 1);
+    Timer &head = m_slots[level][slot];
+
+    m_occupied[level] &= ~(uint64_t(1) << slot);
+
+    while (head.m_next != &head)
+    {
+        Timer &timer = *head.m_next;
+        timer.detach();
+        link(timer);
+    }
+}
+
+void TimerWheel::schedule(Timer &timer, clock::time_point deadline)
+{
+    timer.cancel();
+
+    if (deadline == clock::time_point::max())
+        return;
+
+    // The current tick's slot has already run, so the earliest expiry is the next tick.
+    timer.m_expiry = std::max(tick_of(deadline), m_current + 1);
+    link(timer);
+    ++m_scheduled;
+}
+
+void TimerWheel::advance(clock::time_point now, const std::function<void(Timer &)> &on_expired)
+{
+    uint64_t target = now <= m_start ? 0 : static_cast<uint64_t>((now - m_start) / m_tick);
+
+    while (m_current < target)
+    {
+        if (m_scheduled == 0)
+        {
+            m_current = target;
+            break;
+        }
+
+        ++m_current;
+
+        // Higher levels cascade first, so timers they move into a lower
+        // level's current slot are cascaded again on the same tick.
+        unsigned top = 0;
+        while (top + 1 < levels && (m_current & ((uint64_t(1) << (slot_bits * (top + 1))) - 1)) == 0)
+            ++top;
+
+        for (unsigned level = top; level >= 1; --level)
+            cascade(level);
+
+        Timer &head = m_slots[0][m_current & (slots_per_level - 1)];
+
+        while (head.m_next != &head)
+        {
+            Timer &timer = *head.m_next;
+            unlink(timer);
+            on_expired(timer);
+        }
+    }
+}
+
+int TimerWheel::get_next_timeout_ms(clock::time_point now) const
+{
+    if (m_scheduled == 0)
+        return -1;
+
+    uint64_t next = std::numeric_limits<uint64_t>::max();
+
+    for (unsigned level = 0; level < levels; ++level)
+    {
+        if (m_occupied[level] == 0)
+            continue;
+
+        // Distance in this level's slots to the next occupied one after the current slot.
+        uint64_t position = m_current >> (slot_bits * level);
+        unsigned slot = position & (slots_per_level - 1);
+        uint64_t after = std::rotr(m_occupied[level], static_cast<int>((slot + 1) % slots_per_level));
+        uint64_t distance = std::countr_zero(after) + 1;
+
+        next = std::min(next, (position + distance) << (slot_bits * level));
+    }
+
+    clock::time_point due = m_start + m_tick * next;
+    if (due <= now)
+        return 0;
+
+    auto remaining = std::chrono::ceil<std::chrono::milliseconds>(due - now).count();
+    return static_cast<int>(std::min<decltype(remaining)>(remaining, std::numeric_limits<int>::max()));
+}
+
+size_t TimerWheel::size() const
+{
+    return m_scheduled;
+}
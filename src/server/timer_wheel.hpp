@@ -0,0 +1,81 @@
+#ifndef TIMER_WHEEL_HPP
+#define TIMER_WHEEL_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// Hierarchical timer wheel: four levels of 64 slots, each slot spanning 64
+// times the one below. Timers are intrusive list nodes owned by the caller,
+// so scheduling, rescheduling and cancelling are O(1) and never allocate.
+// Timers far ahead sit in coarse slots and cascade down as their time nears.
+class TimerWheel
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    class Timer
+    {
+    private:
+        friend class TimerWheel;
+
+        TimerWheel *m_wheel;
+        Timer *m_prev;
+        Timer *m_next;
+        uint64_t m_expiry;
+        uint64_t m_owner;
+
+        Timer *detach();
+
+    public:
+        explicit Timer(uint64_t owner = 0);
+        ~Timer();
+
+        Timer(const Timer &) = delete;
+        Timer &operator=(const Timer &) = delete;
+
+        uint64_t get_owner() const;
+        bool is_scheduled() const;
+        void cancel();
+    };
+
+private:
+    static constexpr unsigned slot_bits = 6;
+    static constexpr unsigned slots_per_level = 1u << slot_bits;
+    static constexpr unsigned levels = 4;
+
+    clock::duration m_tick;
+    clock::time_point m_start;
+    uint64_t m_current;
+    size_t m_scheduled;
+    std::array<std::array<Timer, slots_per_level>, levels> m_slots;
+    std::array<uint64_t, levels> m_occupied;
+
+    uint64_t tick_of(clock::time_point time) const;
+    void link(Timer &timer);
+    void unlink(Timer &timer);
+    void clear_slot(const Timer &head);
+    void cascade(unsigned level);
+
+public:
+    TimerWheel(clock::duration tick, clock::time_point now = clock::now());
+
+    TimerWheel(const TimerWheel &) = delete;
+    TimerWheel &operator=(const TimerWheel &) = delete;
+
+    ~TimerWheel();
+
+    // Deadlines are rounded up to the next tick; clock::time_point::max() cancels.
+    void schedule(Timer &timer, clock::time_point deadline);
+
+    // Runs on_expired for every timer due by now; it may schedule or destroy timers.
+    void advance(clock::time_point now, const std::function<void(Timer &)> &on_expired);
+
+    // Milliseconds until the next timer may be due, or -1 when none is scheduled.
+    int get_next_timeout_ms(clock::time_point now) const;
+    size_t size() const;
+};
+
+#endif // TIMER_WHEEL_HPP
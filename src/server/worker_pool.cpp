@@ -0,0 +1,211 @@
+#include "server/worker_pool.hpp"
+#include <algorithm>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+// Counters have a single writer, the worker itself.
+static void increment(std::atomic<uint64_t> &counter)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+WorkerPool::WorkerPool(size_t workers, Executor executor, const std::vector<CpuSet> &cpus, size_t capacity)
+    : m_executor(std::move(executor))
+{
+    workers = std::max<size_t>(1, workers);
+
+    for (size_t i = 0; i < workers; ++i)
+        m_workers.push_back(std::make_unique<Worker>(capacity));
+
+    // Started once every queue exists, since workers steal from all of them.
+    for (size_t i = 0; i < workers; ++i)
+    {
+        Worker &worker = *m_workers[i];
+        worker.thread = std::thread(&WorkerPool::run_worker, this, i);
+
+        // Read back, since the kernel drops CPUs the process may not use.
+        if (i < cpus.size() && !cpus[i].empty() && set_thread_affinity(worker.thread, cpus[i]))
+            worker.cpus = get_thread_affinity(worker.thread);
+
+        // A CPU shared by several workers goes to the first of them.
+        for (int cpu : worker.cpus)
+        {
+            if (static_cast<size_t>(cpu) >= m_cpu_workers.size())
+                m_cpu_workers.resize(cpu + 1, no_worker);
+            if (m_cpu_workers[cpu] == no_worker)
+                m_cpu_workers[cpu] = i;
+        }
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    m_stopping = true;
+
+    for (auto &worker : m_workers)
+        worker->events.notify_all();
+
+    for (auto &worker : m_workers)
+    {
+        if (worker->thread.joinable())
+            worker->thread.join();
+    }
+}
+
+bool WorkerPool::push(QueuedTask &task)
+{
+    return push_to(pick_worker(), task);
+}
+
+bool WorkerPool::push_to(size_t index, QueuedTask &task)
+{
+    for (size_t i = 0; i < m_workers.size(); ++i)
+    {
+        size_t target = (index + i) % m_workers.size();
+
+        if (m_workers[target]->tasks.try_push(task))
+        {
+            wake(target);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Wakes the queue's owner, or if it is busy a parked worker that can steal the task.
+void WorkerPool::wake(size_t index)
+{
+    if (m_workers[index]->events.notify_one())
+        return;
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_parked.load(std::memory_order_relaxed) == 0)
+        return;
+
+    for (size_t i = 1; i < m_workers.size(); ++i)
+    {
+        if (m_workers[(index + i) % m_workers.size()]->events.notify_one())
+            return;
+    }
+}
+
+size_t WorkerPool::pick_worker() const
+{
+#ifdef __linux__
+    int cpu = sched_getcpu();
+    if (cpu >= 0 && static_cast<size_t>(cpu) < m_cpu_workers.size() && m_cpu_workers[cpu] != no_worker)
+        return m_cpu_workers[cpu];
+#endif
+
+    thread_local size_t next = 0;
+    return next++ % m_workers.size();
+}
+
+bool WorkerPool::take(size_t index, QueuedTask &task)
+{
+    Worker &worker = *m_workers[index];
+
+    if (worker.tasks.try_pop(task))
+        return true;
+
+    // Victims are tried from the next worker on, so thieves spread out.
+    for (size_t i = 1; i < m_workers.size(); ++i)
+    {
+        if (m_workers[(index + i) % m_workers.size()]->tasks.try_pop(task))
+        {
+            increment(worker.stolen);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void WorkerPool::run_worker(size_t index)
+{
+    Worker &worker = *m_workers[index];
+    QueuedTask task;
+
+    while (true)
+    {
+        // A worker yields a few times before parking, so under load producers
+        // find nobody parked and skip the wake-up system call.
+        bool taken = take(index, task);
+        for (int spin = 0; spin < spin_count && !taken; ++spin)
+        {
+            std::this_thread::yield();
+            taken = take(index, task);
+        }
+
+        if (!taken)
+        {
+            ++m_parked;
+            uint32_t epoch = worker.events.prepare_wait();
+
+            if (take(index, task))
+            {
+                worker.events.cancel_wait();
+                --m_parked;
+            }
+            else if (m_stopping)
+            {
+                worker.events.cancel_wait();
+                --m_parked;
+                break;
+            }
+            else
+            {
+                worker.events.wait(epoch);
+                --m_parked;
+                continue;
+            }
+        }
+
+        m_executor(task);
+        increment(worker.executed);
+
+        task.run.reset();
+        task.shed.reset();
+    }
+}
+
+std::vector<CpuSet> WorkerPool::get_worker_cpus() const
+{
+    std::vector<CpuSet> cpus;
+
+    for (const auto &worker : m_workers)
+        cpus.push_back(worker->cpus);
+
+    return cpus;
+}
+
+size_t WorkerPool::size() const
+{
+    return m_workers.size();
+}
+
+size_t WorkerPool::get_queued_count() const
+{
+    size_t queued = 0;
+    for (const auto &worker : m_workers)
+        queued += worker->tasks.size();
+    return queued;
+}
+
+std::vector<WorkerStats> WorkerPool::get_stats() const
+{
+    std::vector<WorkerStats> stats;
+
+    for (const auto &worker : m_workers)
+    {
+        WorkerStats worker_stats;
+        worker_stats.executed = worker->executed.load(std::memory_order_relaxed);
+        worker_stats.stolen = worker->stolen.load(std::memory_order_relaxed);
+        stats.push_back(worker_stats);
+    }
+
+    return stats;
+}
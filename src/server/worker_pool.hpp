@@ -0,0 +1,100 @@
+#ifndef WORKER_POOL_HPP
+#define WORKER_POOL_HPP
+
+#include "cpu_topology.hpp"
+#include "event_count.hpp"
+#include "mpmc_queue.hpp"
+#include "task.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+struct WorkerStats
+{
+    uint64_t executed = 0;
+    uint64_t stolen = 0;
+};
+
+// Work that can be refused carries a shed callback answering it with 503;
+// continuations of admitted work, such as streamed bodies, have none.
+struct QueuedTask
+{
+    Task run;
+    Task shed;
+    std::chrono::steady_clock::time_point enqueued;
+};
+
+// Handler threads with a run queue each. A task goes to the queue of the
+// worker pinned to the CPU it is pushed from, so that worker finds connection
+// and router data still in its cache; tasks pushed from a CPU without a worker
+// are spread round-robin. A worker whose queue is empty steals from the others
+// before it parks. Queues are lock-free rings rather than Chase-Lev deques,
+// since tasks are pushed by I/O threads and never by their owner. A task that
+// finds its queue full goes to the next one with room; when every queue is
+// full it is refused, and the caller sheds it or waits.
+class WorkerPool
+{
+public:
+    // Runs or sheds each task a worker takes.
+    using Executor = std::function<void(QueuedTask &task)>;
+
+    static constexpr size_t queue_capacity = 1024;
+    static constexpr int spin_count = 64;
+    static constexpr size_t no_worker = SIZE_MAX;
+
+private:
+    struct Worker
+    {
+        MpmcQueue<QueuedTask> tasks;
+        EventCount events;
+        std::atomic<uint64_t> executed{0};
+        std::atomic<uint64_t> stolen{0};
+        std::thread thread;
+        CpuSet cpus;
+
+        explicit Worker(size_t capacity)
+            : tasks(capacity) {}
+    };
+
+    Executor m_executor;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    // Worker pinned to each CPU, indexed by CPU number; no_worker for the rest.
+    std::vector<size_t> m_cpu_workers;
+    std::atomic<size_t> m_parked{0};
+    std::atomic<bool> m_stopping{false};
+
+    void run_worker(size_t index);
+    bool take(size_t index, QueuedTask &task);
+    size_t pick_worker() const;
+    void wake(size_t index);
+
+public:
+    // Worker i is pinned to cpus[i] when that set exists and is not empty. Each
+    // worker's queue holds capacity tasks, rounded up to a power of two.
+    WorkerPool(size_t workers, Executor executor, const std::vector<CpuSet> &cpus = {},
+               size_t capacity = queue_capacity);
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    // Stops the workers after the tasks they are running; queued tasks are dropped.
+    ~WorkerPool();
+
+    // False, leaving the task as it was, when every queue is full.
+    bool push(QueuedTask &task);
+    // Pushes to the given worker's queue instead of the current CPU's.
+    bool push_to(size_t index, QueuedTask &task);
+
+    size_t size() const;
+    size_t get_queued_count() const;
+    std::vector<WorkerStats> get_stats() const;
+    // CPUs each worker was actually pinned to; empty for unpinned workers.
+    std::vector<CpuSet> get_worker_cpus() const;
+};
+
+#endif // WORKER_POOL_HPP
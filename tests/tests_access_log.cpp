@@ -0,0 +1,224 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "server/access_log.hpp"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+
+class AccessLogTest : public ::testing::Test
+{
+protected:
+    std::filesystem::path directory;
+    AccessLogPolicy policy;
+    PeerAddress peer;
+
+    void SetUp() override
+    {
+        directory = std::filesystem::temp_directory_path() / ("access-log-tests-" + std::to_string(getpid()));
+        std::filesystem::create_directories(directory);
+        policy.path = directory / "access.log";
+        // Only flush() writes, so tests see exactly what was queued.
+        policy.flush_interval = std::chrono::hours(1);
+
+        peer.family = PeerFamily::IPv4;
+        peer.port = 54321;
+        peer.address = {192, 0, 2, 7};
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(directory);
+    }
+
+    // Helper method to queue a request with the given URI and status
+    void record(AccessLog &log, const std::string &uri, int status = 200)
+    {
+        log.record(HttpMethod::GET, uri, status, 100, std::chrono::microseconds(250), peer);
+    }
+
+    // Helper method to read the URIs recorded in one file
+    static std::vector<std::string> readUris(const std::string &path)
+    {
+        std::vector<std::string> uris;
+        for (const AccessRecord &record : read_access_log(path))
+            uris.emplace_back(record.uri, record.uri_length);
+        return uris;
+    }
+
+    // Helper method to build a record with fixed contents for formatting
+    static AccessRecord sampleRecord()
+    {
+        AccessRecord record{};
+        record.timestamp_us = 1700000000123456;
+        record.bytes = 512;
+        record.duration_us = 1500;
+        record.status = 404;
+        record.method = static_cast<uint8_t>(HttpMethod::POST);
+        record.peer_family = static_cast<uint8_t>(PeerFamily::IPv4);
+        record.peer_address[0] = 127;
+        record.peer_address[3] = 1;
+        record.peer_port = 8080;
+        std::string uri = "/items?name=\"a\"";
+        record.uri_length = static_cast<uint16_t>(uri.size());
+        uri.copy(record.uri, uri.size());
+        return record;
+    }
+};
+
+// Tests for writing
+TEST_F(AccessLogTest, flush_should_write_records_readable_by_read_access_log)
+{
+    AccessLog log(policy);
+
+    log.record(HttpMethod::DELETE, "/items/7", 204, 87, std::chrono::milliseconds(3), peer);
+    record(log, "/second", 500);
+    log.flush();
+
+    std::vector<AccessRecord> records = read_access_log(policy.path);
+    ASSERT_EQ(records.size(), 2u);
+    EXPECT_GT(records[0].timestamp_us, 0u);
+    EXPECT_EQ(records[0].method, static_cast<uint8_t>(HttpMethod::DELETE));
+    EXPECT_EQ(std::string(records[0].uri, records[0].uri_length), "/items/7");
+    EXPECT_EQ(records[0].status, 204);
+    EXPECT_EQ(records[0].bytes, 87u);
+    EXPECT_EQ(records[0].duration_us, 3000u);
+    EXPECT_EQ(records[0].peer_port, 54321);
+    EXPECT_EQ(records[1].status, 500);
+    EXPECT_EQ(log.get_written_count(), 2u);
+}
+
+TEST_F(AccessLogTest, record_should_cut_uri_and_keep_its_length_when_uri_is_longer_than_record)
+{
+    AccessLog log(policy);
+    std::string uri = "/" + std::string(200, 'a');
+
+    record(log, uri);
+    log.flush();
+
+    std::vector<AccessRecord> records = read_access_log(policy.path);
+    ASSERT_EQ(records.size(), 1u);
+    EXPECT_EQ(records[0].uri_length, uri.size());
+    EXPECT_EQ(std::string(records[0].uri, AccessRecord::uri_size), uri.substr(0, AccessRecord::uri_size));
+}
+
+TEST_F(AccessLogTest, destructor_should_truncate_file_to_records_written)
+{
+    {
+        AccessLog log(policy);
+        record(log, "/one");
+        record(log, "/two");
+    }
+
+    EXPECT_EQ(std::filesystem::file_size(policy.path), AccessLogHeader::header_size + 2 * sizeof(AccessRecord));
+    EXPECT_EQ(readUris(policy.path), (std::vector<std::string>{"/one", "/two"}));
+}
+
+TEST_F(AccessLogTest, record_should_drop_and_count_records_when_queue_is_full)
+{
+    policy.queue_capacity = 2;
+    AccessLog log(policy);
+
+    for (int i = 0; i < 5; ++i)
+        record(log, "/" + std::to_string(i));
+    log.flush();
+
+    EXPECT_EQ(log.get_dropped_count(), 3u);
+    EXPECT_EQ(readUris(policy.path), (std::vector<std::string>{"/0", "/1"}));
+}
+
+// Tests for rotation
+TEST_F(AccessLogTest, flush_should_rotate_files_when_file_is_full)
+{
+    policy.max_file_size = AccessLogHeader::header_size + 2 * sizeof(AccessRecord);
+    policy.max_files = 2;
+    AccessLog log(policy);
+
+    for (int i = 0; i < 7; ++i)
+        record(log, "/" + std::to_string(i));
+    log.flush();
+
+    EXPECT_EQ(readUris(policy.path), (std::vector<std::string>{"/6"}));
+    EXPECT_EQ(readUris(policy.path + ".1"), (std::vector<std::string>{"/4", "/5"}));
+    EXPECT_EQ(readUris(policy.path + ".2"), (std::vector<std::string>{"/2", "/3"}));
+    EXPECT_FALSE(std::filesystem::exists(policy.path + ".3"));
+}
+
+TEST_F(AccessLogTest, constructor_should_rotate_existing_file_when_path_is_taken)
+{
+    {
+        AccessLog log(policy);
+        record(log, "/earlier");
+    }
+
+    AccessLog log(policy);
+    record(log, "/later");
+    log.flush();
+
+    EXPECT_EQ(readUris(policy.path), (std::vector<std::string>{"/later"}));
+    EXPECT_EQ(readUris(policy.path + ".1"), (std::vector<std::string>{"/earlier"}));
+}
+
+// Tests for sampling
+TEST_F(AccessLogTest, should_record_should_sample_each_status_class_at_its_rate)
+{
+    policy.sample_rates = {1.0, 0.0, 1.0, 0.25, 1.0};
+    AccessLog log(policy);
+
+    size_t recorded = 0;
+    for (int i = 0; i < 10000; ++i)
+        recorded += log.should_record(404);
+
+    EXPECT_TRUE(log.should_record(500));
+    EXPECT_TRUE(log.should_record(302));
+    EXPECT_FALSE(log.should_record(200));
+    EXPECT_GT(recorded, 2000u);
+    EXPECT_LT(recorded, 3000u);
+}
+
+TEST_F(AccessLogTest, parse_sample_rates_should_set_named_classes_only)
+{
+    std::array<double, 5> rates{1.0, 1.0, 1.0, 1.0, 1.0};
+
+    parse_sample_rates("2xx=0.01,5xx=1", rates);
+
+    EXPECT_EQ(rates, (std::array<double, 5>{1.0, 0.01, 1.0, 1.0, 1.0}));
+}
+
+TEST_F(AccessLogTest, parse_sample_rates_should_throw_when_entry_is_invalid)
+{
+    std::array<double, 5> rates{};
+
+    EXPECT_THROW(parse_sample_rates("6xx=1", rates), std::invalid_argument);
+    EXPECT_THROW(parse_sample_rates("2xx=1.5", rates), std::invalid_argument);
+    EXPECT_THROW(parse_sample_rates("2xx", rates), std::invalid_argument);
+    EXPECT_THROW(parse_sample_rates("2xx=0.5x", rates), std::invalid_argument);
+}
+
+// Tests for decoding
+TEST_F(AccessLogTest, format_access_record_should_describe_record_as_text)
+{
+    EXPECT_EQ(format_access_record(sampleRecord()),
+              "2023-11-14T22:13:20.123456Z 127.0.0.1:8080 POST /items?name=\"a\" 404 512 1500us");
+}
+
+TEST_F(AccessLogTest, format_access_record_csv_should_quote_uri)
+{
+    EXPECT_EQ(access_record_csv_header(), "timestamp,peer,method,uri,status,bytes,duration_us");
+    EXPECT_EQ(format_access_record_csv(sampleRecord()),
+              "2023-11-14T22:13:20.123456Z,127.0.0.1:8080,POST,\"/items?name=\"\"a\"\"\",404,512,1500");
+}
+
+TEST_F(AccessLogTest, read_access_log_should_throw_when_file_is_not_access_log)
+{
+    std::ofstream(policy.path) << "GET / 200\n";
+
+    EXPECT_THROW(read_access_log(policy.path), std::runtime_error);
+}
+#endif
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include "server/async.hpp"
+#include "server/async_io.hpp"
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+class AsyncTest : public ::testing::Test
+{
+protected:
+    int pipe_fds[2] = {-1, -1};
+
+    void SetUp() override
+    {
+        ASSERT_EQ(pipe(pipe_fds), 0);
+    }
+
+    void TearDown() override
+    {
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+    }
+
+    // Helper method to build a coroutine returning a value without suspending
+    static Async<int> constant(int value)
+    {
+        co_return value;
+    }
+
+    // Helper method to build a coroutine that awaits two others
+    static Async<int> sum(int a, int b)
+    {
+        int first = co_await constant(a);
+        int second = co_await constant(b);
+        co_return first + second;
+    }
+
+    static Async<int> failing()
+    {
+        throw std::runtime_error("failed");
+        co_return 0;
+    }
+};
+
+// Tests for Async
+TEST_F(AsyncTest, start_should_run_coroutine_and_call_back_when_it_returns)
+{
+    Async<int> async = constant(7);
+    bool done = false;
+
+    EXPECT_FALSE(async.is_done());
+    async.start([&done]
+                { done = true; });
+
+    EXPECT_TRUE(done);
+    EXPECT_TRUE(async.is_done());
+    EXPECT_EQ(async.get_result(), 7);
+}
+
+TEST_F(AsyncTest, co_await_should_compose_values_when_coroutines_await_each_other)
+{
+    EXPECT_EQ(sync_wait(sum(2, 3)), 5);
+}
+
+TEST_F(AsyncTest, get_result_should_rethrow_when_coroutine_threw)
+{
+    EXPECT_THROW(sync_wait(failing()), std::runtime_error);
+}
+
+TEST_F(AsyncTest, co_await_should_rethrow_in_awaiter_when_awaited_coroutine_threw)
+{
+    auto caller = []() -> Async<std::string>
+    {
+        try
+        {
+            co_await failing();
+        }
+        catch (const std::runtime_error &error)
+        {
+            co_return error.what();
+        }
+        co_return "not thrown";
+    };
+
+    EXPECT_EQ(sync_wait(caller()), "failed");
+}
+
+// Tests for the operations outside an event loop
+TEST_F(AsyncTest, sleep_for_should_block_for_duration_when_no_loop_is_running)
+{
+    auto sleeper = []() -> Async<int64_t>
+    {
+        co_return co_await sleep_for(std::chrono::milliseconds(50));
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(sync_wait(sleeper()), 0);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(50));
+}
+
+TEST_F(AsyncTest, wait_readable_should_return_events_when_descriptor_has_data)
+{
+    ASSERT_EQ(write(pipe_fds[1], "x", 1), 1);
+
+    auto waiter = [this]() -> Async<int64_t>
+    {
+        co_return co_await wait_readable(pipe_fds[0], std::chrono::seconds(1));
+    };
+
+    EXPECT_TRUE(sync_wait(waiter()) & POLLIN);
+}
+
+TEST_F(AsyncTest, wait_readable_should_return_zero_when_timeout_passes_first)
+{
+    auto waiter = [this]() -> Async<int64_t>
+    {
+        co_return co_await wait_readable(pipe_fds[0], std::chrono::milliseconds(20));
+    };
+
+    EXPECT_EQ(sync_wait(waiter()), 0);
+}
+
+TEST_F(AsyncTest, read_file_should_read_at_offset_when_file_exists)
+{
+    char path[] = "/tmp/async_read_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(write(fd, "hello async", 11), 11);
+
+    auto reader = [fd]() -> Async<std::string>
+    {
+        char buffer[16];
+        int64_t bytes = co_await read_file(fd, buffer, sizeof(buffer), 6);
+        co_return std::string(buffer, bytes < 0 ? 0 : static_cast<size_t>(bytes));
+    };
+
+    EXPECT_EQ(sync_wait(reader()), "async");
+
+    close(fd);
+    unlink(path);
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "http/bodywriter.hpp"
+#include <stdexcept>
+#include <string>
+
+class BodyWriterTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+    }
+
+    void TearDown() override
+    {
+    }
+};
+
+// Tests for chunked framing
+TEST_F(BodyWriterTest, write_should_frame_each_piece_as_chunk_when_framing_is_chunked)
+{
+    BodyWriter writer(BodyFraming::Chunked);
+
+    writer.write("hello");
+    writer.write(std::string(26, 'z'));
+    writer.finish();
+
+    EXPECT_EQ(writer.take_output(), "5\r\nhello\r\n1a\r\n" + std::string(26, 'z') + "\r\n0\r\n\r\n");
+    EXPECT_TRUE(writer.is_finished());
+}
+
+TEST_F(BodyWriterTest, write_should_skip_empty_piece_when_framing_is_chunked)
+{
+    BodyWriter writer(BodyFraming::Chunked);
+
+    writer.write("");
+
+    EXPECT_EQ(writer.get_output_size(), 0u);
+}
+
+TEST_F(BodyWriterTest, take_output_should_empty_buffer_when_called)
+{
+    BodyWriter writer(BodyFraming::Close);
+
+    writer.write("abc");
+    EXPECT_EQ(writer.take_output(), "abc");
+    EXPECT_EQ(writer.take_output(), "");
+}
+
+// Tests for Content-Length framing
+TEST_F(BodyWriterTest, write_should_pass_bytes_through_when_framing_is_content_length)
+{
+    BodyWriter writer(BodyFraming::ContentLength, 6);
+
+    writer.write("abc");
+    writer.write("def");
+    writer.finish();
+
+    EXPECT_EQ(writer.take_output(), "abcdef");
+}
+
+TEST_F(BodyWriterTest, write_should_throw_length_error_when_body_exceeds_content_length)
+{
+    BodyWriter writer(BodyFraming::ContentLength, 2);
+
+    EXPECT_THROW(writer.write("abc"), std::length_error);
+}
+
+TEST_F(BodyWriterTest, finish_should_throw_length_error_when_body_is_shorter_than_content_length)
+{
+    BodyWriter writer(BodyFraming::ContentLength, 4);
+
+    writer.write("ab");
+
+    EXPECT_THROW(writer.finish(), std::length_error);
+}
+
+// Tests for writes after finish
+TEST_F(BodyWriterTest, write_should_throw_logic_error_when_body_is_finished)
+{
+    BodyWriter writer(BodyFraming::Chunked);
+
+    writer.finish();
+
+    EXPECT_THROW(writer.write("late"), std::logic_error);
+}
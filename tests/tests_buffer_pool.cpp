@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include "server/buffer_pool.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+class BufferPoolTest : public ::testing::Test
+{
+protected:
+    BufferPool pool;
+
+    // Helper method to read a buffer's bytes back as a string
+    static std::string contents(const BufferPool::Buffer &buffer)
+    {
+        return std::string(buffer.data(), buffer.size());
+    }
+};
+
+// Tests for class_of
+TEST_F(BufferPoolTest, class_of_should_return_smallest_class_holding_size_when_size_fits)
+{
+    EXPECT_EQ(BufferPool::class_of(1), 0u);
+    EXPECT_EQ(BufferPool::class_of(4096), 0u);
+    EXPECT_EQ(BufferPool::class_of(4097), 1u);
+    EXPECT_EQ(BufferPool::class_of(64 * 1024), 2u);
+}
+
+TEST_F(BufferPoolTest, class_of_should_return_class_count_when_size_exceeds_largest_class)
+{
+    EXPECT_EQ(BufferPool::class_of(64 * 1024 + 1), BufferPool::class_count);
+}
+
+// Tests for acquire and release
+TEST_F(BufferPoolTest, acquire_should_return_distinct_buffers_when_called_repeatedly)
+{
+    char *first = pool.acquire(0);
+    char *second = pool.acquire(0);
+
+    EXPECT_NE(first, second);
+    EXPECT_GE(static_cast<size_t>(std::abs(second - first)), BufferPool::class_sizes[0]);
+    EXPECT_EQ(pool.get_borrowed_count(), 2u);
+
+    pool.release(first, 0);
+    pool.release(second, 0);
+    EXPECT_EQ(pool.get_borrowed_count(), 0u);
+}
+
+TEST_F(BufferPoolTest, acquire_should_reuse_released_buffer_when_one_is_free)
+{
+    char *buffer = pool.acquire(1);
+    pool.release(buffer, 1);
+
+    EXPECT_EQ(pool.acquire(1), buffer);
+    EXPECT_EQ(pool.get_slab_count(), 1u);
+    pool.release(buffer, 1);
+}
+
+TEST_F(BufferPoolTest, acquire_should_add_slab_when_class_is_exhausted)
+{
+    size_t per_slab = BufferPool::slab_size / BufferPool::class_sizes[2];
+    std::vector<char *> buffers;
+
+    for (size_t i = 0; i < per_slab; ++i)
+        buffers.push_back(pool.acquire(2));
+    EXPECT_EQ(pool.get_slab_count(), 1u);
+
+    buffers.push_back(pool.acquire(2));
+    EXPECT_EQ(pool.get_slab_count(), 2u);
+
+    for (char *buffer : buffers)
+        pool.release(buffer, 2);
+}
+
+TEST_F(BufferPoolTest, acquire_should_return_writable_buffer_when_huge_pages_are_requested)
+{
+    BufferPool huge_pool(true);
+    char *buffer = huge_pool.acquire(0);
+
+    std::memset(buffer, 'h', BufferPool::class_sizes[0]);
+    EXPECT_EQ(buffer[BufferPool::class_sizes[0] - 1], 'h');
+    huge_pool.release(buffer, 0);
+}
+
+// Tests for Buffer
+TEST_F(BufferPoolTest, buffer_should_hold_no_storage_when_nothing_is_reserved)
+{
+    BufferPool::Buffer buffer(&pool);
+
+    EXPECT_EQ(buffer.data(), nullptr);
+    EXPECT_EQ(buffer.capacity(), 0u);
+    EXPECT_EQ(pool.get_borrowed_count(), 0u);
+}
+
+TEST_F(BufferPoolTest, buffer_should_borrow_and_return_storage_when_reserved_then_reset)
+{
+    BufferPool::Buffer buffer(&pool);
+    buffer.append("hello", 5);
+
+    EXPECT_EQ(buffer.capacity(), BufferPool::class_sizes[0]);
+    EXPECT_EQ(pool.get_borrowed_count(), 1u);
+
+    buffer.reset();
+    EXPECT_EQ(buffer.size(), 0u);
+    EXPECT_EQ(pool.get_borrowed_count(), 0u);
+}
+
+TEST_F(BufferPoolTest, buffer_should_keep_contents_when_growing_into_larger_class)
+{
+    BufferPool::Buffer buffer(&pool);
+    std::string first(4000, 'a');
+    std::string second(1000, 'b');
+
+    buffer.append(first.data(), first.size());
+    buffer.append(second.data(), second.size());
+
+    EXPECT_EQ(buffer.capacity(), BufferPool::class_sizes[1]);
+    EXPECT_EQ(contents(buffer), first + second);
+    EXPECT_EQ(pool.get_borrowed_count(), 1u);
+}
+
+TEST_F(BufferPoolTest, buffer_should_fall_back_to_heap_when_larger_than_largest_class)
+{
+    BufferPool::Buffer buffer(&pool);
+    std::string large(100 * 1024, 'l');
+
+    buffer.append(large.data(), large.size());
+
+    EXPECT_EQ(contents(buffer), large);
+    EXPECT_EQ(pool.get_borrowed_count(), 0u);
+}
+
+TEST_F(BufferPoolTest, buffer_should_count_reserved_bytes_when_committed)
+{
+    BufferPool::Buffer buffer(&pool);
+    char *space = buffer.reserve(16);
+
+    std::memcpy(space, "abc", 3);
+    EXPECT_EQ(buffer.size(), 0u);
+
+    buffer.commit(3);
+    EXPECT_EQ(contents(buffer), "abc");
+    EXPECT_EQ(buffer.get_free_space(), BufferPool::class_sizes[0] - 3);
+}
+
+TEST_F(BufferPoolTest, buffer_should_shift_remaining_bytes_when_front_is_erased)
+{
+    BufferPool::Buffer buffer(&pool);
+    buffer.append("consumedkept", 12);
+
+    buffer.erase_front(8);
+
+    EXPECT_EQ(contents(buffer), "kept");
+}
+
+TEST_F(BufferPoolTest, buffer_should_return_storage_once_when_moved)
+{
+    BufferPool::Buffer buffer(&pool);
+    buffer.append("moved", 5);
+
+    {
+        BufferPool::Buffer moved(std::move(buffer));
+        EXPECT_EQ(contents(moved), "moved");
+        EXPECT_EQ(buffer.data(), nullptr);
+    }
+
+    EXPECT_EQ(pool.get_borrowed_count(), 0u);
+}
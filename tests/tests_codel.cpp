@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include "server/codel.hpp"
+#include <chrono>
+
+using namespace std::chrono_literals;
+
+class CoDelTest : public ::testing::Test
+{
+protected:
+    CoDel codel{100ms, 1000ms};
+    CoDel::clock::time_point start = CoDel::clock::now();
+
+    // Helper method to offer an item that waited the given time, at an offset from start
+    bool shouldDrop(CoDel::clock::duration sojourn, CoDel::clock::duration at, size_t remaining = 10)
+    {
+        return codel.should_drop(sojourn, start + at, remaining);
+    }
+};
+
+// Tests for should_drop
+TEST_F(CoDelTest, should_drop_should_keep_items_when_sojourn_is_below_target)
+{
+    for (int i = 0; i < 100; ++i)
+        EXPECT_FALSE(shouldDrop(99ms, i * 100ms));
+
+    EXPECT_FALSE(codel.is_dropping());
+}
+
+TEST_F(CoDelTest, should_drop_should_keep_items_when_sojourn_has_been_above_target_for_less_than_interval)
+{
+    EXPECT_FALSE(shouldDrop(200ms, 0ms));
+    EXPECT_FALSE(shouldDrop(200ms, 500ms));
+    EXPECT_FALSE(shouldDrop(200ms, 999ms));
+    EXPECT_FALSE(codel.is_dropping());
+}
+
+TEST_F(CoDelTest, should_drop_should_drop_item_when_sojourn_stays_above_target_for_interval)
+{
+    EXPECT_FALSE(shouldDrop(200ms, 0ms));
+    EXPECT_TRUE(shouldDrop(200ms, 1000ms));
+    EXPECT_TRUE(codel.is_dropping());
+}
+
+TEST_F(CoDelTest, should_drop_should_drop_faster_when_queue_stays_standing)
+{
+    shouldDrop(200ms, 0ms);
+    ASSERT_TRUE(shouldDrop(200ms, 1000ms));
+
+    // The next drops follow at interval / sqrt(count): 1000ms, then about 707ms and 577ms
+    EXPECT_FALSE(shouldDrop(200ms, 1999ms));
+    EXPECT_TRUE(shouldDrop(200ms, 2000ms));
+    EXPECT_FALSE(shouldDrop(200ms, 2700ms));
+    EXPECT_TRUE(shouldDrop(200ms, 2708ms));
+    EXPECT_FALSE(shouldDrop(200ms, 3280ms));
+    EXPECT_TRUE(shouldDrop(200ms, 3286ms));
+}
+
+TEST_F(CoDelTest, should_drop_should_leave_dropping_state_when_sojourn_falls_below_target)
+{
+    shouldDrop(200ms, 0ms);
+    ASSERT_TRUE(shouldDrop(200ms, 1000ms));
+
+    EXPECT_FALSE(shouldDrop(50ms, 1100ms));
+    EXPECT_FALSE(codel.is_dropping());
+    EXPECT_FALSE(shouldDrop(200ms, 2000ms));
+}
+
+TEST_F(CoDelTest, should_drop_should_keep_item_when_queue_is_empty_behind_it)
+{
+    shouldDrop(200ms, 0ms);
+    EXPECT_FALSE(shouldDrop(200ms, 1000ms, 0));
+    EXPECT_FALSE(shouldDrop(200ms, 2000ms, 0));
+    EXPECT_FALSE(codel.is_dropping());
+}
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "server/cpu_topology.hpp"
+#include <stdexcept>
+
+class CpuTopologyTest : public ::testing::Test
+{
+protected:
+    ThreadTopology topology;
+    CpuSet allowed = {0, 1, 2, 3, 4, 5, 6, 7};
+
+    // Helper method to plan with the fixture's topology and eight allowed CPUs
+    ThreadPlacement plan(size_t io_threads, bool steer_shards = false)
+    {
+        return plan_thread_placement(topology, io_threads, steer_shards, allowed);
+    }
+};
+
+// Tests for parse_cpu_list and format_cpu_list
+TEST_F(CpuTopologyTest, parse_cpu_list_should_expand_ranges_when_list_mixes_ranges_and_cpus)
+{
+    EXPECT_EQ(parse_cpu_list("0-3,8,10-11"), (CpuSet{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(parse_cpu_list("5,1,1-2"), (CpuSet{1, 2, 5}));
+}
+
+TEST_F(CpuTopologyTest, parse_cpu_list_should_throw_when_list_is_malformed)
+{
+    EXPECT_THROW(parse_cpu_list(""), std::invalid_argument);
+    EXPECT_THROW(parse_cpu_list("a"), std::invalid_argument);
+    EXPECT_THROW(parse_cpu_list("3-1"), std::invalid_argument);
+    EXPECT_THROW(parse_cpu_list("1-2x"), std::invalid_argument);
+    EXPECT_THROW(parse_cpu_list("-1"), std::invalid_argument);
+}
+
+TEST_F(CpuTopologyTest, parse_cpu_sets_should_return_one_set_per_list_when_separated_by_semicolons)
+{
+    EXPECT_EQ(parse_cpu_sets("0-1;2;4-5"), (std::vector<CpuSet>{{0, 1}, {2}, {4, 5}}));
+    EXPECT_THROW(parse_cpu_sets("0;;1"), std::invalid_argument);
+}
+
+TEST_F(CpuTopologyTest, format_cpu_list_should_collapse_consecutive_cpus_into_ranges)
+{
+    EXPECT_EQ(format_cpu_list({0, 1, 2, 3, 8, 10, 11}), "0-3,8,10-11");
+    EXPECT_EQ(format_cpu_list({4}), "4");
+    EXPECT_EQ(format_cpu_list({}), "");
+}
+
+// Tests for get_allowed_cpus
+TEST_F(CpuTopologyTest, get_allowed_cpus_should_return_at_least_one_cpu)
+{
+    EXPECT_FALSE(get_allowed_cpus().empty());
+}
+
+// Tests for plan_thread_placement
+TEST_F(CpuTopologyTest, plan_thread_placement_should_leave_threads_unpinned_when_topology_is_default)
+{
+    ThreadPlacement placement = plan(2);
+
+    EXPECT_EQ(placement.io_cpus, (std::vector<CpuSet>{{}, {}}));
+    EXPECT_EQ(placement.get_worker_count(), 8u);
+    for (const CpuSet &cpus : placement.worker_cpus)
+        EXPECT_TRUE(cpus.empty());
+}
+
+TEST_F(CpuTopologyTest, plan_thread_placement_should_give_each_worker_one_cpu_when_pinning_workers)
+{
+    topology.workers = 10;
+    topology.pin_workers = true;
+
+    ThreadPlacement placement = plan(0);
+
+    ASSERT_EQ(placement.get_worker_count(), 10u);
+    EXPECT_EQ(placement.worker_cpus[0], CpuSet{0});
+    EXPECT_EQ(placement.worker_cpus[7], CpuSet{7});
+    EXPECT_EQ(placement.worker_cpus[8], CpuSet{0});
+}
+
+TEST_F(CpuTopologyTest, plan_thread_placement_should_keep_workers_off_io_cpus_when_isolating_io_threads)
+{
+    topology.isolate_io_threads = true;
+
+    ThreadPlacement placement = plan(2);
+
+    EXPECT_EQ(placement.io_cpus, (std::vector<CpuSet>{{0}, {1}}));
+    ASSERT_EQ(placement.get_worker_count(), 6u);
+    for (const CpuSet &cpus : placement.worker_cpus)
+        EXPECT_EQ(cpus, (CpuSet{2, 3, 4, 5, 6, 7}));
+    EXPECT_FALSE(placement.isolation_failed);
+}
+
+TEST_F(CpuTopologyTest, plan_thread_placement_should_isolate_around_explicit_io_cpus_when_pinning_workers)
+{
+    topology.io_cpus = {{6, 7}};
+    topology.isolate_io_threads = true;
+    topology.pin_workers = true;
+
+    ThreadPlacement placement = plan(2);
+
+    EXPECT_EQ(placement.io_cpus, (std::vector<CpuSet>{{6, 7}, {6, 7}}));
+    ASSERT_EQ(placement.get_worker_count(), 6u);
+    EXPECT_EQ(placement.worker_cpus.front(), CpuSet{0});
+    EXPECT_EQ(placement.worker_cpus.back(), CpuSet{5});
+}
+
+TEST_F(CpuTopologyTest, plan_thread_placement_should_use_explicit_worker_sets_when_given)
+{
+    topology.workers = 4;
+    topology.worker_cpus = {{0, 1}, {2, 3}};
+    topology.isolate_io_threads = true;
+
+    ThreadPlacement placement = plan(1);
+
+    EXPECT_EQ(placement.worker_cpus, (std::vector<CpuSet>{{0, 1}, {2, 3}, {0, 1}, {2, 3}}));
+}
+
+TEST_F(CpuTopologyTest, plan_thread_placement_should_pin_io_thread_to_its_shard_cpu_when_steering_shards)
+{
+    ThreadPlacement placement = plan(1, true);
+
+    EXPECT_EQ(placement.io_cpus, (std::vector<CpuSet>{{0}}));
+}
+
+TEST_F(CpuTopologyTest, plan_thread_placement_should_report_failure_when_isolation_leaves_no_cpu)
+{
+    allowed = {0};
+    topology.isolate_io_threads = true;
+
+    ThreadPlacement placement = plan(1);
+
+    EXPECT_TRUE(placement.isolation_failed);
+    EXPECT_EQ(placement.worker_cpus, (std::vector<CpuSet>{{}}));
+}
+
+// Tests for format_thread_placement
+TEST_F(CpuTopologyTest, format_thread_placement_should_group_threads_with_the_same_cpus)
+{
+    ThreadPlacement placement;
+    placement.io_cpus = {{0}};
+    placement.worker_cpus = {{2, 3}, {2, 3}, {}};
+
+    std::string report = format_thread_placement(placement);
+
+    EXPECT_THAT(report, ::testing::HasSubstr("1 I/O thread(s), 3 worker(s)"));
+    EXPECT_THAT(report, ::testing::HasSubstr("I/O thread 0: CPU 0"));
+    EXPECT_THAT(report, ::testing::HasSubstr("workers 0-1: CPUs 2-3"));
+    EXPECT_THAT(report, ::testing::HasSubstr("worker 2: unpinned"));
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include "server/event_count.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+class EventCountTest : public ::testing::Test
+{
+protected:
+    EventCount events;
+    std::atomic<bool> ready{false};
+
+    // Helper method to wait the way a queue consumer does, until ready is set
+    void waitUntilReady()
+    {
+        while (!ready)
+        {
+            uint32_t epoch = events.prepare_wait();
+
+            if (ready)
+            {
+                events.cancel_wait();
+                return;
+            }
+
+            events.wait(epoch);
+        }
+    }
+};
+
+// Tests for wait and notify
+TEST_F(EventCountTest, wait_should_return_at_once_when_notified_after_prepare_wait)
+{
+    uint32_t epoch = events.prepare_wait();
+    events.notify_one();
+
+    auto start = std::chrono::steady_clock::now();
+    events.wait(epoch);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+}
+
+TEST_F(EventCountTest, notify_one_should_wake_parked_waiter_when_condition_becomes_true)
+{
+    std::thread waiter([this]
+                       { waitUntilReady(); });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ready = true;
+    events.notify_one();
+
+    waiter.join();
+    EXPECT_TRUE(ready);
+}
+
+TEST_F(EventCountTest, notify_all_should_wake_every_parked_waiter_when_called)
+{
+    std::thread first([this]
+                      { waitUntilReady(); });
+    std::thread second([this]
+                       { waitUntilReady(); });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ready = true;
+    events.notify_all();
+
+    first.join();
+    second.join();
+}
@@ -381,6 +381,29 @@ TEST_F(HttpRequestTest, getters_should_work_on_const_objects_when_called_on_cons
     EXPECT_EQ("test body", request.get_body());
 }
 
+// Tests for header lookup and keep-alive detection
+TEST_F(HttpRequestTest, get_header_should_ignore_case_when_looking_up_header)
+{
+    HttpRequest request = HttpRequest::from_string("GET / HTTP/1.1\r\ncontent-type: text/plain\r\n\r\n");
+
+    EXPECT_EQ(request.get_header("Content-Type"), "text/plain");
+    EXPECT_TRUE(request.has_header("CONTENT-TYPE"));
+    EXPECT_EQ(request.get_header("Accept"), "");
+}
+
+TEST_F(HttpRequestTest, is_keep_alive_should_default_by_version_when_connection_header_is_missing)
+{
+    EXPECT_TRUE(HttpRequest::from_string("GET / HTTP/1.1\r\n\r\n").is_keep_alive());
+    EXPECT_FALSE(HttpRequest::from_string("GET / HTTP/1.0\r\n\r\n").is_keep_alive());
+}
+
+TEST_F(HttpRequestTest, is_keep_alive_should_follow_connection_header_when_present)
+{
+    EXPECT_FALSE(HttpRequest::from_string("GET / HTTP/1.1\r\nConnection: close\r\n\r\n").is_keep_alive());
+    EXPECT_TRUE(HttpRequest::from_string("GET / HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n").is_keep_alive());
+    EXPECT_FALSE(HttpRequest::from_string("GET / HTTP/1.1\r\nconnection: Upgrade, close\r\n\r\n").is_keep_alive());
+}
+
 // Integration test for complete request parsing
 TEST_F(HttpRequestTest, from_string_should_parse_complete_realistic_request_when_given_full_HTTP_request)
 {
@@ -0,0 +1,365 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "http/httprequestparser.hpp"
+#include "http/httpmethod.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+class HttpRequestParserTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+    }
+
+    void TearDown() override
+    {
+    }
+
+    // Helper method to feed a whole string and return the final status
+    ParseStatus feedAll(HttpRequestParser &parser, const std::string &data, size_t &consumed_total)
+    {
+        ParseStatus status = ParseStatus::NeedMore;
+        consumed_total = 0;
+
+        while (consumed_total < data.size() || status == ParseStatus::HeadersComplete)
+        {
+            size_t consumed;
+            status = parser.feed(data.data() + consumed_total, data.size() - consumed_total, consumed);
+            consumed_total += consumed;
+
+            if (status == ParseStatus::MessageComplete)
+                break;
+        }
+
+        return status;
+    }
+};
+
+// Tests for complete messages
+TEST_F(HttpRequestParserTest, feed_should_complete_message_when_given_request_without_body)
+{
+    HttpRequestParser parser;
+    size_t consumed;
+
+    std::string raw = "GET /index.html HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    EXPECT_EQ(parser.feed(raw.data(), raw.size(), consumed), ParseStatus::MessageComplete);
+    EXPECT_EQ(consumed, raw.size());
+
+    HttpRequest request = parser.take_request();
+    EXPECT_EQ(request.get_method(), HttpMethod::GET);
+    EXPECT_EQ(request.get_uri(), "/index.html");
+    EXPECT_EQ(request.get_version(), "HTTP/1.1");
+    EXPECT_EQ(request.get_header("Host"), "localhost");
+}
+
+TEST_F(HttpRequestParserTest, feed_should_report_headers_complete_when_body_follows)
+{
+    HttpRequestParser parser;
+    size_t consumed;
+
+    std::string head = "POST /submit HTTP/1.1\r\nContent-Length: 4\r\n\r\n";
+    std::string raw = head + "data";
+
+    EXPECT_EQ(parser.feed(raw.data(), raw.size(), consumed), ParseStatus::HeadersComplete);
+    EXPECT_EQ(consumed, head.size());
+    EXPECT_EQ(parser.get_content_length(), 4u);
+
+    EXPECT_EQ(parser.feed(raw.data() + consumed, raw.size() - consumed, consumed), ParseStatus::MessageComplete);
+    EXPECT_EQ(parser.take_request().get_body(), "data");
+}
+
+// Tests for chunked input
+TEST_F(HttpRequestParserTest, feed_should_parse_request_when_fed_one_byte_at_a_time)
+{
+    HttpRequestParser parser;
+    std::string raw = "POST /echo HTTP/1.1\r\nX-Test: value\r\nContent-Length: 11\r\n\r\nhello world";
+    ParseStatus status = ParseStatus::NeedMore;
+
+    for (size_t i = 0; i < raw.size(); ++i)
+    {
+        size_t consumed;
+        status = parser.feed(raw.data() + i, 1, consumed);
+        EXPECT_EQ(consumed, 1u);
+    }
+
+    ASSERT_EQ(status, ParseStatus::MessageComplete);
+
+    HttpRequest request = parser.take_request();
+    EXPECT_EQ(request.get_header("X-Test"), "value");
+    EXPECT_EQ(request.get_body(), "hello world");
+}
+
+TEST_F(HttpRequestParserTest, feed_should_assemble_body_when_body_spans_many_chunks)
+{
+    HttpRequestParser parser;
+    std::string body(100 * 1024, 'b');
+    std::string raw = "POST /upload HTTP/1.1\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+    ParseStatus status = ParseStatus::NeedMore;
+
+    for (size_t offset = 0; offset < raw.size(); offset += 4096)
+    {
+        size_t length = std::min<size_t>(4096, raw.size() - offset);
+        size_t consumed = 0;
+
+        while (consumed < length)
+        {
+            size_t step;
+            status = parser.feed(raw.data() + offset + consumed, length - consumed, step);
+            consumed += step;
+        }
+    }
+
+    ASSERT_EQ(status, ParseStatus::MessageComplete);
+    EXPECT_EQ(parser.take_request().get_body(), body);
+}
+
+TEST_F(HttpRequestParserTest, feed_should_stop_at_message_end_when_requests_are_pipelined)
+{
+    HttpRequestParser parser;
+    std::string first = "POST /a HTTP/1.1\r\nContent-Length: 3\r\n\r\nabc";
+    std::string second = "GET /b HTTP/1.1\r\n\r\n";
+    std::string raw = first + second;
+    size_t consumed;
+
+    EXPECT_EQ(feedAll(parser, raw, consumed), ParseStatus::MessageComplete);
+    EXPECT_EQ(consumed, first.size());
+    EXPECT_EQ(parser.take_request().get_uri(), "/a");
+
+    EXPECT_EQ(feedAll(parser, raw.substr(consumed), consumed), ParseStatus::MessageComplete);
+    EXPECT_EQ(parser.take_request().get_uri(), "/b");
+}
+
+TEST_F(HttpRequestParserTest, feed_should_skip_empty_lines_when_they_precede_request_line)
+{
+    HttpRequestParser parser;
+    size_t consumed;
+
+    EXPECT_EQ(feedAll(parser, "\r\n\r\nGET / HTTP/1.1\r\n\r\n", consumed), ParseStatus::MessageComplete);
+    EXPECT_EQ(parser.take_request().get_uri(), "/");
+}
+
+// Tests for state queries and reset
+TEST_F(HttpRequestParserTest, is_idle_should_return_false_when_request_is_partially_parsed)
+{
+    HttpRequestParser parser;
+    size_t consumed;
+
+    EXPECT_TRUE(parser.is_idle());
+
+    std::string partial = "GET / HT";
+    parser.feed(partial.data(), partial.size(), consumed);
+    EXPECT_FALSE(parser.is_idle());
+
+    parser.reset();
+    EXPECT_TRUE(parser.is_idle());
+}
+
+TEST_F(HttpRequestParserTest, is_reading_body_should_return_true_when_headers_are_complete_and_body_is_not)
+{
+    HttpRequestParser parser;
+    size_t consumed;
+
+    std::string headers = "POST / HTTP/1.1\r\nContent-Length: 4\r\n";
+    parser.feed(headers.data(), headers.size(), consumed);
+    EXPECT_FALSE(parser.is_reading_body());
+
+    std::string end = "\r\n";
+    parser.feed(end.data(), end.size(), consumed);
+    EXPECT_TRUE(parser.is_reading_body());
+
+    std::string body = "abcd";
+    parser.feed(body.data(), body.size(), consumed);
+    EXPECT_TRUE(parser.is_complete());
+    EXPECT_FALSE(parser.is_reading_body());
+}
+
+// Tests for error conditions
+TEST_F(HttpRequestParserTest, feed_should_throw_exception_when_given_invalid_HTTP_method)
+{
+    HttpRequestParser parser;
+    size_t consumed;
+    std::string raw = "BOGUS / HTTP/1.1\r\n\r\n";
+
+    EXPECT_THROW(parser.feed(raw.data(), raw.size(), consumed), std::invalid_argument);
+}
+
+TEST_F(HttpRequestParserTest, feed_should_throw_exception_when_content_length_is_not_a_number)
+{
+    HttpRequestParser parser;
+    size_t consumed;
+    std::string raw = "POST / HTTP/1.1\r\nContent-Length: -5\r\n\r\n";
+
+    EXPECT_THROW(parser.feed(raw.data(), raw.size(), consumed), std::invalid_argument);
+}
+
+TEST_F(HttpRequestParserTest, feed_should_throw_exception_when_content_length_values_differ)
+{
+    HttpRequestParser parser;
+    size_t consumed;
+    std::string raw = "POST / HTTP/1.1\r\nContent-Length: 3\r\nContent-Length: 30\r\n\r\nabc";
+
+    EXPECT_THROW(feedAll(parser, raw, consumed), std::invalid_argument);
+}
+
+TEST_F(HttpRequestParserTest, feed_should_accept_repeated_content_length_when_values_match)
+{
+    HttpRequestParser parser;
+    size_t consumed;
+    std::string raw = "POST / HTTP/1.1\r\nContent-Length: 3\r\ncontent-length: 3\r\n\r\nabc";
+
+    EXPECT_EQ(feedAll(parser, raw, consumed), ParseStatus::MessageComplete);
+    EXPECT_EQ(parser.get_content_length(), 3u);
+    EXPECT_EQ(parser.take_request().get_body(), "abc");
+}
+
+TEST_F(HttpRequestParserTest, feed_should_throw_length_error_when_headers_exceed_limit)
+{
+    HttpRequestParser parser(1024, 1024);
+    size_t consumed;
+
+    std::string headers = "GET / HTTP/1.1\r\nX-Large: " + std::string(2048, 'x') + "\r\n\r\n";
+    EXPECT_THROW(parser.feed(headers.data(), headers.size(), consumed), std::length_error);
+}
+
+TEST_F(HttpRequestParserTest, feed_should_throw_length_error_when_body_exceeds_limit)
+{
+    HttpRequestParser parser(1024, 1024);
+    size_t consumed;
+
+    EXPECT_THROW(feedAll(parser, "POST / HTTP/1.1\r\nContent-Length: 4096\r\n\r\nx", consumed), std::length_error);
+
+    parser.reset();
+    std::string chunked = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n800\r\n" + std::string(2048, 'x');
+    EXPECT_THROW(feedAll(parser, chunked, consumed), std::length_error);
+}
+
+// Tests for chunked transfer encoding
+TEST_F(HttpRequestParserTest, feed_should_decode_body_when_transfer_encoding_is_chunked)
+{
+    HttpRequestParser parser;
+    size_t consumed;
+
+    std::string raw = "POST /upload HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+                      "5\r\nhello\r\n"
+                      "6;ext=1\r\n world\r\n"
+                      "0\r\n\r\n";
+
+    EXPECT_EQ(feedAll(parser, raw, consumed), ParseStatus::MessageComplete);
+    EXPECT_EQ(consumed, raw.size());
+    EXPECT_TRUE(parser.is_chunked());
+    EXPECT_EQ(parser.take_request().get_body(), "hello world");
+}
+
+TEST_F(HttpRequestParserTest, feed_should_decode_chunked_body_when_fed_one_byte_at_a_time)
+{
+    HttpRequestParser parser;
+    std::string raw = "POST /upload HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+                      "A\r\n0123456789\r\n0\r\n\r\n";
+    ParseStatus status = ParseStatus::NeedMore;
+
+    for (size_t i = 0; i < raw.size(); ++i)
+    {
+        size_t consumed;
+        status = parser.feed(raw.data() + i, 1, consumed);
+
+        if (status == ParseStatus::HeadersComplete && consumed == 0)
+            status = parser.feed(raw.data() + i, 1, consumed);
+    }
+
+    ASSERT_EQ(status, ParseStatus::MessageComplete);
+    EXPECT_EQ(parser.take_request().get_body(), "0123456789");
+}
+
+TEST_F(HttpRequestParserTest, feed_should_add_trailers_when_chunked_body_has_trailer_fields)
+{
+    HttpRequestParser parser;
+    size_t consumed;
+
+    std::string raw = "POST /upload HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+                      "3\r\nabc\r\n0\r\nX-Checksum: 42\r\nContent-Length: 999\r\n\r\n";
+
+    EXPECT_EQ(feedAll(parser, raw, consumed), ParseStatus::MessageComplete);
+
+    HttpRequest request = parser.take_request();
+    EXPECT_EQ(request.get_body(), "abc");
+    EXPECT_EQ(request.get_header("X-Checksum"), "42");
+    EXPECT_FALSE(request.has_header("Content-Length"));
+}
+
+TEST_F(HttpRequestParserTest, feed_should_stream_body_to_sink_when_sink_is_set)
+{
+    HttpRequestParser parser(1024, 4);
+    std::string received;
+    size_t chunks = 0;
+
+    std::string head = "POST /upload HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n";
+    size_t consumed;
+    ASSERT_EQ(parser.feed(head.data(), head.size(), consumed), ParseStatus::HeadersComplete);
+
+    parser.set_body_sink([&](const char *data, size_t length)
+                         {
+                             received.append(data, length);
+                             ++chunks; });
+
+    EXPECT_EQ(feedAll(parser, "8\r\nstreamed\r\n", consumed), ParseStatus::NeedMore);
+    EXPECT_EQ(received, "streamed");
+    EXPECT_EQ(feedAll(parser, "5\r\n body\r\n0\r\n\r\n", consumed), ParseStatus::MessageComplete);
+
+    EXPECT_EQ(received, "streamed body");
+    EXPECT_EQ(chunks, 2u);
+    EXPECT_EQ(parser.take_request().get_body(), "");
+}
+
+TEST_F(HttpRequestParserTest, feed_should_throw_length_error_when_streamed_body_exceeds_streamed_limit)
+{
+    HttpRequestParser parser(1024, 4, 16);
+    std::string received;
+    auto sink = [&](const char *data, size_t length)
+    { received.append(data, length); };
+    size_t consumed;
+
+    std::string head = "POST /upload HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n";
+    ASSERT_EQ(parser.feed(head.data(), head.size(), consumed), ParseStatus::HeadersComplete);
+    parser.set_body_sink(sink);
+
+    EXPECT_EQ(feedAll(parser, "10\r\n0123456789abcdef\r\n", consumed), ParseStatus::NeedMore);
+    EXPECT_THROW(feedAll(parser, "1\r\nx\r\n", consumed), std::length_error);
+    EXPECT_EQ(received, "0123456789abcdef");
+
+    // Within the buffered limit, so only the sink's limit rejects it
+    HttpRequestParser buffered_larger(1024, 32, 16);
+    head = "POST /upload HTTP/1.1\r\nContent-Length: 20\r\n\r\n";
+    ASSERT_EQ(buffered_larger.feed(head.data(), head.size(), consumed), ParseStatus::HeadersComplete);
+    buffered_larger.set_body_sink(sink);
+
+    EXPECT_THROW(feedAll(buffered_larger, "x", consumed), std::length_error);
+}
+
+TEST_F(HttpRequestParserTest, feed_should_throw_length_error_at_headers_when_content_length_exceeds_every_limit)
+{
+    HttpRequestParser parser(1024, 4, 16);
+    size_t consumed;
+    std::string head = "POST /upload HTTP/1.1\r\nContent-Length: 17\r\n\r\n";
+
+    EXPECT_THROW(parser.feed(head.data(), head.size(), consumed), std::length_error);
+}
+
+TEST_F(HttpRequestParserTest, feed_should_throw_exception_when_chunk_size_is_invalid)
+{
+    HttpRequestParser parser;
+    size_t consumed;
+
+    std::string raw = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n";
+    EXPECT_THROW(feedAll(parser, raw, consumed), std::invalid_argument);
+}
+
+TEST_F(HttpRequestParserTest, feed_should_throw_exception_when_both_framings_are_present)
+{
+    HttpRequestParser parser;
+    size_t consumed;
+
+    std::string raw = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\nContent-Length: 3\r\n\r\n";
+    EXPECT_THROW(feedAll(parser, raw, consumed), std::invalid_argument);
+}
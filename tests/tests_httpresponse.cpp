@@ -599,3 +599,39 @@ TEST_F(HttpResponseTest, from_string_should_handle_headers_with_special_characte
     EXPECT_EQ("value with spaces, commas; and semicolons", headers.at("Custom-Header"));
     EXPECT_EQ("body content", response.get_body());
 }
+
+// Tests for head_to_string and take_body
+TEST_F(HttpResponseTest, head_to_string_should_end_with_blank_line_when_response_has_body)
+{
+    HttpResponse response;
+    response.set_code(HttpCode::NotFound);
+    response.add_header("Content-Length", "4");
+    response.set_body("gone");
+
+    EXPECT_EQ(response.head_to_string(), "HTTP/1.1 404 Not Found\r\nContent-Length: 4\r\n\r\n");
+    EXPECT_EQ(response.to_string(), response.head_to_string() + "gone");
+}
+
+TEST_F(HttpResponseTest, write_head_should_fill_exactly_head_size_when_called)
+{
+    HttpResponse response;
+    response.set_code(HttpCode::ServiceUnavailable);
+    response.add_header("Retry-After", "1");
+    response.add_header("Content-Length", "0");
+
+    std::string head(response.get_head_size(), '\0');
+    char *end = response.write_head(head.data());
+
+    EXPECT_EQ(end, head.data() + head.size());
+    EXPECT_EQ(head, response.head_to_string());
+    EXPECT_EQ(head, "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nRetry-After: 1\r\n\r\n");
+}
+
+TEST_F(HttpResponseTest, take_body_should_leave_empty_body_when_called)
+{
+    HttpResponse response;
+    response.set_body(std::string(1024, 'b'));
+
+    EXPECT_EQ(response.take_body(), std::string(1024, 'b'));
+    EXPECT_EQ(response.get_body(), "");
+}
@@ -0,0 +1,1824 @@
+#ifdef __linux__
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "server/httpserver.hpp"
+#include "server/listen_fds.hpp"
+#include "server/async_io.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+class HttpServerTest : public ::testing::Test
+{
+protected:
+    void TearDown() override
+    {
+        release_handlers = true;
+        stopServer();
+
+        if (!web_root.empty())
+            std::filesystem::remove_all(web_root);
+    }
+
+    // Two I/O threads by default so every test exercises more than one loop
+    static ServerConfig testConfig()
+    {
+        ServerConfig config;
+        config.io_threads = 2;
+        return config;
+    }
+
+    void startServer(IoBackend backend, ServerConfig config = testConfig())
+    {
+        server = std::make_unique<HttpServer>();
+
+        Router router;
+        router.get("/hello", [](const HttpRequest &) -> HttpResponse
+                   {
+                       HttpResponse response;
+                       response.add_header("Content-Type", "text/plain");
+                       response.set_body("Hello");
+                       return response; });
+        router.post("/echo", [](const HttpRequest &request) -> HttpResponse
+                    {
+                        HttpResponse response;
+                        response.add_header("Content-Type", "text/plain");
+                        response.set_body(request.get_body());
+                        return response; });
+        router.get("/large", [](const HttpRequest &) -> HttpResponse
+                   {
+                       HttpResponse response;
+                       response.add_header("Content-Type", "text/plain");
+                       response.set_body(std::string(300 * 1024, 'x'));
+                       return response; });
+        router.add_streaming_route(
+            HttpMethod::POST, "/upload",
+            [this](const HttpRequest &) -> BodySink
+            { return [this](const char *, size_t length)
+              { streamed_bytes += length; }; },
+            [this](const HttpRequest &request) -> HttpResponse
+            {
+                HttpResponse response;
+                response.set_body(std::to_string(streamed_bytes.load()) + " " + std::to_string(request.get_body().size()));
+                return response; });
+        router.get("/static/.+", [this](const HttpRequest &request) -> HttpResponse
+                   { return server->serve_static_file(request.get_uri().substr(8), web_root.string()); });
+        router.get("/stream", [](const HttpRequest &) -> HttpResponse
+                   {
+                       HttpResponse response;
+                       response.add_header("Content-Type", "text/plain");
+                       response.set_body_stream([piece = 0](BodyWriter &writer) mutable
+                                                {
+                                                    writer.write(std::string(64 * 1024, static_cast<char>('a' + piece)));
+                                                    return ++piece < 4; });
+                       return response; });
+        router.get("/slow", [](const HttpRequest &) -> HttpResponse
+                   {
+                       std::this_thread::sleep_for(std::chrono::milliseconds(300));
+                       HttpResponse response;
+                       response.set_body("Slow");
+                       return response; });
+        router.get("/block", [this](const HttpRequest &) -> HttpResponse
+                   {
+                       ++blocked_handlers;
+                       while (!release_handlers)
+                           std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                       HttpResponse response;
+                       response.set_body("Released");
+                       return response; });
+        router.get("/block-io", [this](const HttpRequest &) -> HttpResponse
+                   {
+                       ++blocked_io_handlers;
+                       while (!release_handlers)
+                           std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                       HttpResponse response;
+                       response.set_body("Released");
+                       return response; }, ExecutionPolicy::Blocking);
+        router.get("/inline", [](const HttpRequest &) -> HttpResponse
+                   {
+                       HttpResponse response;
+                       response.set_body("Inline");
+                       return response; }, ExecutionPolicy::Inline);
+        router.get("/endless", [](const HttpRequest &) -> HttpResponse
+                   {
+                       HttpResponse response;
+                       response.set_body_stream([](BodyWriter &writer)
+                                                {
+                                                    writer.write(std::string(64 * 1024, 'e'));
+                                                    return true; });
+                       return response; });
+        router.get("/stream-sized", [](const HttpRequest &) -> HttpResponse
+                   {
+                       HttpResponse response;
+                       response.add_header("Content-Length", "10");
+                       response.set_body_stream([piece = 0](BodyWriter &writer) mutable
+                                                {
+                                                    writer.write("01234");
+                                                    return ++piece < 2; });
+                       return response; });
+        router.get("/async-sleep", [](const HttpRequest &) -> Async<HttpResponse>
+                   {
+                       co_await sleep_for(std::chrono::milliseconds(250));
+                       HttpResponse response;
+                       response.set_body("Awake");
+                       co_return response; });
+        router.get("/async-poll", [](const HttpRequest &) -> Async<HttpResponse>
+                   {
+                       int fds[2];
+                       if (pipe(fds) != 0)
+                           throw std::runtime_error("pipe");
+                       int64_t timed_out = co_await wait_readable(fds[0], std::chrono::milliseconds(50));
+                       if (write(fds[1], "x", 1) != 1)
+                           throw std::runtime_error("write");
+                       int64_t ready = co_await wait_readable(fds[0], std::chrono::seconds(5));
+                       close(fds[0]);
+                       close(fds[1]);
+                       HttpResponse response;
+                       response.set_body(std::to_string(timed_out) + " " + std::to_string((ready & POLLIN) != 0));
+                       co_return response; });
+        router.get("/async-static/.+", [this](const HttpRequest &request) -> Async<HttpResponse>
+                   {
+                       int fd = open((web_root / request.get_uri().substr(14)).c_str(), O_RDONLY);
+                       std::string content(64 * 1024, '\0');
+                       int64_t bytes = co_await read_file(fd, content.data(), content.size(), 0);
+                       close(fd);
+                       content.resize(bytes < 0 ? 0 : static_cast<size_t>(bytes));
+                       HttpResponse response;
+                       response.set_body(content);
+                       co_return response; });
+        server->set_router(router);
+
+        config.backend = backend;
+        server->set_config(config);
+
+        server_thread = std::thread([this]
+                                    { server->run(0, 128); });
+
+        while (!server->is_running())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    void stopServer()
+    {
+        if (!server)
+            return;
+
+        server->stop();
+        if (server_thread.joinable())
+            server_thread.join();
+        server.reset();
+    }
+
+    // Helper method to create a file under a temporary web root served at /static/<name>
+    void writeStaticFile(const std::string &name, const std::string &content)
+    {
+        if (web_root.empty())
+        {
+            web_root = std::filesystem::temp_directory_path() / ("http-server-tests-" + std::to_string(getpid()));
+            std::filesystem::create_directories(web_root);
+        }
+
+        std::ofstream file(web_root / name, std::ios::binary);
+        file << content;
+    }
+
+    // Expects a file larger than the socket buffers to arrive intact, followed by a pipelined response
+    void expectStaticFileResponse()
+    {
+        std::string content;
+        for (size_t i = 0; i < 3 * 1024 * 1024; ++i)
+            content += static_cast<char>('a' + i % 26);
+        writeStaticFile("large.txt", content);
+
+        int fd = connectClient();
+        ASSERT_GE(fd, 0);
+
+        std::string requests = "GET /static/large.txt HTTP/1.1\r\n\r\nGET /hello HTTP/1.1\r\n\r\n";
+        send(fd, requests.data(), requests.size(), MSG_NOSIGNAL);
+
+        HttpResponse response = HttpResponse::from_string(readResponse(fd));
+        EXPECT_EQ(response.get_header("Content-Length"), std::to_string(content.size()));
+        EXPECT_EQ(response.get_header("Content-Type"), "text/plain");
+        EXPECT_TRUE(response.get_body() == content);
+        EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), "Hello");
+
+        close(fd);
+    }
+
+    // Pipelines responses far beyond a small output high-water mark, with a file
+    // body among them, and expects every one of them in order
+    void expectPipelinedResponsesBeyondHighWaterMark(IoBackend backend)
+    {
+        ServerConfig config = testConfig();
+        config.output_high_water_mark = 1024;
+        startServer(backend, config);
+        writeStaticFile("pipelined.txt", std::string(64 * 1024, 'p'));
+
+        int fd = connectClient();
+        ASSERT_GE(fd, 0);
+
+        std::string requests = "GET /large HTTP/1.1\r\n\r\n"
+                               "GET /hello HTTP/1.1\r\n\r\n"
+                               "GET /static/pipelined.txt HTTP/1.1\r\n\r\n"
+                               "POST /echo HTTP/1.1\r\nContent-Length: 4\r\n\r\necho"
+                               "GET /large HTTP/1.1\r\n\r\n"
+                               "GET /hello HTTP/1.1\r\n\r\n";
+        send(fd, requests.data(), requests.size(), MSG_NOSIGNAL);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body().size(), 300u * 1024);
+        EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), "Hello");
+        EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), std::string(64 * 1024, 'p'));
+        EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), "echo");
+        EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body().size(), 300u * 1024);
+        EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), "Hello");
+
+        close(fd);
+    }
+
+    // Resets a client in the middle of a large file body, then expects the server
+    // to survive the failed write and keep serving
+    void expectClientResetDuringFileBody()
+    {
+        writeStaticFile("reset.txt", std::string(16 * 1024 * 1024, 'r'));
+
+        for (int i = 0; i < 3; ++i)
+        {
+            int fd = connectClient();
+            ASSERT_GE(fd, 0);
+
+            std::string request = "GET /static/reset.txt HTTP/1.1\r\n\r\n";
+            send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+
+            char buffer[4096];
+            ASSERT_GT(recv(fd, buffer, sizeof(buffer), 0), 0);
+
+            linger reset{1, 0};
+            setsockopt(fd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+            close(fd);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        EXPECT_EQ(HttpResponse::from_string(exchange("GET /hello HTTP/1.1\r\nConnection: close\r\n\r\n")).get_body(), "Hello");
+    }
+
+    // Sends request bodies that together outgrow the io_uring receive buffers,
+    // so each buffer has to go back to the kernel and be used again
+    void expectLargeBodiesEchoed(bool buffer_ring)
+    {
+        ServerConfig config = testConfig();
+        config.io_uring_buffer_ring = buffer_ring;
+        startServer(IoBackend::IoUring, config);
+
+        for (char fill : {'a', 'b', 'c', 'd'})
+        {
+            std::string body(800 * 1024, fill);
+            HttpResponse response = HttpResponse::from_string(
+                exchange("POST /echo HTTP/1.1\r\nConnection: close\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body));
+
+            EXPECT_EQ(response.get_body(), body);
+        }
+    }
+
+    // Helper method to open a client connection to the running server
+    int connectClient()
+    {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(server->get_port());
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+        {
+            close(fd);
+            return -1;
+        }
+
+        return fd;
+    }
+
+    // Helper method to open a client connection to a Unix socket; a leading '@' names an abstract one
+    int connectUnixClient(const std::string &path)
+    {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+        socklen_t length = offsetof(sockaddr_un, sun_path) + path.size() + (path[0] == '@' ? 0 : 1);
+        if (path[0] == '@')
+            address.sun_path[0] = '\0';
+
+        if (connect(fd, reinterpret_cast<sockaddr *>(&address), length) != 0)
+        {
+            close(fd);
+            return -1;
+        }
+
+        return fd;
+    }
+
+    // Helper method to get a socket path in the temporary directory that does not exist yet
+    std::string unixSocketPath()
+    {
+        std::string path = std::filesystem::temp_directory_path() / ("http-server-tests-" + std::to_string(getpid()) + ".sock");
+        unlink(path.c_str());
+        return path;
+    }
+
+    // Helper method to send a raw request and read until the server closes the connection
+    std::string exchange(const std::string &raw_request)
+    {
+        int fd = connectClient();
+        if (fd < 0)
+            return "";
+
+        // A server that never answers fails the test instead of hanging it
+        timeval timeout{5, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        send(fd, raw_request.data(), raw_request.size(), MSG_NOSIGNAL);
+
+        std::string response;
+        char buffer[4096];
+        ssize_t bytes_received;
+
+        while ((bytes_received = recv(fd, buffer, sizeof(buffer), 0)) > 0)
+            response.append(buffer, bytes_received);
+
+        close(fd);
+        return response;
+    }
+
+    // Helper method to read exactly one response framed by its Content-Length header;
+    // bytes of any following response stay in unread_input for the next call
+    std::string readResponse(int fd)
+    {
+        char buffer[4096];
+        size_t headers_end;
+
+        while ((headers_end = unread_input.find("\r\n\r\n")) == std::string::npos)
+        {
+            ssize_t bytes_received = recv(fd, buffer, sizeof(buffer), 0);
+            if (bytes_received <= 0)
+                return std::exchange(unread_input, "");
+            unread_input.append(buffer, bytes_received);
+        }
+
+        size_t body_length = std::stoul(HttpResponse::from_string(unread_input.substr(0, headers_end + 4)).get_header("Content-Length"));
+        size_t response_length = headers_end + 4 + body_length;
+
+        while (unread_input.size() < response_length)
+        {
+            ssize_t bytes_received = recv(fd, buffer, sizeof(buffer), 0);
+            if (bytes_received <= 0)
+                break;
+            unread_input.append(buffer, bytes_received);
+        }
+
+        std::string response = unread_input.substr(0, response_length);
+        unread_input.erase(0, response_length);
+        return response;
+    }
+
+    // Helper method to decode a chunked body; whatever follows the last chunk is left in body
+    std::string decodeChunked(std::string &body)
+    {
+        std::string decoded;
+        size_t offset = 0;
+
+        while (true)
+        {
+            size_t line_end = body.find("\r\n", offset);
+            if (line_end == std::string::npos)
+                return decoded;
+
+            size_t size = std::stoul(body.substr(offset, line_end - offset), nullptr, 16);
+            offset = line_end + 2;
+
+            if (size == 0)
+            {
+                body.erase(0, offset + 2);
+                return decoded;
+            }
+
+            decoded += body.substr(offset, size);
+            offset += size + 2;
+        }
+    }
+
+    // Expects the streamed /stream body, chunked, followed by a pipelined response
+    void expectStreamedResponse()
+    {
+        std::string raw = exchange("GET /stream HTTP/1.1\r\n\r\nGET /hello HTTP/1.1\r\nConnection: close\r\n\r\n");
+        size_t headers_end = raw.find("\r\n\r\n");
+        ASSERT_NE(headers_end, std::string::npos);
+
+        HttpResponse response = HttpResponse::from_string(raw.substr(0, headers_end + 4));
+        EXPECT_EQ(response.get_header("Transfer-Encoding"), "chunked");
+        EXPECT_FALSE(response.has_header("Content-Length"));
+
+        std::string rest = raw.substr(headers_end + 4);
+        std::string body = decodeChunked(rest);
+
+        EXPECT_EQ(body, std::string(64 * 1024, 'a') + std::string(64 * 1024, 'b') +
+                            std::string(64 * 1024, 'c') + std::string(64 * 1024, 'd'));
+        EXPECT_EQ(HttpResponse::from_string(rest).get_body(), "Hello");
+    }
+
+    // Requests an endless stream without reading it, then expects the server to
+    // drop the stalled connection instead of buffering the stream without bound
+    void expectStalledReaderDropped(IoBackend backend)
+    {
+        ServerConfig config = testConfig();
+        config.send_stall_timeout = std::chrono::milliseconds(200);
+        startServer(backend, config);
+
+        int fd = connectClient();
+        ASSERT_GE(fd, 0);
+
+        std::string request = "GET /endless HTTP/1.1\r\n\r\n";
+        send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2500));
+
+        timeval timeout{2, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        char buffer[65536];
+        size_t total = 0;
+        ssize_t bytes_received;
+        while ((bytes_received = recv(fd, buffer, sizeof(buffer), 0)) > 0 && total < 256 * 1024 * 1024)
+            total += bytes_received;
+
+        EXPECT_EQ(bytes_received, 0);
+        close(fd);
+    }
+
+    // Connects while every descriptor is in use and expects the server to close the
+    // pending connection instead of leaving it queued, then to serve normally again
+    void expectConnectionShedWhenOutOfDescriptors(IoBackend backend)
+    {
+        // Lowered before starting, since io_uring takes the limit when the accept is submitted
+        rlimit original{};
+        getrlimit(RLIMIT_NOFILE, &original);
+        rlimit lowered = original;
+        lowered.rlim_cur = std::min<rlim_t>(original.rlim_cur, 1024);
+        setrlimit(RLIMIT_NOFILE, &lowered);
+
+        // One loop, so no other loop's reserve can free a descriptor for the connection
+        ServerConfig config = testConfig();
+        config.io_threads = 1;
+        startServer(backend, config);
+
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        ASSERT_GE(fd, 0);
+
+        std::vector<int> fillers;
+        int filler;
+        while ((filler = open("/dev/null", O_RDONLY | O_CLOEXEC)) >= 0)
+            fillers.push_back(filler);
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(server->get_port());
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int connected = connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+        bool closed = connected == 0 && isClosedByServer(fd);
+
+        for (int filler_fd : fillers)
+            close(filler_fd);
+        setrlimit(RLIMIT_NOFILE, &original);
+        close(fd);
+
+        EXPECT_TRUE(closed);
+        EXPECT_THAT(exchange("GET /hello HTTP/1.1\r\nConnection: close\r\n\r\n"), ::testing::HasSubstr("Hello"));
+    }
+
+    // Floods a connection whose request is blocked in its handler with pipelined
+    // requests and expects the server to stop taking input or to close it
+    void expectFloodThrottled(IoBackend backend)
+    {
+        startServer(backend, testConfig());
+
+        int fd = connectClient();
+        ASSERT_GE(fd, 0);
+        std::string request = "GET /block HTTP/1.1\r\n\r\n";
+        send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (blocked_handlers < 1 && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        ASSERT_EQ(blocked_handlers, 1u);
+
+        std::string flood;
+        while (flood.size() < 64 * 1024)
+            flood += "GET /hello HTTP/1.1\r\n\r\n";
+
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        size_t limit = 64 * 1024 * 1024;
+        size_t accepted = 0;
+        bool closed = false;
+        deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+
+        while (accepted < limit && std::chrono::steady_clock::now() < deadline)
+        {
+            ssize_t sent = send(fd, flood.data(), flood.size(), MSG_NOSIGNAL);
+            if (sent > 0)
+                accepted += static_cast<size_t>(sent);
+            else if (errno == EAGAIN || errno == EWOULDBLOCK)
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            else
+            {
+                closed = true;
+                break;
+            }
+        }
+
+        release_handlers = true;
+        close(fd);
+
+        EXPECT_TRUE(closed || accepted < limit / 2) << accepted << " bytes accepted";
+    }
+
+    // Sets every socket option, corking responses, and expects persistent, pipelined
+    // and streamed exchanges to complete without waiting for the cork to time out
+    void expectResponsesWithSocketPolicy(IoBackend backend)
+    {
+        ServerConfig config = testConfig();
+        config.socket_policy.backlog = 64;
+        config.socket_policy.defer_accept_seconds = 1;
+        config.socket_policy.fast_open_queue = 16;
+        config.socket_policy.nagle = NagleStrategy::Cork;
+        config.socket_policy.send_buffer_size = 64 * 1024;
+        config.socket_policy.receive_buffer_size = 64 * 1024;
+        startServer(backend, config);
+
+        auto start = std::chrono::steady_clock::now();
+        expectPersistentConnection();
+        EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(150));
+
+        expectPipelinedResponses();
+        expectStreamedResponse();
+    }
+
+    // Expects a silent connection to be closed, and headers trickled past the header
+    // timeout or a body stalled past the body timeout to be answered with 408
+    void expectRequestTimeouts(IoBackend backend)
+    {
+        ServerConfig config = testConfig();
+        config.request_header_timeout = std::chrono::milliseconds(300);
+        config.request_body_timeout = std::chrono::milliseconds(200);
+        startServer(backend, config);
+
+        int silent = connectClient();
+        ASSERT_GE(silent, 0);
+        EXPECT_TRUE(isClosedByServer(silent));
+        close(silent);
+
+        int trickling = connectClient();
+        ASSERT_GE(trickling, 0);
+
+        // One byte at a time, stopping once the server has answered
+        std::string headers = "GET /hello HTTP/1.1\r\nHost: localhost\r\nX-Padding: ";
+        char peeked;
+        for (size_t i = 0; i < 100 && recv(trickling, &peeked, 1, MSG_PEEK | MSG_DONTWAIT) < 0; ++i)
+        {
+            char byte = i < headers.size() ? headers[i] : 'x';
+            send(trickling, &byte, 1, MSG_NOSIGNAL);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+
+        EXPECT_EQ(HttpResponse::from_string(readResponse(trickling)).get_code(), HttpCode::RequestTimeout);
+        EXPECT_TRUE(isClosedByServer(trickling));
+        close(trickling);
+
+        int stalled = connectClient();
+        ASSERT_GE(stalled, 0);
+
+        std::string request = "POST /echo HTTP/1.1\r\nContent-Length: 10\r\n\r\nabc";
+        send(stalled, request.data(), request.size(), MSG_NOSIGNAL);
+
+        EXPECT_EQ(HttpResponse::from_string(readResponse(stalled)).get_code(), HttpCode::RequestTimeout);
+        EXPECT_TRUE(isClosedByServer(stalled));
+        close(stalled);
+    }
+
+    // Drains with an idle persistent connection, a request in its handler and a request
+    // whose headers never complete: the idle one closes at once, the handled one gets
+    // its response with Connection: close, and the drain timeout ends the incomplete one
+    void expectGracefulDrain(IoBackend backend)
+    {
+        ServerConfig config = testConfig();
+        config.drain_timeout = std::chrono::milliseconds(600);
+        startServer(backend, config);
+
+        int idle = connectClient();
+        ASSERT_GE(idle, 0);
+        std::string request = "GET /hello HTTP/1.1\r\n\r\n";
+        send(idle, request.data(), request.size(), MSG_NOSIGNAL);
+        EXPECT_EQ(HttpResponse::from_string(readResponse(idle)).get_body(), "Hello");
+
+        int handled = connectClient();
+        ASSERT_GE(handled, 0);
+        request = "GET /slow HTTP/1.1\r\n\r\n";
+        send(handled, request.data(), request.size(), MSG_NOSIGNAL);
+
+        int incomplete = connectClient();
+        ASSERT_GE(incomplete, 0);
+        request = "GET /hello HTTP/1.1\r\n";
+        send(incomplete, request.data(), request.size(), MSG_NOSIGNAL);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto start = std::chrono::steady_clock::now();
+        server->drain();
+        EXPECT_TRUE(server->is_draining());
+
+        EXPECT_TRUE(isClosedByServer(idle));
+
+        HttpResponse response = HttpResponse::from_string(readResponse(handled));
+        EXPECT_EQ(response.get_body(), "Slow");
+        EXPECT_EQ(response.get_header("Connection"), "close");
+        EXPECT_TRUE(isClosedByServer(handled));
+
+        server_thread.join();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        EXPECT_GE(elapsed, std::chrono::milliseconds(500));
+        EXPECT_LT(elapsed, std::chrono::milliseconds(3000));
+        EXPECT_FALSE(server->is_running());
+        EXPECT_TRUE(isClosedByServer(incomplete));
+
+        close(idle);
+        close(handled);
+        close(incomplete);
+    }
+
+    // Occupies every worker and fills the one-task queue, then expects the next
+    // request to be refused at once with the precomputed 503 while the queued one
+    // is still served once the workers are released
+    void expectOverloadShedding(IoBackend backend)
+    {
+        ServerConfig config = testConfig();
+        config.max_queue_depth = 1;
+        config.queue_target_delay = std::chrono::milliseconds(0);
+        config.retry_after_seconds = 7;
+        startServer(backend, config);
+
+        size_t workers = server->get_worker_stats().size();
+        std::vector<int> blocking;
+        std::string request = "GET /block HTTP/1.1\r\n\r\n";
+        for (size_t i = 0; i < workers; ++i)
+        {
+            blocking.push_back(connectClient());
+            ASSERT_GE(blocking.back(), 0);
+            send(blocking.back(), request.data(), request.size(), MSG_NOSIGNAL);
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (blocked_handlers < workers && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        ASSERT_EQ(blocked_handlers, workers);
+
+        int queued = connectClient();
+        ASSERT_GE(queued, 0);
+        request = "GET /hello HTTP/1.1\r\n\r\n";
+        send(queued, request.data(), request.size(), MSG_NOSIGNAL);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        auto start = std::chrono::steady_clock::now();
+        HttpResponse refused = HttpResponse::from_string(exchange("GET /hello HTTP/1.1\r\n\r\n"));
+        EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+        EXPECT_EQ(refused.get_code(), HttpCode::ServiceUnavailable);
+        EXPECT_EQ(refused.get_header("Retry-After"), "7");
+        EXPECT_EQ(refused.get_header("Connection"), "close");
+        EXPECT_GE(server->get_shed_count(), 1u);
+
+        release_handlers = true;
+        EXPECT_EQ(HttpResponse::from_string(readResponse(queued)).get_body(), "Hello");
+        for (int fd : blocking)
+        {
+            EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), "Released");
+            close(fd);
+        }
+
+        close(queued);
+    }
+
+    // Pins a fixed number of workers, isolated from the I/O threads where the
+    // machine has CPUs enough, and expects requests to be served through them
+    void expectThreadTopology(IoBackend backend)
+    {
+        ServerConfig config = testConfig();
+        config.topology.workers = 3;
+        config.topology.pin_workers = true;
+        config.topology.isolate_io_threads = true;
+        config.topology.numa_local_buffers = true;
+        startServer(backend, config);
+
+        EXPECT_EQ(server->get_worker_stats().size(), 3u);
+
+        for (int i = 0; i < 5; ++i)
+            EXPECT_EQ(HttpResponse::from_string(exchange("GET /hello HTTP/1.1\r\nConnection: close\r\n\r\n")).get_body(),
+                      "Hello");
+    }
+
+    // Runs coroutine handlers behind a single worker and expects slow ones to
+    // overlap instead of queueing; blocking workers wait them out, so there get
+    // one each. Pipelined sync and async requests are answered in order
+    void expectAsyncHandlers(IoBackend backend)
+    {
+        ServerConfig config = testConfig();
+        config.topology.workers = backend == IoBackend::Blocking ? 8 : 1;
+        startServer(backend, config);
+        writeStaticFile("small.txt", "file contents");
+
+        std::vector<int> clients;
+        for (int i = 0; i < 8; ++i)
+        {
+            int fd = connectClient();
+            ASSERT_GE(fd, 0);
+            clients.push_back(fd);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::string request = "GET /async-sleep HTTP/1.1\r\nConnection: close\r\n\r\n";
+        for (int fd : clients)
+            send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+
+        for (int fd : clients)
+        {
+            EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), "Awake");
+            close(fd);
+        }
+
+        if (backend != IoBackend::Blocking)
+        {
+            EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+        }
+
+        int fd = connectClient();
+        ASSERT_GE(fd, 0);
+
+        std::string requests = "GET /async-sleep HTTP/1.1\r\n\r\n"
+                               "GET /hello HTTP/1.1\r\n\r\n"
+                               "GET /async-static/small.txt HTTP/1.1\r\n\r\n"
+                               "GET /async-poll HTTP/1.1\r\n\r\n";
+        send(fd, requests.data(), requests.size(), MSG_NOSIGNAL);
+
+        EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), "Awake");
+        EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), "Hello");
+        EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), "file contents");
+        EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), "0 1");
+
+        close(fd);
+    }
+
+    // Holds the only worker, then expects inline routes to be answered on the I/O
+    // thread and blocking routes to run on their own pool, whose queue is bounded
+    void expectExecutionPolicies(IoBackend backend)
+    {
+        ServerConfig config = testConfig();
+        config.topology.workers = 1;
+        config.blocking_workers = 1;
+        config.max_blocking_queue_depth = 1;
+        startServer(backend, config);
+
+        int held = connectClient();
+        ASSERT_GE(held, 0);
+        std::string request = "GET /block HTTP/1.1\r\n\r\n";
+        send(held, request.data(), request.size(), MSG_NOSIGNAL);
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (blocked_handlers < 1 && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        ASSERT_EQ(blocked_handlers, 1u);
+
+        EXPECT_EQ(HttpResponse::from_string(exchange("GET /inline HTTP/1.1\r\nConnection: close\r\n\r\n")).get_body(), "Inline");
+
+        std::vector<int> blocking;
+        request = "GET /block-io HTTP/1.1\r\n\r\n";
+        for (int i = 0; i < 2; ++i)
+        {
+            blocking.push_back(connectClient());
+            ASSERT_GE(blocking.back(), 0);
+            send(blocking.back(), request.data(), request.size(), MSG_NOSIGNAL);
+
+            while (blocked_io_handlers < 1 && std::chrono::steady_clock::now() < deadline)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            ASSERT_EQ(blocked_io_handlers, 1u);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        HttpResponse refused = HttpResponse::from_string(exchange("GET /block-io HTTP/1.1\r\n\r\n"));
+        EXPECT_EQ(refused.get_code(), HttpCode::ServiceUnavailable);
+
+        release_handlers = true;
+        EXPECT_EQ(HttpResponse::from_string(readResponse(held)).get_body(), "Released");
+        for (int fd : blocking)
+        {
+            EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), "Released");
+            close(fd);
+        }
+        close(held);
+
+        int fd = connectClient();
+        ASSERT_GE(fd, 0);
+        std::string requests = "GET /inline HTTP/1.1\r\n\r\n"
+                               "GET /hello HTTP/1.1\r\n\r\n"
+                               "GET /block-io HTTP/1.1\r\n\r\n";
+        send(fd, requests.data(), requests.size(), MSG_NOSIGNAL);
+
+        EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), "Inline");
+        EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), "Hello");
+        EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), "Released");
+        close(fd);
+    }
+
+    // Expects sampled requests to be in the access log once the server stops, with
+    // the peer, sizes and statuses the client saw, and 4xx responses left out
+    void expectAccessLog(IoBackend backend)
+    {
+        std::string path = std::filesystem::temp_directory_path() / ("http-server-tests-" + std::to_string(getpid()) + ".access");
+        ServerConfig config = testConfig();
+        config.access_log.path = path;
+        config.access_log.max_files = 0;
+        config.access_log.sample_rates[3] = 0.0;
+        startServer(backend, config);
+
+        int fd = connectClient();
+        ASSERT_GE(fd, 0);
+        sockaddr_in local{};
+        socklen_t local_length = sizeof(local);
+        getsockname(fd, reinterpret_cast<sockaddr *>(&local), &local_length);
+
+        std::string requests = "GET /hello HTTP/1.1\r\n\r\n"
+                               "GET /missing HTTP/1.1\r\n\r\n"
+                               "POST /echo HTTP/1.1\r\nContent-Length: 3\r\n\r\nabc";
+        send(fd, requests.data(), requests.size(), MSG_NOSIGNAL);
+
+        std::string hello = readResponse(fd);
+        readResponse(fd);
+        std::string echo = readResponse(fd);
+        close(fd);
+        stopServer();
+
+        std::vector<AccessRecord> records = read_access_log(path);
+        std::filesystem::remove(path);
+        ASSERT_EQ(records.size(), 2u);
+
+        EXPECT_EQ(records[0].method, static_cast<uint8_t>(HttpMethod::GET));
+        EXPECT_EQ(std::string(records[0].uri, records[0].uri_length), "/hello");
+        EXPECT_EQ(records[0].status, 200);
+        EXPECT_EQ(records[0].bytes, hello.size());
+        EXPECT_EQ(records[1].method, static_cast<uint8_t>(HttpMethod::POST));
+        EXPECT_EQ(std::string(records[1].uri, records[1].uri_length), "/echo");
+        EXPECT_EQ(records[1].bytes, echo.size());
+
+        for (const AccessRecord &record : records)
+        {
+            EXPECT_EQ(record.peer_family, static_cast<uint8_t>(PeerFamily::IPv4));
+            EXPECT_EQ(record.peer_port, ntohs(local.sin_port));
+            EXPECT_EQ(std::memcmp(record.peer_address, &local.sin_addr, 4), 0);
+        }
+    }
+
+    // Sheds a blocking request pipelined behind an async one and expects the 503 to
+    // close the connection and to be in the access log
+    void expectShedAsyncBatchRecorded(IoBackend backend)
+    {
+        std::string path = std::filesystem::temp_directory_path() / ("http-server-tests-" + std::to_string(getpid()) + ".access");
+        ServerConfig config = testConfig();
+        config.blocking_workers = 1;
+        config.max_blocking_queue_depth = 1;
+        config.access_log.path = path;
+        config.access_log.max_files = 0;
+        startServer(backend, config);
+
+        std::vector<int> blocking;
+        std::string request = "GET /block-io HTTP/1.1\r\n\r\n";
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        for (int i = 0; i < 2; ++i)
+        {
+            blocking.push_back(connectClient());
+            ASSERT_GE(blocking.back(), 0);
+            send(blocking.back(), request.data(), request.size(), MSG_NOSIGNAL);
+
+            while (blocked_io_handlers < 1 && std::chrono::steady_clock::now() < deadline)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            ASSERT_EQ(blocked_io_handlers, 1u);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        int fd = connectClient();
+        ASSERT_GE(fd, 0);
+        std::string requests = "GET /async-sleep HTTP/1.1\r\n\r\n"
+                               "GET /block-io HTTP/1.1\r\n\r\n"
+                               "GET /hello HTTP/1.1\r\n\r\n";
+        send(fd, requests.data(), requests.size(), MSG_NOSIGNAL);
+
+        EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), "Awake");
+        HttpResponse refused = HttpResponse::from_string(readResponse(fd));
+        EXPECT_EQ(refused.get_code(), HttpCode::ServiceUnavailable);
+        EXPECT_EQ(refused.get_header("Connection"), "close");
+        EXPECT_TRUE(isClosedByServer(fd));
+        close(fd);
+
+        release_handlers = true;
+        for (int blocked : blocking)
+        {
+            readResponse(blocked);
+            close(blocked);
+        }
+        stopServer();
+
+        std::vector<AccessRecord> records = read_access_log(path);
+        std::filesystem::remove(path);
+
+        size_t refused_records = 0;
+        for (const AccessRecord &record : records)
+        {
+            if (record.status == 503)
+            {
+                EXPECT_EQ(std::string(record.uri, record.uri_length), "/block-io");
+                ++refused_records;
+            }
+        }
+        EXPECT_EQ(refused_records, 1u);
+    }
+
+    // Leaves a stale socket file at the path, then expects the server to replace it,
+    // apply the configured mode, serve persistent and pipelined requests, and remove
+    // the file once it stops
+    void expectUnixSocketResponses(IoBackend backend)
+    {
+        std::string path = unixSocketPath();
+        {
+            int stale = socket(AF_UNIX, SOCK_STREAM, 0);
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+            ASSERT_EQ(bind(stale, reinterpret_cast<sockaddr *>(&address), sizeof(address)), 0);
+            close(stale);
+        }
+
+        ServerConfig config = testConfig();
+        config.unix_socket_path = path;
+        config.unix_socket_mode = 0600;
+        config.socket_policy.nagle = NagleStrategy::Cork;
+        startServer(backend, config);
+
+        EXPECT_EQ(server->get_port(), 0);
+
+        struct stat status{};
+        ASSERT_EQ(stat(path.c_str(), &status), 0);
+        EXPECT_TRUE(S_ISSOCK(status.st_mode));
+        EXPECT_EQ(status.st_mode & 0777, 0600u);
+
+        int fd = connectUnixClient(path);
+        ASSERT_GE(fd, 0);
+
+        std::string requests = "GET /hello HTTP/1.1\r\n\r\nPOST /echo HTTP/1.1\r\nContent-Length: 4\r\n\r\nping";
+        send(fd, requests.data(), requests.size(), MSG_NOSIGNAL);
+        EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), "Hello");
+        EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), "ping");
+        close(fd);
+
+        stopServer();
+        EXPECT_NE(access(path.c_str(), F_OK), 0);
+    }
+
+    // Helper method to check whether the server has closed the connection
+    bool isClosedByServer(int fd)
+    {
+        timeval timeout{2, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        char buffer[1];
+        return recv(fd, buffer, sizeof(buffer), 0) == 0;
+    }
+
+    // Sends two requests on one connection and expects both to be answered
+    void expectPersistentConnection()
+    {
+        int fd = connectClient();
+        ASSERT_GE(fd, 0);
+
+        std::string request = "GET /hello HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+        for (int i = 0; i < 2; ++i)
+        {
+            send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+            HttpResponse response = HttpResponse::from_string(readResponse(fd));
+
+            EXPECT_EQ(response.get_body(), "Hello");
+            EXPECT_EQ(response.get_header("Connection"), "keep-alive");
+        }
+
+        close(fd);
+    }
+
+    // Opens many connections, sends one request on each and expects every response
+    void expectConcurrentResponses(size_t count)
+    {
+        std::vector<int> clients;
+        for (size_t i = 0; i < count; ++i)
+        {
+            int fd = connectClient();
+            ASSERT_GE(fd, 0);
+            clients.push_back(fd);
+        }
+
+        std::string request = "GET /hello HTTP/1.1\r\nConnection: close\r\n\r\n";
+        for (int fd : clients)
+            send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+
+        for (int fd : clients)
+        {
+            EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), "Hello");
+            close(fd);
+        }
+    }
+
+    // Sends three pipelined requests in one segment and expects the responses in order
+    void expectPipelinedResponses()
+    {
+        int fd = connectClient();
+        ASSERT_GE(fd, 0);
+
+        std::string requests = "POST /echo HTTP/1.1\r\nContent-Length: 3\r\n\r\none"
+                               "GET /hello HTTP/1.1\r\n\r\n"
+                               "POST /echo HTTP/1.1\r\nContent-Length: 5\r\n\r\nthree";
+        send(fd, requests.data(), requests.size(), MSG_NOSIGNAL);
+
+        EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), "one");
+        EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), "Hello");
+        EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), "three");
+
+        close(fd);
+    }
+
+    std::unique_ptr<HttpServer> server;
+    std::thread server_thread;
+    std::string unread_input;
+    std::atomic<size_t> streamed_bytes{0};
+    std::atomic<size_t> blocked_handlers{0};
+    std::atomic<bool> release_handlers{false};
+    std::atomic<size_t> blocked_io_handlers{0};
+    std::filesystem::path web_root;
+};
+
+// Tests for the epoll backend
+TEST_F(HttpServerTest, run_should_serve_request_when_using_epoll_backend)
+{
+    startServer(IoBackend::Epoll);
+
+    HttpResponse response = HttpResponse::from_string(exchange("GET /hello HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n"));
+
+    EXPECT_EQ(response.get_code(), HttpCode::OK);
+    EXPECT_EQ(response.get_body(), "Hello");
+}
+
+TEST_F(HttpServerTest, run_should_reassemble_request_when_sent_in_several_segments_using_epoll_backend)
+{
+    startServer(IoBackend::Epoll);
+
+    int fd = connectClient();
+    ASSERT_GE(fd, 0);
+
+    std::string head = "POST /echo HTTP/1.1\r\nConnection: close\r\nContent-Length: 10\r\n\r\n01234";
+    send(fd, head.data(), head.size(), MSG_NOSIGNAL);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    send(fd, "56789", 5, MSG_NOSIGNAL);
+
+    std::string raw_response;
+    char buffer[4096];
+    ssize_t bytes_received;
+    while ((bytes_received = recv(fd, buffer, sizeof(buffer), 0)) > 0)
+        raw_response.append(buffer, bytes_received);
+    close(fd);
+
+    HttpResponse response = HttpResponse::from_string(raw_response);
+    EXPECT_EQ(response.get_code(), HttpCode::OK);
+    EXPECT_EQ(response.get_body(), "0123456789");
+}
+
+TEST_F(HttpServerTest, run_should_return_bad_request_when_request_line_is_invalid_using_epoll_backend)
+{
+    startServer(IoBackend::Epoll);
+
+    HttpResponse response = HttpResponse::from_string(exchange("BOGUS / HTTP/1.1\r\n\r\n"));
+
+    EXPECT_EQ(response.get_code(), HttpCode::BadRequest);
+}
+
+TEST_F(HttpServerTest, run_should_serve_many_concurrent_connections_when_using_epoll_backend)
+{
+    startServer(IoBackend::Epoll);
+
+    std::vector<int> clients;
+    for (int i = 0; i < 64; ++i)
+    {
+        int fd = connectClient();
+        ASSERT_GE(fd, 0);
+        clients.push_back(fd);
+    }
+
+    std::string request = "GET /hello HTTP/1.1\r\nConnection: close\r\n\r\n";
+    for (int fd : clients)
+        send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+
+    for (int fd : clients)
+    {
+        std::string raw_response;
+        char buffer[4096];
+        ssize_t bytes_received;
+        while ((bytes_received = recv(fd, buffer, sizeof(buffer), 0)) > 0)
+            raw_response.append(buffer, bytes_received);
+        close(fd);
+
+        EXPECT_EQ(HttpResponse::from_string(raw_response).get_body(), "Hello");
+    }
+}
+
+TEST_F(HttpServerTest, run_should_keep_connection_open_when_using_epoll_backend)
+{
+    startServer(IoBackend::Epoll);
+    expectPersistentConnection();
+}
+
+TEST_F(HttpServerTest, run_should_answer_pipelined_requests_in_order_when_using_epoll_backend)
+{
+    startServer(IoBackend::Epoll);
+    expectPipelinedResponses();
+}
+
+TEST_F(HttpServerTest, run_should_drop_pipelined_requests_after_connection_close_using_epoll_backend)
+{
+    startServer(IoBackend::Epoll);
+
+    int fd = connectClient();
+    ASSERT_GE(fd, 0);
+
+    std::string requests = "GET /hello HTTP/1.1\r\nConnection: close\r\n\r\n"
+                           "GET /hello HTTP/1.1\r\n\r\n";
+    send(fd, requests.data(), requests.size(), MSG_NOSIGNAL);
+
+    EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), "Hello");
+    EXPECT_TRUE(isClosedByServer(fd));
+    close(fd);
+}
+
+TEST_F(HttpServerTest, run_should_decode_chunked_request_body_when_using_epoll_backend)
+{
+    startServer(IoBackend::Epoll);
+
+    HttpResponse response = HttpResponse::from_string(exchange(
+        "POST /echo HTTP/1.1\r\nConnection: close\r\nTransfer-Encoding: chunked\r\n\r\n"
+        "4\r\nWiki\r\n5\r\npedia\r\n0\r\n\r\n"));
+
+    EXPECT_EQ(response.get_body(), "Wikipedia");
+}
+
+TEST_F(HttpServerTest, run_should_stream_body_to_route_sink_when_body_exceeds_buffer_limit_using_epoll_backend)
+{
+    ServerConfig config = testConfig();
+    config.max_request_body_size = 1024;
+    startServer(IoBackend::Epoll, config);
+
+    std::string chunk(16 * 1024, 'u');
+    std::string request = "POST /upload HTTP/1.1\r\nConnection: close\r\nTransfer-Encoding: chunked\r\n\r\n";
+    for (int i = 0; i < 8; ++i)
+        request += "4000\r\n" + chunk + "\r\n";
+    request += "0\r\n\r\n";
+
+    HttpResponse response = HttpResponse::from_string(exchange(request));
+
+    EXPECT_EQ(response.get_body(), std::to_string(8 * chunk.size()) + " 0");
+}
+
+TEST_F(HttpServerTest, run_should_close_connection_when_http_1_0_request_has_no_keep_alive_using_epoll_backend)
+{
+    startServer(IoBackend::Epoll);
+
+    int fd = connectClient();
+    ASSERT_GE(fd, 0);
+
+    std::string request = "GET /hello HTTP/1.0\r\n\r\n";
+    send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+
+    HttpResponse response = HttpResponse::from_string(readResponse(fd));
+    EXPECT_EQ(response.get_header("Connection"), "close");
+    EXPECT_TRUE(isClosedByServer(fd));
+    close(fd);
+}
+
+TEST_F(HttpServerTest, run_should_close_connection_when_max_requests_reached_using_epoll_backend)
+{
+    ServerConfig config = testConfig();
+    config.max_keep_alive_requests = 2;
+    startServer(IoBackend::Epoll, config);
+
+    int fd = connectClient();
+    ASSERT_GE(fd, 0);
+
+    std::string request = "GET /hello HTTP/1.1\r\n\r\n";
+    send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+    EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_header("Connection"), "keep-alive");
+
+    send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+    EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_header("Connection"), "close");
+    EXPECT_TRUE(isClosedByServer(fd));
+    close(fd);
+}
+
+TEST_F(HttpServerTest, run_should_close_idle_connection_when_keep_alive_timeout_expires_using_epoll_backend)
+{
+    ServerConfig config = testConfig();
+    config.keep_alive_timeout = std::chrono::milliseconds(100);
+    startServer(IoBackend::Epoll, config);
+
+    int fd = connectClient();
+    ASSERT_GE(fd, 0);
+
+    std::string request = "GET /hello HTTP/1.1\r\n\r\n";
+    send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+    readResponse(fd);
+
+    EXPECT_TRUE(isClosedByServer(fd));
+    close(fd);
+}
+
+TEST_F(HttpServerTest, run_should_spread_connections_over_shards_when_reuse_port_shards_enabled_using_epoll_backend)
+{
+    ServerConfig config = testConfig();
+    config.reuse_port_shards = true;
+    config.io_threads = 4;
+    startServer(IoBackend::Epoll, config);
+
+    expectConcurrentResponses(64);
+
+    uint64_t accepted = 0, requests = 0;
+    for (const auto &stats : server->get_io_loop_stats())
+    {
+        accepted += stats.connections_accepted;
+        requests += stats.requests_processed;
+    }
+
+    EXPECT_EQ(server->get_io_loop_stats().size(), 4u);
+    EXPECT_EQ(accepted, 64u);
+    EXPECT_EQ(requests, 64u);
+}
+
+TEST_F(HttpServerTest, run_should_send_large_response_completely_when_using_epoll_backend)
+{
+    startServer(IoBackend::Epoll);
+
+    HttpResponse response = HttpResponse::from_string(exchange("GET /large HTTP/1.1\r\nConnection: close\r\n\r\n"));
+
+    EXPECT_EQ(response.get_body(), std::string(300 * 1024, 'x'));
+}
+
+TEST_F(HttpServerTest, run_should_stream_chunked_response_before_pipelined_response_when_using_epoll_backend)
+{
+    startServer(IoBackend::Epoll);
+    expectStreamedResponse();
+}
+
+TEST_F(HttpServerTest, run_should_stream_chunked_response_when_handlers_run_inline_using_epoll_backend)
+{
+    ServerConfig config = testConfig();
+    config.reuse_port_shards = true;
+    startServer(IoBackend::Epoll, config);
+    expectStreamedResponse();
+}
+
+TEST_F(HttpServerTest, run_should_stream_response_without_chunking_when_content_length_is_set_using_epoll_backend)
+{
+    startServer(IoBackend::Epoll);
+
+    int fd = connectClient();
+    ASSERT_GE(fd, 0);
+
+    std::string request = "GET /stream-sized HTTP/1.1\r\n\r\n";
+    send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+
+    HttpResponse response = HttpResponse::from_string(readResponse(fd));
+    EXPECT_FALSE(response.has_header("Transfer-Encoding"));
+    EXPECT_EQ(response.get_body(), "0123401234");
+    EXPECT_EQ(response.get_header("Connection"), "keep-alive");
+
+    send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+    EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), "0123401234");
+    close(fd);
+}
+
+TEST_F(HttpServerTest, run_should_close_connection_after_streamed_response_when_client_is_http_1_0_using_epoll_backend)
+{
+    startServer(IoBackend::Epoll);
+
+    HttpResponse response = HttpResponse::from_string(exchange("GET /stream HTTP/1.0\r\nConnection: keep-alive\r\n\r\n"));
+
+    EXPECT_FALSE(response.has_header("Transfer-Encoding"));
+    EXPECT_EQ(response.get_header("Connection"), "close");
+    EXPECT_EQ(response.get_body().size(), 4u * 64 * 1024);
+}
+
+TEST_F(HttpServerTest, run_should_send_static_file_from_descriptor_when_using_epoll_backend)
+{
+    startServer(IoBackend::Epoll);
+    expectStaticFileResponse();
+}
+
+TEST_F(HttpServerTest, run_should_keep_serving_after_client_resets_during_file_body_when_using_epoll_backend)
+{
+    startServer(IoBackend::Epoll);
+    expectClientResetDuringFileBody();
+}
+
+TEST_F(HttpServerTest, run_should_drop_connection_when_reader_stalls_past_deadline_using_epoll_backend)
+{
+    expectStalledReaderDropped(IoBackend::Epoll);
+}
+
+TEST_F(HttpServerTest, run_should_close_pending_connection_when_out_of_descriptors_using_epoll_backend)
+{
+    expectConnectionShedWhenOutOfDescriptors(IoBackend::Epoll);
+}
+
+TEST_F(HttpServerTest, run_should_apply_socket_policy_when_using_epoll_backend)
+{
+    expectResponsesWithSocketPolicy(IoBackend::Epoll);
+}
+
+TEST_F(HttpServerTest, run_should_time_out_slow_requests_when_using_epoll_backend)
+{
+    expectRequestTimeouts(IoBackend::Epoll);
+}
+
+TEST_F(HttpServerTest, drain_should_finish_started_requests_before_run_returns_when_using_epoll_backend)
+{
+    expectGracefulDrain(IoBackend::Epoll);
+}
+
+TEST_F(HttpServerTest, run_should_shed_requests_with_service_unavailable_when_queue_is_full_using_epoll_backend)
+{
+    expectOverloadShedding(IoBackend::Epoll);
+}
+
+TEST_F(HttpServerTest, run_should_serve_requests_over_unix_socket_when_using_epoll_backend)
+{
+    expectUnixSocketResponses(IoBackend::Epoll);
+}
+
+TEST_F(HttpServerTest, run_should_answer_pipelined_requests_beyond_output_high_water_mark_when_using_blocking_backend)
+{
+    expectPipelinedResponsesBeyondHighWaterMark(IoBackend::Blocking);
+}
+
+TEST_F(HttpServerTest, run_should_throttle_client_flooding_a_busy_connection_when_using_blocking_backend)
+{
+    expectFloodThrottled(IoBackend::Blocking);
+}
+
+TEST_F(HttpServerTest, run_should_answer_pipelined_requests_beyond_output_high_water_mark_when_using_epoll_backend)
+{
+    expectPipelinedResponsesBeyondHighWaterMark(IoBackend::Epoll);
+}
+
+TEST_F(HttpServerTest, run_should_throttle_client_flooding_a_busy_connection_when_using_epoll_backend)
+{
+    expectFloodThrottled(IoBackend::Epoll);
+}
+
+TEST_F(HttpServerTest, run_should_serve_requests_on_configured_thread_topology_when_using_epoll_backend)
+{
+    expectThreadTopology(IoBackend::Epoll);
+}
+
+TEST_F(HttpServerTest, run_should_run_coroutine_handlers_without_holding_workers_when_using_epoll_backend)
+{
+    expectAsyncHandlers(IoBackend::Epoll);
+}
+
+TEST_F(HttpServerTest, run_should_record_shed_request_of_async_batch_when_using_epoll_backend)
+{
+    expectShedAsyncBatchRecorded(IoBackend::Epoll);
+}
+
+TEST_F(HttpServerTest, run_should_record_sampled_requests_in_access_log_when_using_epoll_backend)
+{
+    expectAccessLog(IoBackend::Epoll);
+}
+
+TEST_F(HttpServerTest, run_should_run_handlers_where_their_route_policy_says_when_using_epoll_backend)
+{
+    expectExecutionPolicies(IoBackend::Epoll);
+}
+
+TEST_F(HttpServerTest, run_should_serve_requests_over_abstract_unix_socket_when_using_epoll_backend)
+{
+    std::string name = "@http-server-tests-" + std::to_string(getpid());
+    ServerConfig config = testConfig();
+    config.unix_socket_path = name;
+    startServer(IoBackend::Epoll, config);
+
+    int fd = connectUnixClient(name);
+    ASSERT_GE(fd, 0);
+
+    std::string request = "GET /hello HTTP/1.1\r\n\r\n";
+    send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+    EXPECT_EQ(HttpResponse::from_string(readResponse(fd)).get_body(), "Hello");
+    close(fd);
+}
+
+TEST_F(HttpServerTest, run_should_fail_when_unix_socket_is_served_by_live_server_using_epoll_backend)
+{
+    ServerConfig config = testConfig();
+    config.unix_socket_path = unixSocketPath();
+    startServer(IoBackend::Epoll, config);
+
+    HttpServer second;
+    config.backend = IoBackend::Epoll;
+    second.set_config(config);
+
+    EXPECT_EQ(second.run(), 1);
+    EXPECT_EQ(access(config.unix_socket_path.c_str(), F_OK), 0);
+}
+
+TEST_F(HttpServerTest, run_should_accept_on_inherited_listener_when_listen_fds_are_set_using_epoll_backend)
+{
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t address_length = sizeof(address);
+    ASSERT_EQ(bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)), 0);
+    ASSERT_EQ(listen(listener, 16), 0);
+    getsockname(listener, reinterpret_cast<sockaddr *>(&address), &address_length);
+
+    // The listener is moved to descriptor 3, where the server looks for it,
+    // unless socket() already handed out descriptor 3
+    int saved = -1;
+    if (listener != listen_fds_start)
+    {
+        saved = dup(listen_fds_start);
+        dup2(listener, listen_fds_start);
+        close(listener);
+    }
+    setenv("LISTEN_PID", std::to_string(getpid()).c_str(), 1);
+    setenv("LISTEN_FDS", "1", 1);
+
+    startServer(IoBackend::Epoll);
+
+    EXPECT_EQ(server->get_port(), ntohs(address.sin_port));
+    EXPECT_EQ(getenv("LISTEN_FDS"), nullptr);
+    EXPECT_THAT(exchange("GET /hello HTTP/1.1\r\nConnection: close\r\n\r\n"), ::testing::HasSubstr("Hello"));
+
+    stopServer();
+    if (saved >= 0)
+    {
+        dup2(saved, listen_fds_start);
+        close(saved);
+    }
+}
+
+#ifdef HAS_IO_URING
+// Tests for the io_uring backend
+TEST_F(HttpServerTest, run_should_serve_request_when_using_io_uring_backend)
+{
+    startServer(IoBackend::IoUring);
+
+    HttpResponse response = HttpResponse::from_string(exchange("GET /hello HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n"));
+
+    EXPECT_EQ(response.get_code(), HttpCode::OK);
+    EXPECT_EQ(response.get_body(), "Hello");
+}
+
+TEST_F(HttpServerTest, run_should_recycle_buffer_ring_entries_when_using_io_uring_backend)
+{
+    expectLargeBodiesEchoed(true);
+}
+
+TEST_F(HttpServerTest, run_should_recycle_provided_buffers_when_buffer_ring_is_off_using_io_uring_backend)
+{
+    expectLargeBodiesEchoed(false);
+}
+
+TEST_F(HttpServerTest, run_should_keep_connection_open_when_using_io_uring_backend)
+{
+    startServer(IoBackend::IoUring);
+    expectPersistentConnection();
+}
+
+TEST_F(HttpServerTest, run_should_answer_pipelined_requests_in_order_when_using_io_uring_backend)
+{
+    startServer(IoBackend::IoUring);
+    expectPipelinedResponses();
+}
+
+TEST_F(HttpServerTest, run_should_close_idle_connection_when_keep_alive_timeout_expires_using_io_uring_backend)
+{
+    ServerConfig config = testConfig();
+    config.keep_alive_timeout = std::chrono::milliseconds(100);
+    startServer(IoBackend::IoUring, config);
+
+    int fd = connectClient();
+    ASSERT_GE(fd, 0);
+
+    std::string request = "GET /hello HTTP/1.1\r\n\r\n";
+    send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+    readResponse(fd);
+
+    EXPECT_TRUE(isClosedByServer(fd));
+    close(fd);
+}
+
+TEST_F(HttpServerTest, run_should_serve_requests_when_cpu_steered_shards_enabled_using_io_uring_backend)
+{
+    ServerConfig config = testConfig();
+    config.reuse_port_shards = true;
+    config.shard_cpu_steering = true;
+    config.io_threads = 4;
+    startServer(IoBackend::IoUring, config);
+
+    expectConcurrentResponses(64);
+    expectPersistentConnection();
+}
+
+TEST_F(HttpServerTest, run_should_send_large_response_completely_when_using_io_uring_backend)
+{
+    startServer(IoBackend::IoUring);
+
+    HttpResponse response = HttpResponse::from_string(exchange("GET /large HTTP/1.1\r\nConnection: close\r\n\r\n"));
+
+    EXPECT_EQ(response.get_body(), std::string(300 * 1024, 'x'));
+}
+
+TEST_F(HttpServerTest, run_should_stream_chunked_response_before_pipelined_response_when_using_io_uring_backend)
+{
+    startServer(IoBackend::IoUring);
+    expectStreamedResponse();
+}
+
+TEST_F(HttpServerTest, run_should_splice_static_file_when_using_io_uring_backend)
+{
+    startServer(IoBackend::IoUring);
+    expectStaticFileResponse();
+}
+
+TEST_F(HttpServerTest, run_should_keep_serving_after_client_resets_during_file_body_when_using_io_uring_backend)
+{
+    startServer(IoBackend::IoUring);
+    expectClientResetDuringFileBody();
+}
+
+TEST_F(HttpServerTest, run_should_drop_connection_when_reader_stalls_past_deadline_using_io_uring_backend)
+{
+    expectStalledReaderDropped(IoBackend::IoUring);
+}
+
+TEST_F(HttpServerTest, run_should_serve_many_concurrent_connections_when_using_io_uring_backend)
+{
+    startServer(IoBackend::IoUring);
+
+    std::vector<int> clients;
+    for (int i = 0; i < 64; ++i)
+    {
+        int fd = connectClient();
+        ASSERT_GE(fd, 0);
+        clients.push_back(fd);
+    }
+
+    std::string request = "GET /hello HTTP/1.1\r\nConnection: close\r\n\r\n";
+    for (int fd : clients)
+        send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+
+    for (int fd : clients)
+    {
+        std::string raw_response;
+        char buffer[4096];
+        ssize_t bytes_received;
+        while ((bytes_received = recv(fd, buffer, sizeof(buffer), 0)) > 0)
+            raw_response.append(buffer, bytes_received);
+        close(fd);
+
+        EXPECT_EQ(HttpResponse::from_string(raw_response).get_body(), "Hello");
+    }
+}
+
+TEST_F(HttpServerTest, run_should_close_pending_connection_when_out_of_descriptors_using_io_uring_backend)
+{
+    expectConnectionShedWhenOutOfDescriptors(IoBackend::IoUring);
+}
+
+TEST_F(HttpServerTest, run_should_apply_socket_policy_when_using_io_uring_backend)
+{
+    expectResponsesWithSocketPolicy(IoBackend::IoUring);
+}
+
+TEST_F(HttpServerTest, run_should_time_out_slow_requests_when_using_io_uring_backend)
+{
+    expectRequestTimeouts(IoBackend::IoUring);
+}
+
+TEST_F(HttpServerTest, drain_should_finish_started_requests_before_run_returns_when_using_io_uring_backend)
+{
+    expectGracefulDrain(IoBackend::IoUring);
+}
+
+TEST_F(HttpServerTest, run_should_shed_requests_with_service_unavailable_when_queue_is_full_using_io_uring_backend)
+{
+    expectOverloadShedding(IoBackend::IoUring);
+}
+
+TEST_F(HttpServerTest, run_should_serve_requests_over_unix_socket_when_using_io_uring_backend)
+{
+    expectUnixSocketResponses(IoBackend::IoUring);
+}
+
+TEST_F(HttpServerTest, run_should_answer_pipelined_requests_beyond_output_high_water_mark_when_using_io_uring_backend)
+{
+    expectPipelinedResponsesBeyondHighWaterMark(IoBackend::IoUring);
+}
+
+TEST_F(HttpServerTest, run_should_throttle_client_flooding_a_busy_connection_when_using_io_uring_backend)
+{
+    expectFloodThrottled(IoBackend::IoUring);
+}
+
+TEST_F(HttpServerTest, run_should_serve_requests_on_configured_thread_topology_when_using_io_uring_backend)
+{
+    expectThreadTopology(IoBackend::IoUring);
+}
+
+TEST_F(HttpServerTest, run_should_run_coroutine_handlers_without_holding_workers_when_using_io_uring_backend)
+{
+    expectAsyncHandlers(IoBackend::IoUring);
+}
+
+TEST_F(HttpServerTest, run_should_record_shed_request_of_async_batch_when_using_io_uring_backend)
+{
+    expectShedAsyncBatchRecorded(IoBackend::IoUring);
+}
+
+TEST_F(HttpServerTest, run_should_record_sampled_requests_in_access_log_when_using_io_uring_backend)
+{
+    expectAccessLog(IoBackend::IoUring);
+}
+
+TEST_F(HttpServerTest, run_should_run_handlers_where_their_route_policy_says_when_using_io_uring_backend)
+{
+    expectExecutionPolicies(IoBackend::IoUring);
+}
+#endif
+
+// Tests for the blocking backend
+TEST_F(HttpServerTest, run_should_serve_request_when_using_blocking_backend)
+{
+    startServer(IoBackend::Blocking);
+
+    HttpResponse response = HttpResponse::from_string(exchange("GET /hello HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n"));
+
+    EXPECT_EQ(response.get_code(), HttpCode::OK);
+    EXPECT_EQ(response.get_body(), "Hello");
+}
+
+TEST_F(HttpServerTest, run_should_keep_connection_open_when_using_blocking_backend)
+{
+    startServer(IoBackend::Blocking);
+    expectPersistentConnection();
+}
+
+TEST_F(HttpServerTest, run_should_answer_pipelined_requests_in_order_when_using_blocking_backend)
+{
+    startServer(IoBackend::Blocking);
+    expectPipelinedResponses();
+}
+
+TEST_F(HttpServerTest, run_should_receive_large_post_body_when_using_blocking_backend)
+{
+    startServer(IoBackend::Blocking);
+
+    std::string body(200 * 1024, 'p');
+    HttpResponse response = HttpResponse::from_string(
+        exchange("POST /echo HTTP/1.1\r\nConnection: close\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body));
+
+    EXPECT_EQ(response.get_body(), body);
+}
+
+TEST_F(HttpServerTest, run_should_stream_chunked_response_before_pipelined_response_when_using_blocking_backend)
+{
+    startServer(IoBackend::Blocking);
+    expectStreamedResponse();
+}
+
+TEST_F(HttpServerTest, run_should_send_static_file_from_descriptor_when_using_blocking_backend)
+{
+    startServer(IoBackend::Blocking);
+    expectStaticFileResponse();
+}
+
+TEST_F(HttpServerTest, run_should_keep_serving_after_client_resets_during_file_body_when_using_blocking_backend)
+{
+    startServer(IoBackend::Blocking);
+    expectClientResetDuringFileBody();
+}
+
+TEST_F(HttpServerTest, serve_static_file_should_return_forbidden_when_path_escapes_web_root)
+{
+    startServer(IoBackend::Epoll);
+    writeStaticFile("inside.txt", "inside");
+
+    EXPECT_EQ(server->serve_static_file("../inside.txt", (web_root / "sub").string()).get_code(), HttpCode::Forbidden);
+    EXPECT_EQ(server->serve_static_file("inside.txt", web_root.string()).get_body_file()->get_size(), 6u);
+}
+
+TEST_F(HttpServerTest, run_should_drop_connection_when_reader_stalls_past_deadline_using_blocking_backend)
+{
+    expectStalledReaderDropped(IoBackend::Blocking);
+}
+
+TEST_F(HttpServerTest, run_should_close_pending_connection_when_out_of_descriptors_using_blocking_backend)
+{
+    expectConnectionShedWhenOutOfDescriptors(IoBackend::Blocking);
+}
+
+TEST_F(HttpServerTest, run_should_serve_many_concurrent_connections_when_using_blocking_backend)
+{
+    startServer(IoBackend::Blocking);
+
+    expectConcurrentResponses(64);
+}
+
+TEST_F(HttpServerTest, run_should_apply_socket_policy_when_using_blocking_backend)
+{
+    expectResponsesWithSocketPolicy(IoBackend::Blocking);
+}
+
+TEST_F(HttpServerTest, run_should_time_out_slow_requests_when_using_blocking_backend)
+{
+    expectRequestTimeouts(IoBackend::Blocking);
+}
+
+TEST_F(HttpServerTest, drain_should_finish_started_requests_before_run_returns_when_using_blocking_backend)
+{
+    expectGracefulDrain(IoBackend::Blocking);
+}
+
+TEST_F(HttpServerTest, run_should_shed_requests_with_service_unavailable_when_queue_is_full_using_blocking_backend)
+{
+    expectOverloadShedding(IoBackend::Blocking);
+}
+
+TEST_F(HttpServerTest, run_should_serve_requests_over_unix_socket_when_using_blocking_backend)
+{
+    expectUnixSocketResponses(IoBackend::Blocking);
+}
+
+TEST_F(HttpServerTest, run_should_serve_requests_on_configured_thread_topology_when_using_blocking_backend)
+{
+    expectThreadTopology(IoBackend::Blocking);
+}
+
+TEST_F(HttpServerTest, run_should_run_coroutine_handlers_to_completion_when_using_blocking_backend)
+{
+    expectAsyncHandlers(IoBackend::Blocking);
+}
+
+TEST_F(HttpServerTest, run_should_record_sampled_requests_in_access_log_when_using_blocking_backend)
+{
+    expectAccessLog(IoBackend::Blocking);
+}
+
+// Tests for stop
+TEST_F(HttpServerTest, stop_should_make_run_return_when_server_is_running)
+{
+    startServer(IoBackend::Epoll);
+
+    server->stop();
+    server_thread.join();
+
+    EXPECT_FALSE(server->is_running());
+}
+
+#endif // __linux__
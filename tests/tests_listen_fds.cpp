@@ -0,0 +1,102 @@
+#ifndef _WIN32
+
+#include <gtest/gtest.h>
+#include "server/listen_fds.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+class ListenFdsTest : public ::testing::Test
+{
+protected:
+    void TearDown() override
+    {
+        unsetenv("LISTEN_PID");
+        unsetenv("LISTEN_FDS");
+    }
+
+    // Helper method to open a listening socket on an ephemeral loopback port
+    SocketWrapper openListener()
+    {
+        SocketWrapper listener(socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0));
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(listener.get(), reinterpret_cast<sockaddr *>(&address), sizeof(address));
+        listen(listener.get(), 16);
+
+        return listener;
+    }
+
+    // Helper method to run a shell script with the listeners and return its exit status
+    int spawnScript(const std::string &script, const std::vector<socket_t> &listeners)
+    {
+        char shell[] = "/bin/sh";
+        char flag[] = "-c";
+        std::string command = script;
+        char *const argv[] = {shell, flag, command.data(), nullptr};
+
+        pid_t pid = spawn_with_listen_fds(shell, argv, listeners);
+        if (pid < 0)
+            return -1;
+
+        int status = 0;
+        waitpid(pid, &status, 0);
+        return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    }
+};
+
+// Tests for take_listen_fds
+TEST_F(ListenFdsTest, take_listen_fds_should_return_nothing_when_sockets_are_for_another_process)
+{
+    setenv("LISTEN_PID", std::to_string(getpid() + 1).c_str(), 1);
+    setenv("LISTEN_FDS", "1", 1);
+
+    EXPECT_TRUE(take_listen_fds().empty());
+    EXPECT_EQ(getenv("LISTEN_PID"), nullptr);
+    EXPECT_EQ(getenv("LISTEN_FDS"), nullptr);
+}
+
+TEST_F(ListenFdsTest, take_listen_fds_should_return_nothing_when_no_sockets_were_passed)
+{
+    EXPECT_TRUE(take_listen_fds().empty());
+}
+
+// Tests for spawn_with_listen_fds
+TEST_F(ListenFdsTest, spawn_with_listen_fds_should_pass_listeners_from_descriptor_3_when_child_starts)
+{
+    SocketWrapper first = openListener();
+    SocketWrapper second = openListener();
+
+    std::string script = "test \"$LISTEN_PID\" = $$ && test \"$LISTEN_FDS\" = 2 && "
+                         "test -S /proc/$$/fd/3 && test -S /proc/$$/fd/4";
+
+    EXPECT_EQ(spawnScript(script, {first.get(), second.get()}), 0);
+}
+
+TEST_F(ListenFdsTest, spawn_with_listen_fds_should_replace_inherited_variables_when_already_set)
+{
+    SocketWrapper listener = openListener();
+    setenv("LISTEN_PID", "1", 1);
+    setenv("LISTEN_FDS", "7", 1);
+
+    EXPECT_EQ(spawnScript("test \"$LISTEN_PID\" = $$ && test \"$LISTEN_FDS\" = 1", {listener.get()}), 0);
+}
+
+TEST_F(ListenFdsTest, spawn_with_listen_fds_should_fail_when_program_cannot_be_executed)
+{
+    SocketWrapper listener = openListener();
+    char program[] = "/nonexistent/http-server";
+    char *const argv[] = {program, nullptr};
+
+    EXPECT_EQ(spawn_with_listen_fds(program, argv, {listener.get()}), -1);
+    EXPECT_EQ(errno, ENOENT);
+}
+
+#endif
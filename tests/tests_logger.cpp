@@ -0,0 +1,250 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "server/logger.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+class LoggerTest : public ::testing::Test
+{
+protected:
+    FILE *output = nullptr;
+    FILE *errors = nullptr;
+    LogPolicy policy;
+
+    void SetUp() override
+    {
+        output = std::tmpfile();
+        errors = std::tmpfile();
+        // Only flush() writes, so tests see exactly what was queued.
+        policy.flush_interval = std::chrono::hours(1);
+    }
+
+    void TearDown() override
+    {
+        std::fclose(output);
+        std::fclose(errors);
+    }
+
+    // Helper method to read everything written to a stream so far
+    static std::string readAll(FILE *stream)
+    {
+        std::string content;
+        std::rewind(stream);
+        char buffer[4096];
+        size_t bytes;
+        while ((bytes = std::fread(buffer, 1, sizeof(buffer), stream)) > 0)
+            content.append(buffer, bytes);
+        return content;
+    }
+};
+
+// Tests for levels and streams
+TEST_F(LoggerTest, flush_should_write_lines_in_order_when_logged_from_one_thread)
+{
+    Logger logger(policy, output, errors);
+
+    logger.info() << "first " << 1;
+    logger.info() << "second " << 2.5 << ' ' << std::string("end");
+    logger.flush();
+
+    EXPECT_EQ(readAll(output), "first 1\nsecond 2.5 end\n");
+    EXPECT_EQ(readAll(errors), "");
+}
+
+TEST_F(LoggerTest, flush_should_send_warnings_and_errors_to_error_stream)
+{
+    Logger logger(policy, output, errors);
+
+    logger.warning() << "careful";
+    logger.error() << "failed";
+    logger.flush();
+
+    EXPECT_EQ(readAll(output), "");
+    EXPECT_EQ(readAll(errors), "careful\nfailed\n");
+}
+
+TEST_F(LoggerTest, info_should_be_skipped_when_level_is_higher)
+{
+    policy.level = LogLevel::Warning;
+    Logger logger(policy, output, errors);
+
+    logger.debug() << "debug";
+    logger.info() << "info";
+    logger.error() << "error";
+    logger.flush();
+
+    EXPECT_FALSE(logger.is_enabled(LogLevel::Info));
+    EXPECT_TRUE(logger.is_enabled(LogLevel::Error));
+    EXPECT_EQ(readAll(output), "");
+    EXPECT_EQ(readAll(errors), "error\n");
+}
+
+TEST_F(LoggerTest, configure_should_change_level_when_called)
+{
+    Logger logger(policy, output, errors);
+
+    logger.debug() << "hidden";
+    policy.level = LogLevel::Debug;
+    logger.configure(policy);
+    logger.debug() << "shown";
+    logger.flush();
+
+    EXPECT_EQ(readAll(output), "shown\n");
+}
+
+// Tests for line limits
+TEST_F(LoggerTest, flush_should_truncate_line_when_longer_than_line_size)
+{
+    Logger logger(policy, output, errors);
+
+    logger.info() << std::string(Logger::line_size * 2, 'x') << "tail";
+    logger.flush();
+
+    std::string written = readAll(output);
+    EXPECT_EQ(written.size(), Logger::line_size + 1);
+    EXPECT_EQ(written.substr(Logger::line_size - 4), "x...\n");
+}
+
+TEST_F(LoggerTest, info_should_drop_and_count_lines_when_ring_is_full)
+{
+    policy.ring_lines = 4;
+    Logger logger(policy, output, errors);
+
+    for (int i = 0; i < 10; ++i)
+        logger.info() << "line " << i;
+    logger.flush();
+
+    EXPECT_EQ(logger.get_dropped_count(), 6u);
+    EXPECT_EQ(readAll(output), "line 0\nline 1\nline 2\nline 3\n");
+    EXPECT_EQ(readAll(errors), "Dropped 6 log line(s)\n");
+}
+
+// Tests for rate limiting
+TEST_F(LoggerTest, error_should_suppress_repeats_from_one_place_when_burst_is_exceeded)
+{
+    policy.repeat_burst = 3;
+    policy.repeat_interval = std::chrono::milliseconds(50);
+    Logger logger(policy, output, errors);
+
+    auto log_failure = [&logger](int i)
+    { logger.error() << "failure " << i; };
+
+    for (int i = 0; i < 10; ++i)
+        log_failure(i);
+    logger.info() << "unrelated";
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    log_failure(10);
+    logger.flush();
+
+    EXPECT_EQ(logger.get_suppressed_count(), 7u);
+    EXPECT_EQ(readAll(errors), "failure 0\nfailure 1\nfailure 2\nfailure 10 (7 similar lines suppressed)\n");
+    EXPECT_EQ(readAll(output), "unrelated\n");
+}
+
+// Tests for concurrent producers
+TEST_F(LoggerTest, writer_should_keep_each_threads_order_when_threads_log_concurrently)
+{
+    policy.flush_interval = std::chrono::milliseconds(1);
+    Logger logger(policy, output, errors);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&logger, t]
+                             {
+                                 for (int i = 0; i < 500; ++i)
+                                     logger.info() << t << ' ' << i; });
+    }
+    for (std::thread &thread : threads)
+        thread.join();
+    logger.flush();
+
+    std::vector<int> next(4, 0);
+    std::string written = readAll(output);
+    size_t lines = 0;
+    for (size_t start = 0, end; (end = written.find('\n', start)) != std::string::npos; start = end + 1)
+    {
+        int t = written[start] - '0';
+        ASSERT_EQ(std::stoi(written.substr(start + 2, end - start - 2)), next[t]);
+        ++next[t];
+        ++lines;
+    }
+
+    EXPECT_EQ(lines, 2000u);
+    EXPECT_EQ(logger.get_dropped_count(), 0u);
+}
+
+TEST_F(LoggerTest, info_should_keep_one_ring_per_thread_when_thread_alternates_loggers)
+{
+    FILE *other_output = std::tmpfile();
+    {
+        Logger logger(policy, output, errors);
+        Logger other(policy, other_output, errors);
+
+        for (int i = 0; i < 100; ++i)
+        {
+            logger.info() << "first " << i;
+            other.info() << "second " << i;
+        }
+        logger.flush();
+        other.flush();
+
+        EXPECT_EQ(logger.get_ring_count(), 1u);
+        EXPECT_EQ(other.get_ring_count(), 1u);
+        EXPECT_EQ(logger.get_dropped_count(), 0u);
+        EXPECT_EQ(other.get_dropped_count(), 0u);
+        EXPECT_EQ(readAll(other_output).substr(0, 18), "second 0\nsecond 1\n");
+    }
+    std::fclose(other_output);
+}
+
+TEST_F(LoggerTest, flush_should_free_rings_of_exited_threads_once_written)
+{
+    Logger logger(policy, output, errors);
+
+    for (int t = 0; t < 8; ++t)
+    {
+        std::thread([&logger, t]
+                    { logger.info() << "thread " << t; })
+            .join();
+    }
+    EXPECT_EQ(logger.get_ring_count(), 8u);
+
+    logger.flush();
+
+    EXPECT_EQ(logger.get_ring_count(), 0u);
+    EXPECT_EQ(readAll(output), "thread 0\nthread 1\nthread 2\nthread 3\nthread 4\nthread 5\nthread 6\nthread 7\n");
+}
+
+TEST_F(LoggerTest, configure_should_apply_repeat_limit_when_thread_is_logging)
+{
+    policy.repeat_burst = 200;
+    Logger logger(policy, output, errors);
+
+    std::atomic<bool> done{false};
+    std::thread producer([&logger, &done]
+                         {
+                             while (!done)
+                             {
+                                 logger.error() << "repeated";
+                                 std::this_thread::yield();
+                             } });
+
+    for (size_t burst = 199; burst >= 1; --burst)
+    {
+        policy.repeat_burst = burst;
+        logger.configure(policy);
+    }
+    while (logger.get_suppressed_count() == 0)
+        std::this_thread::yield();
+    done = true;
+    producer.join();
+    logger.flush();
+
+    EXPECT_EQ(logger.get_dropped_count(), 0u);
+}
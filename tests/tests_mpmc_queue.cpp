@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include "server/mpmc_queue.hpp"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+class MpmcQueueTest : public ::testing::Test
+{
+protected:
+    // Helper method to push count values from each of producers threads while
+    // consumers threads pop them, returning the sum of everything popped
+    uint64_t pushAndPopConcurrently(MpmcQueue<uint64_t> &queue, size_t producers, size_t consumers, uint64_t count)
+    {
+        std::atomic<uint64_t> popped{0};
+        std::atomic<uint64_t> sum{0};
+        std::vector<std::thread> threads;
+
+        for (size_t p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&queue, count]
+                                 {
+                                     for (uint64_t i = 1; i <= count; ++i)
+                                     {
+                                         uint64_t value = i;
+                                         while (!queue.try_push(value))
+                                             std::this_thread::yield();
+                                     } });
+        }
+
+        for (size_t c = 0; c < consumers; ++c)
+        {
+            threads.emplace_back([&, total = producers * count]
+                                 {
+                                     uint64_t value;
+                                     while (popped < total)
+                                     {
+                                         if (queue.try_pop(value))
+                                         {
+                                             sum += value;
+                                             ++popped;
+                                         }
+                                         else
+                                         {
+                                             std::this_thread::yield();
+                                         }
+                                     } });
+        }
+
+        for (auto &thread : threads)
+            thread.join();
+
+        return sum;
+    }
+};
+
+// Tests for try_push and try_pop
+TEST_F(MpmcQueueTest, try_pop_should_return_values_in_push_order_when_single_threaded)
+{
+    MpmcQueue<int> queue(8);
+
+    for (int i = 0; i < 5; ++i)
+    {
+        int value = i;
+        ASSERT_TRUE(queue.try_push(value));
+    }
+
+    for (int i = 0; i < 5; ++i)
+    {
+        int value = -1;
+        ASSERT_TRUE(queue.try_pop(value));
+        EXPECT_EQ(value, i);
+    }
+}
+
+TEST_F(MpmcQueueTest, try_pop_should_fail_when_queue_is_empty)
+{
+    MpmcQueue<int> queue(4);
+    int value = 7;
+
+    EXPECT_FALSE(queue.try_pop(value));
+    EXPECT_EQ(value, 7);
+}
+
+TEST_F(MpmcQueueTest, try_push_should_fail_without_moving_value_when_queue_is_full)
+{
+    MpmcQueue<std::unique_ptr<int>> queue(2);
+    auto first = std::make_unique<int>(1);
+    auto second = std::make_unique<int>(2);
+    auto third = std::make_unique<int>(3);
+
+    ASSERT_TRUE(queue.try_push(first));
+    ASSERT_TRUE(queue.try_push(second));
+    EXPECT_FALSE(queue.try_push(third));
+    ASSERT_NE(third, nullptr);
+    EXPECT_EQ(*third, 3);
+}
+
+TEST_F(MpmcQueueTest, try_push_should_reuse_cells_when_queue_wraps_around)
+{
+    MpmcQueue<int> queue(4);
+
+    for (int i = 0; i < 100; ++i)
+    {
+        int value = i;
+        ASSERT_TRUE(queue.try_push(value));
+        ASSERT_TRUE(queue.try_pop(value));
+        EXPECT_EQ(value, i);
+    }
+
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(MpmcQueueTest, try_pop_should_deliver_every_value_once_when_threads_contend)
+{
+    MpmcQueue<uint64_t> queue(64);
+    uint64_t count = 20000;
+
+    EXPECT_EQ(pushAndPopConcurrently(queue, 4, 4, count), 4 * count * (count + 1) / 2);
+    EXPECT_TRUE(queue.empty());
+}
+
+// Tests for capacity and size
+TEST_F(MpmcQueueTest, capacity_should_round_up_to_power_of_two_when_constructed)
+{
+    EXPECT_EQ(MpmcQueue<int>(1).capacity(), 2u);
+    EXPECT_EQ(MpmcQueue<int>(5).capacity(), 8u);
+    EXPECT_EQ(MpmcQueue<int>(4096).capacity(), 4096u);
+}
+
+TEST_F(MpmcQueueTest, size_should_count_queued_values_when_idle)
+{
+    MpmcQueue<int> queue(8);
+    int value = 1;
+
+    queue.try_push(value);
+    queue.try_push(value);
+    queue.try_pop(value);
+
+    EXPECT_EQ(queue.size(), 1u);
+}
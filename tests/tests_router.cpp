@@ -1,10 +1,12 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include "server/router.hpp"
+#include "server/async_io.hpp"
 #include "http/httpmethod.hpp"
 #include "http/httpcode.hpp"
 #include "http/httprequest.hpp"
 #include "http/httpresponse.hpp"
+#include <chrono>
 #include <stdexcept>
 
 class RouterTest : public ::testing::Test
@@ -408,6 +410,106 @@ TEST_F(RouterTest, handle_request_should_support_complex_regex_patterns_when_usi
     EXPECT_EQ(response3.get_code(), HttpCode::NotFound);
 }
 
+// Tests for streaming routes
+TEST_F(RouterTest, open_body_sink_should_return_sink_when_streaming_route_matches)
+{
+    std::string received;
+    router->add_streaming_route(
+        HttpMethod::POST, "/upload/.*",
+        [&received](const HttpRequest &) -> BodySink
+        { return [&received](const char *data, size_t length)
+          { received.append(data, length); }; },
+        [](const HttpRequest &) -> HttpResponse
+        { return HttpResponse(); });
+
+    BodySink sink = router->open_body_sink(createRequest(HttpMethod::POST, "/upload/file"));
+    ASSERT_TRUE(sink);
+    sink("abc", 3);
+
+    EXPECT_EQ(received, "abc");
+    EXPECT_FALSE(router->open_body_sink(createRequest(HttpMethod::GET, "/upload/file")));
+    EXPECT_FALSE(router->open_body_sink(createRequest(HttpMethod::POST, "/other")));
+    EXPECT_EQ(router->handle_request(createRequest(HttpMethod::POST, "/upload/file")).get_code(), HttpCode::OK);
+}
+
+// Tests for async routes
+TEST_F(RouterTest, handle_request_should_run_async_handler_to_completion_when_route_is_async)
+{
+    router->get("/async", [](const HttpRequest &) -> Async<HttpResponse>
+                {
+                    co_await sleep_for(std::chrono::milliseconds(1));
+                    HttpResponse response;
+                    response.set_body("Async");
+                    co_return response; });
+
+    HttpRequest request = createRequest(HttpMethod::GET, "/async");
+    HttpResponse response = router->handle_request(request);
+
+    EXPECT_EQ(response.get_code(), HttpCode::OK);
+    EXPECT_EQ(response.get_body(), "Async");
+}
+
+TEST_F(RouterTest, is_async_should_report_only_async_routes)
+{
+    router->get("/sync", createSimpleHandler("Sync"));
+    router->get("/async", [](const HttpRequest &) -> Async<HttpResponse>
+                { co_return HttpResponse(); });
+
+    EXPECT_TRUE(router->is_async(createRequest(HttpMethod::GET, "/async")));
+    EXPECT_FALSE(router->is_async(createRequest(HttpMethod::GET, "/sync")));
+    EXPECT_FALSE(router->is_async(createRequest(HttpMethod::POST, "/async")));
+    EXPECT_FALSE(router->is_async(createRequest(HttpMethod::GET, "/missing")));
+}
+
+TEST_F(RouterTest, handle_request_async_should_answer_sync_and_unrouted_requests_when_awaited)
+{
+    router->get("/sync", createSimpleHandler("Sync"));
+
+    HttpRequest request = createRequest(HttpMethod::GET, "/sync");
+    HttpResponse response = sync_wait(router->handle_request_async(request));
+    HttpRequest missing = createRequest(HttpMethod::GET, "/missing");
+
+    EXPECT_EQ(response.get_body(), "Sync");
+    EXPECT_EQ(sync_wait(router->handle_request_async(missing)).get_code(), HttpCode::NotFound);
+}
+
+TEST_F(RouterTest, handle_request_async_should_return_500_when_async_handler_throws)
+{
+    router->get("/error", [](const HttpRequest &) -> Async<HttpResponse>
+                {
+                    co_await sleep_for(std::chrono::milliseconds(1));
+                    throw std::runtime_error("Handler error");
+                    co_return HttpResponse(); });
+
+    HttpRequest request = createRequest(HttpMethod::GET, "/error");
+
+    EXPECT_EQ(sync_wait(router->handle_request_async(request)).get_code(), HttpCode::InternalServerError);
+    EXPECT_EQ(router->handle_request(request).get_code(), HttpCode::InternalServerError);
+}
+
+// Tests for execution policies
+TEST_F(RouterTest, get_execution_policy_should_return_route_policy_when_route_matches)
+{
+    auto handler = [](const HttpRequest &) -> HttpResponse
+    { return HttpResponse(); };
+    router->get("/health", handler, ExecutionPolicy::Inline);
+    router->post("/upload", handler, ExecutionPolicy::Blocking);
+    router->get("/users", handler);
+
+    EXPECT_EQ(router->get_execution_policy(createRequest(HttpMethod::GET, "/health")), ExecutionPolicy::Inline);
+    EXPECT_EQ(router->get_execution_policy(createRequest(HttpMethod::POST, "/upload")), ExecutionPolicy::Blocking);
+    EXPECT_EQ(router->get_execution_policy(createRequest(HttpMethod::GET, "/users")), ExecutionPolicy::Worker);
+}
+
+TEST_F(RouterTest, get_execution_policy_should_return_worker_when_request_is_unrouted)
+{
+    router->get("/health", [](const HttpRequest &) -> HttpResponse
+                { return HttpResponse(); }, ExecutionPolicy::Inline);
+
+    EXPECT_EQ(router->get_execution_policy(createRequest(HttpMethod::GET, "/missing")), ExecutionPolicy::Worker);
+    EXPECT_EQ(router->get_execution_policy(createRequest(HttpMethod::POST, "/health")), ExecutionPolicy::Worker);
+}
+
 // Integration tests
 TEST_F(RouterTest, Router_should_handle_multiple_different_routes_when_complex_routing_setup)
 {
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include "server/task.hpp"
+#include <array>
+#include <memory>
+#include <utility>
+
+class TaskTest : public ::testing::Test
+{
+};
+
+// Tests for construction and invocation
+TEST_F(TaskTest, task_should_be_empty_when_default_constructed)
+{
+    Task task;
+    Task null_task = nullptr;
+
+    EXPECT_FALSE(task);
+    EXPECT_FALSE(null_task);
+}
+
+TEST_F(TaskTest, task_should_run_callable_when_invoked)
+{
+    int calls = 0;
+    Task task([&calls]
+              { ++calls; });
+
+    ASSERT_TRUE(task);
+    task();
+    task();
+    EXPECT_EQ(calls, 2);
+}
+
+TEST_F(TaskTest, task_should_accept_move_only_captures_when_constructed)
+{
+    auto value = std::make_unique<int>(5);
+    int seen = 0;
+    Task task([&seen, value = std::move(value)]
+              { seen = *value; });
+
+    task();
+    EXPECT_EQ(seen, 5);
+}
+
+TEST_F(TaskTest, task_should_run_callable_when_larger_than_inline_storage)
+{
+    std::array<char, Task::inline_size * 2> payload{};
+    payload.back() = 'x';
+    char seen = 0;
+    Task task([&seen, payload]
+              { seen = payload.back(); });
+
+    Task moved = std::move(task);
+    moved();
+    EXPECT_EQ(seen, 'x');
+}
+
+// Tests for move and reset
+TEST_F(TaskTest, task_should_leave_source_empty_when_moved)
+{
+    int calls = 0;
+    Task task([&calls]
+              { ++calls; });
+
+    Task moved = std::move(task);
+    EXPECT_FALSE(task);
+    ASSERT_TRUE(moved);
+
+    moved();
+    EXPECT_EQ(calls, 1);
+}
+
+TEST_F(TaskTest, reset_should_destroy_captures_once_when_called)
+{
+    auto counter = std::make_shared<int>(0);
+    Task task([counter] {});
+    EXPECT_EQ(counter.use_count(), 2);
+
+    Task moved = std::move(task);
+    EXPECT_EQ(counter.use_count(), 2);
+
+    moved.reset();
+    EXPECT_FALSE(moved);
+    EXPECT_EQ(counter.use_count(), 1);
+}
+
+TEST_F(TaskTest, task_should_destroy_previous_callable_when_assigned)
+{
+    auto first = std::make_shared<int>(1);
+    Task task([first] {});
+
+    task = Task([] {});
+    EXPECT_EQ(first.use_count(), 1);
+}
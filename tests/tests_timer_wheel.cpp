@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "server/timer_wheel.hpp"
+#include <chrono>
+#include <memory>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+class TimerWheelTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+    }
+
+    void TearDown() override
+    {
+    }
+
+    // Advances the wheel to start + elapsed and returns the owners of the timers that expired
+    std::vector<uint64_t> advanceTo(TimerWheel &wheel, std::chrono::milliseconds elapsed)
+    {
+        std::vector<uint64_t> expired;
+        wheel.advance(start + elapsed, [&expired](TimerWheel::Timer &timer)
+                      { expired.push_back(timer.get_owner()); });
+        return expired;
+    }
+
+    TimerWheel::clock::time_point start = TimerWheel::clock::now();
+};
+
+// Tests for schedule and advance
+TEST_F(TimerWheelTest, advance_should_expire_timers_in_deadline_order_when_deadlines_pass)
+{
+    TimerWheel wheel(10ms, start);
+    TimerWheel::Timer first(1), second(2), third(3);
+
+    wheel.schedule(third, start + 300ms);
+    wheel.schedule(first, start + 50ms);
+    wheel.schedule(second, start + 120ms);
+
+    EXPECT_TRUE(advanceTo(wheel, 40ms).empty());
+    EXPECT_THAT(advanceTo(wheel, 200ms), ::testing::ElementsAre(1, 2));
+    EXPECT_THAT(advanceTo(wheel, 300ms), ::testing::ElementsAre(3));
+    EXPECT_EQ(wheel.size(), 0u);
+    EXPECT_FALSE(third.is_scheduled());
+}
+
+TEST_F(TimerWheelTest, advance_should_cascade_timer_when_deadline_is_beyond_first_level)
+{
+    TimerWheel wheel(1ms, start);
+    TimerWheel::Timer near(1), far(2);
+
+    wheel.schedule(far, start + 300000ms);
+    wheel.schedule(near, start + 5000ms);
+
+    EXPECT_THAT(advanceTo(wheel, 4999ms), ::testing::IsEmpty());
+    EXPECT_THAT(advanceTo(wheel, 5000ms), ::testing::ElementsAre(1));
+    EXPECT_THAT(advanceTo(wheel, 299999ms), ::testing::IsEmpty());
+    EXPECT_THAT(advanceTo(wheel, 300000ms), ::testing::ElementsAre(2));
+}
+
+TEST_F(TimerWheelTest, schedule_should_move_timer_when_already_scheduled)
+{
+    TimerWheel wheel(10ms, start);
+    TimerWheel::Timer timer(7);
+
+    wheel.schedule(timer, start + 50ms);
+    wheel.schedule(timer, start + 500ms);
+
+    EXPECT_EQ(wheel.size(), 1u);
+    EXPECT_THAT(advanceTo(wheel, 100ms), ::testing::IsEmpty());
+    EXPECT_THAT(advanceTo(wheel, 500ms), ::testing::ElementsAre(7));
+}
+
+TEST_F(TimerWheelTest, schedule_should_expire_on_next_tick_when_deadline_has_passed)
+{
+    TimerWheel wheel(10ms, start);
+    TimerWheel::Timer timer(1);
+
+    advanceTo(wheel, 100ms);
+    wheel.schedule(timer, start);
+
+    EXPECT_THAT(advanceTo(wheel, 110ms), ::testing::ElementsAre(1));
+}
+
+// Tests for cancelling
+TEST_F(TimerWheelTest, cancel_should_keep_timer_from_expiring_when_scheduled)
+{
+    TimerWheel wheel(10ms, start);
+    TimerWheel::Timer timer(1);
+
+    wheel.schedule(timer, start + 50ms);
+    timer.cancel();
+
+    EXPECT_EQ(wheel.size(), 0u);
+    EXPECT_EQ(wheel.get_next_timeout_ms(start), -1);
+    EXPECT_THAT(advanceTo(wheel, 100ms), ::testing::IsEmpty());
+}
+
+TEST_F(TimerWheelTest, timer_destructor_should_unschedule_timer_when_destroyed)
+{
+    TimerWheel wheel(10ms, start);
+    auto timer = std::make_unique<TimerWheel::Timer>(1);
+
+    wheel.schedule(*timer, start + 50ms);
+    timer.reset();
+
+    EXPECT_EQ(wheel.size(), 0u);
+    EXPECT_THAT(advanceTo(wheel, 100ms), ::testing::IsEmpty());
+}
+
+TEST_F(TimerWheelTest, advance_should_allow_callback_to_reschedule_timer_when_timer_expires)
+{
+    TimerWheel wheel(10ms, start);
+    TimerWheel::Timer timer(1);
+    int expirations = 0;
+
+    wheel.schedule(timer, start + 50ms);
+    wheel.advance(start + 50ms, [&](TimerWheel::Timer &expired)
+                  {
+                      ++expirations;
+                      wheel.schedule(expired, start + 100ms); });
+
+    EXPECT_EQ(expirations, 1);
+    EXPECT_TRUE(timer.is_scheduled());
+    EXPECT_THAT(advanceTo(wheel, 100ms), ::testing::ElementsAre(1));
+}
+
+// Tests for get_next_timeout_ms
+TEST_F(TimerWheelTest, get_next_timeout_ms_should_return_time_to_earliest_timer_when_timers_scheduled)
+{
+    TimerWheel wheel(10ms, start);
+    TimerWheel::Timer first(1), second(2);
+
+    wheel.schedule(second, start + 400ms);
+    wheel.schedule(first, start + 250ms);
+
+    EXPECT_EQ(wheel.get_next_timeout_ms(start), 250);
+    EXPECT_EQ(wheel.get_next_timeout_ms(start + 100ms), 150);
+}
+
+TEST_F(TimerWheelTest, get_next_timeout_ms_should_not_exceed_deadline_when_timer_is_on_higher_level)
+{
+    TimerWheel wheel(10ms, start);
+    TimerWheel::Timer timer(1);
+
+    wheel.schedule(timer, start + 5000ms);
+
+    int timeout = wheel.get_next_timeout_ms(start);
+    EXPECT_GT(timeout, 0);
+    EXPECT_LE(timeout, 5000);
+}
@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+#include "server/cpu_topology.hpp"
+#include "server/worker_pool.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+class WorkerPoolTest : public ::testing::Test
+{
+protected:
+    std::atomic<size_t> done{0};
+
+    // Helper method to build a task that counts itself done after sleeping for delay
+    QueuedTask makeTask(std::chrono::milliseconds delay = std::chrono::milliseconds(0))
+    {
+        QueuedTask task;
+        task.run = [this, delay]
+        {
+            if (delay.count() > 0)
+                std::this_thread::sleep_for(delay);
+            ++done;
+        };
+        task.enqueued = std::chrono::steady_clock::now();
+        return task;
+    }
+
+    // Helper method to wait until every worker's counters add up to the expected total
+    uint64_t waitForExecuted(const WorkerPool &pool, uint64_t expected)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        uint64_t executed = 0;
+
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+            executed = 0;
+            for (const WorkerStats &stats : pool.get_stats())
+                executed += stats.executed;
+
+            if (executed >= expected)
+                break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return executed;
+    }
+
+    static WorkerPool::Executor runner()
+    {
+        return [](QueuedTask &task)
+        { task.run(); };
+    }
+};
+
+// Tests for push
+TEST_F(WorkerPoolTest, push_should_run_every_task_once_when_pushed_from_many_threads)
+{
+    WorkerPool pool(4, runner());
+    std::vector<std::thread> producers;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        producers.emplace_back([this, &pool]
+                               {
+                                   for (int j = 0; j < 5000; ++j)
+                                   {
+                                       QueuedTask task = makeTask();
+                                       while (!pool.push(task))
+                                           std::this_thread::yield();
+                                   } });
+    }
+
+    for (auto &producer : producers)
+        producer.join();
+
+    EXPECT_EQ(waitForExecuted(pool, 20000), 20000u);
+    EXPECT_EQ(done, 20000u);
+    EXPECT_EQ(pool.get_queued_count(), 0u);
+}
+
+TEST_F(WorkerPoolTest, push_should_refuse_task_when_every_queue_is_full)
+{
+    WorkerPool pool(2, runner(), {}, 4);
+    std::atomic<size_t> started{0};
+    std::atomic<bool> release{false};
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+        QueuedTask blocker;
+        blocker.run = [&started, &release]
+        {
+            ++started;
+            while (!release)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        };
+        pool.push_to(i, blocker);
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (started < 2 && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ASSERT_EQ(started, 2u);
+
+    size_t accepted = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        QueuedTask task = makeTask();
+        EXPECT_TRUE(pool.push_to(0, task));
+        ++accepted;
+    }
+
+    QueuedTask refused = makeTask();
+    EXPECT_FALSE(pool.push(refused));
+    EXPECT_TRUE(refused.run);
+    EXPECT_EQ(pool.get_queued_count(), accepted);
+
+    release = true;
+    EXPECT_EQ(waitForExecuted(pool, accepted + 2), accepted + 2);
+    EXPECT_EQ(done, accepted);
+}
+
+TEST_F(WorkerPoolTest, push_should_queue_tasks_for_worker_pinned_to_pushing_cpu)
+{
+    CpuSet allowed = get_allowed_cpus();
+    if (allowed.empty())
+        GTEST_SKIP() << "CPU affinity is not available";
+
+    // The pinned worker is the one a CPU number modulo the pool size would not pick.
+    int cpu = allowed.front();
+    size_t pinned = static_cast<size_t>(cpu + 1) % 2;
+    std::vector<CpuSet> cpus(2);
+    cpus[pinned] = {cpu};
+    WorkerPool pool(2, runner(), cpus);
+
+    if (pool.get_worker_cpus()[pinned] != CpuSet{cpu})
+        GTEST_SKIP() << "Workers cannot be pinned";
+
+    std::atomic<bool> started{false};
+    std::thread producer([this, &pool, &started]
+                         {
+                             while (!started)
+                                 std::this_thread::yield();
+                             for (int i = 0; i < 64; ++i)
+                             {
+                                 QueuedTask task = makeTask();
+                                 pool.push(task);
+                             } });
+    ASSERT_TRUE(set_thread_affinity(producer, {cpu}));
+    started = true;
+    producer.join();
+
+    EXPECT_EQ(waitForExecuted(pool, 64), 64u);
+
+    // Whatever the other worker ran, it took from the pinned worker's queue.
+    std::vector<WorkerStats> stats = pool.get_stats();
+    size_t other = 1 - pinned;
+    EXPECT_EQ(stats[other].stolen, stats[other].executed);
+    EXPECT_EQ(stats[pinned].stolen, 0u);
+}
+
+// Tests for stealing
+TEST_F(WorkerPoolTest, idle_workers_should_steal_when_load_is_skewed_to_one_queue)
+{
+    WorkerPool pool(4, runner());
+
+    for (int i = 0; i < 64; ++i)
+    {
+        QueuedTask task = makeTask(std::chrono::milliseconds(2));
+        pool.push_to(0, task);
+    }
+
+    EXPECT_EQ(waitForExecuted(pool, 64), 64u);
+
+    std::vector<WorkerStats> stats = pool.get_stats();
+    ASSERT_EQ(stats.size(), 4u);
+    EXPECT_EQ(stats[0].stolen, 0u);
+
+    uint64_t stolen = 0;
+    for (size_t i = 1; i < stats.size(); ++i)
+    {
+        EXPECT_EQ(stats[i].stolen, stats[i].executed);
+        stolen += stats[i].stolen;
+    }
+    EXPECT_GT(stolen, 0u);
+    EXPECT_LT(stats[0].executed, 64u);
+}
+
+// Tests for construction and shutdown
+TEST_F(WorkerPoolTest, constructor_should_start_one_worker_when_asked_for_none)
+{
+    WorkerPool pool(0, runner());
+
+    EXPECT_EQ(pool.size(), 1u);
+
+    QueuedTask task = makeTask();
+    pool.push(task);
+    EXPECT_EQ(waitForExecuted(pool, 1), 1u);
+}
+
+TEST_F(WorkerPoolTest, destructor_should_stop_parked_workers_when_pool_is_idle)
+{
+    auto start = std::chrono::steady_clock::now();
+    {
+        WorkerPool pool(8, runner());
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
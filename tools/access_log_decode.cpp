@@ -0,0 +1,54 @@
+#include "server/access_log.hpp"
+#include <cstdio>
+#include <exception>
+#include <string>
+#include <vector>
+
+// Prints the records of binary access logs written by the server, one line per
+// request, as text or as CSV with a header line. Files are read in the order
+// given, so rotated files go oldest first: access.log.2 access.log.1 access.log
+// Usage: access_log_decode [--csv] FILE...
+
+int main(int argc, char **argv)
+{
+    bool csv = false;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--csv")
+            csv = true;
+        else
+            paths.push_back(arg);
+    }
+
+    if (paths.empty())
+    {
+        std::fprintf(stderr, "Usage: %s [--csv] FILE...\n", argv[0]);
+        return 1;
+    }
+
+    if (csv)
+        std::printf("%s\n", access_record_csv_header().c_str());
+
+    int exit_code = 0;
+    for (const std::string &path : paths)
+    {
+        try
+        {
+            for (const AccessRecord &record : read_access_log(path))
+            {
+                std::string line = csv ? format_access_record_csv(record) : format_access_record(record);
+                std::printf("%s\n", line.c_str());
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::fprintf(stderr, "%s\n", e.what());
+            exit_code = 1;
+        }
+    }
+
+    return exit_code;
+}